@@ -46,6 +46,10 @@ endfunction(halide_generator_output_path)
 #   OUTPUT_TARGET_VAR is the output variable that will be set to the name of the
 #     target created by this function to invoke the generator. It is
 #     automatically added as a dependency to ordinary non-Utility cmake targets.
+#
+# If HALIDE_GENERATOR_CACHE_DIR is set, generated files are cached there, and
+# a generator that lowers to the same code as before reuses its cached files
+# instead of being compiled again.
 
 function(halide_add_generator_dependency)
 
@@ -71,6 +75,10 @@ function(halide_add_generator_dependency)
   endif()
 
   set(invoke_args "-g" "${args_GENERATOR_NAME}" "-f" "${args_GENERATED_FUNCTION}" "-o" "${SCRATCH_DIR}" ${args_GENERATOR_ARGS})
+  if (HALIDE_GENERATOR_CACHE_DIR)
+    file(MAKE_DIRECTORY "${HALIDE_GENERATOR_CACHE_DIR}")
+    list(APPEND invoke_args "-c" "${HALIDE_GENERATOR_CACHE_DIR}")
+  endif()
   set(generator_exec ${args_GENERATOR_TARGET}${CMAKE_EXECUTABLE_SUFFIX})
 
   # Add a custom target to invoke the GENERATOR_TARGET and output the Halide
@@ -190,6 +190,23 @@ Image<uint16_t> blur_halide(Image<uint16_t> in) {
     return out;
 }
 
+extern "C" {
+#include "halide_blur_auto.h"
+}
+
+Image<uint16_t> blur_halide_auto(Image<uint16_t> in) {
+    Image<uint16_t> out(in.width()-8, in.height()-2);
+
+    // Call it once to initialize the halide runtime stuff
+    halide_blur_auto(in, out);
+
+    t = benchmark(10, 1, [&]() {
+        halide_blur_auto(in, out);
+    });
+
+    return out;
+}
+
 int main(int argc, char **argv) {
 
     Image<uint16_t> input(6408, 4802);
@@ -212,13 +229,18 @@ int main(int argc, char **argv) {
     Image<uint16_t> halide = blur_halide(input);
     double halide_time = t;
 
+    Image<uint16_t> halide_auto = blur_halide_auto(input);
+    double halide_auto_time = t;
+
     // fast_time2 is always slower than fast_time, so skip printing it
     printf("times: %f %f %f\n", slow_time, fast_time, halide_time);
+    printf("auto scheduled halide: %f (%.2fx the hand schedule)\n",
+           halide_auto_time, halide_auto_time / halide_time);
 
     for (int y = 64; y < input.height() - 64; y++) {
         for (int x = 64; x < input.width() - 64; x++) {
-            if (blurry(x, y) != speedy(x, y) || blurry(x, y) != halide(x, y))
-                printf("difference at (%d,%d): %d %d %d\n", x, y, blurry(x, y), speedy(x, y), halide(x, y));
+            if (blurry(x, y) != speedy(x, y) || blurry(x, y) != halide(x, y) || blurry(x, y) != halide_auto(x, y))
+                printf("difference at (%d,%d): %d %d %d %d\n", x, y, blurry(x, y), speedy(x, y), halide(x, y), halide_auto(x, y));
         }
     }
 
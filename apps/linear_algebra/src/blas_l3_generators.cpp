@@ -23,6 +23,12 @@ class GEMMGenerator :
     GeneratorParam<bool> transpose_A_ = {"transpose_A", false};
     GeneratorParam<bool> transpose_B_ = {"transpose_B", false};
 
+    // The size of the block of the output computed by the innermost
+    // (unrolled and vectorized) loops. These are tunable; see the
+    // tune target in the Makefile.
+    GeneratorParam<int>  tile_rows_ = {"tile_rows", 4, 1, 64};
+    GeneratorParam<int>  tile_cols_ = {"tile_cols", 2, 1, 64};
+
     // Standard ordering of parameters in GEMM functions.
     Param<T>   a_ = {"a", 1.0};
     ImageParam A_ = {type_of<T>(), 2, "A"};
@@ -130,33 +136,34 @@ class GEMMGenerator :
         // tail (the sum size is a whole number of vectors).  We do a
         // z-order traversal of each block expressed using nested
         // tiling.
+        const int R = tile_rows_, C = tile_cols_;
 
         result
             .specialize(sum_size == (sum_size / 8) * 8)
-            .specialize(num_rows >= 4 && num_cols >= 2)
-            .tile(i, j, ii, ji, 4, 2).vectorize(ii).unroll(ji)
-            .specialize(num_rows >= 8 && num_cols >= 8)
+            .specialize(num_rows >= R && num_cols >= C)
+            .tile(i, j, ii, ji, R, C).vectorize(ii).unroll(ji)
+            .specialize(num_rows >= 2*R && num_cols >= 4*C)
             .tile(i, j, ti[0], tj[0], i, j, 2, 4)
-            .specialize(num_rows >= 16 && num_cols >= 16)
+            .specialize(num_rows >= 4*R && num_cols >= 8*C)
             .tile(ti[0], tj[0], ti[1], tj[1], 2, 2)
-            .specialize(num_rows >= 32 && num_cols >= 32)
+            .specialize(num_rows >= 8*R && num_cols >= 16*C)
             .tile(ti[0], tj[0], ti[2], tj[2], 2, 2)
-            .specialize(num_rows >= 64 && num_cols >= 64)
+            .specialize(num_rows >= 16*R && num_cols >= 32*C)
             .fuse(tj[0], ti[0], t).parallel(t);
 
         // The general case with a tail (sum_size is not a multiple of
         // vec_size). The same z-order traversal of blocks of the
         // output.
         result
-            .specialize(num_rows >= 4 && num_cols >= 2)
-            .tile(i, j, ii, ji, 4, 2).vectorize(ii).unroll(ji)
-            .specialize(num_rows >= 8 && num_cols >= 8)
+            .specialize(num_rows >= R && num_cols >= C)
+            .tile(i, j, ii, ji, R, C).vectorize(ii).unroll(ji)
+            .specialize(num_rows >= 2*R && num_cols >= 4*C)
             .tile(i, j, ti[0], tj[0], i, j, 2, 4)
-            .specialize(num_rows >= 16 && num_cols >= 16)
+            .specialize(num_rows >= 4*R && num_cols >= 8*C)
             .tile(ti[0], tj[0], ti[1], tj[1], 2, 2)
-            .specialize(num_rows >= 32 && num_cols >= 32)
+            .specialize(num_rows >= 8*R && num_cols >= 16*C)
             .tile(ti[0], tj[0], ti[2], tj[2], 2, 2)
-            .specialize(num_rows >= 64 && num_cols >= 64)
+            .specialize(num_rows >= 16*R && num_cols >= 32*C)
             .fuse(tj[0], ti[0], t).parallel(t);
 
         dot_vecs
@@ -176,7 +183,7 @@ class GEMMGenerator :
 
             // The following stages are only vectorizable when we're
             // computing multiple dot products unrolled.
-            Expr can_vectorize = num_rows >= 4 && num_cols >= 2;
+            Expr can_vectorize = num_rows >= R && num_cols >= C;
             sum_tail.specialize(can_vectorize).fuse(i, j, t).vectorize(t);
             sum_lanes.specialize(can_vectorize).fuse(i, j, t).vectorize(t);
             sum_lanes.update().specialize(can_vectorize).fuse(i, j, t).vectorize(t);
@@ -23,6 +23,7 @@
 #include "Type.h"
 #include "Func.h"
 
+#include <algorithm>
 #include <vector>
 #include <unordered_map>
 #include <string>
@@ -261,6 +262,136 @@ boost::python::object get_type_function_wrapper()
 }
 
 
+template<typename T>
+const char *buffer_format()
+{
+    const h::Type t = h::type_of<T>();
+    if(t == h::UInt(8)) return "B";
+    if(t == h::UInt(16)) return "H";
+    if(t == h::UInt(32)) return "I";
+    if(t == h::Int(8)) return "b";
+    if(t == h::Int(16)) return "h";
+    if(t == h::Int(32)) return "i";
+    if(t == h::Float(32)) return "f";
+    if(t == h::Float(64)) return "d";
+    return NULL;
+}
+
+/// Check if the view's dimensions are laid out contiguously,
+/// with either the first (fortran order) or the last (C order) dimension varying fastest.
+bool is_contiguous(const Py_buffer *view, bool fortran_order)
+{
+    Py_ssize_t expected_stride = view->itemsize;
+    for(int i = 0; i < view->ndim; i += 1)
+    {
+        const int d = fortran_order ? i : (view->ndim - 1 - i);
+        if(view->shape[d] > 1 && view->strides[d] != expected_stride)
+        {
+            return false;
+        }
+        expected_stride *= view->shape[d];
+    }
+    return true;
+}
+
+/// Python buffer protocol, so that memoryview(image) and numpy.asarray(image)
+/// refer to the Image data without copying it. The first dimension of the view is x,
+/// like image_to_ndarray.
+template<typename T>
+int image_getbuffer(PyObject *self, Py_buffer *view, int flags)
+{
+    h::Image<T> &image = p::extract<h::Image<T> &>(self);
+    view->obj = NULL;
+
+    if(!image.defined())
+    {
+        PyErr_SetString(PyExc_BufferError, "Can't get a buffer from an undefined Image");
+        return -1;
+    }
+
+    // The data might be dirty on a device.
+    image.copy_to_host();
+
+    const buffer_t &raw_buffer = *h::Buffer(image).raw_buffer();
+    const int dimensions = std::max(image.dimensions(), 1);
+
+    // shape and strides live until the view is released
+    Py_ssize_t *shape_and_strides = new Py_ssize_t[2 * dimensions];
+    view->shape = shape_and_strides;
+    view->strides = shape_and_strides + dimensions;
+    view->ndim = dimensions;
+    view->itemsize = sizeof(T);
+    view->len = sizeof(T);
+    for(int i = 0; i < dimensions; i += 1)
+    {
+        view->shape[i] = std::max(raw_buffer.extent[i], 1);
+        view->strides[i] = raw_buffer.stride[i] * (Py_ssize_t)sizeof(T);
+        view->len *= view->shape[i];
+    }
+
+    view->buf = image.data();
+    view->readonly = 0;
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char *>(buffer_format<T>()) : NULL;
+    view->suboffsets = NULL;
+    view->internal = shape_and_strides;
+
+    // Consumers that don't handle strides expect C-contiguous data.
+    bool layout_ok = true;
+    if((flags & PyBUF_F_CONTIGUOUS) == PyBUF_F_CONTIGUOUS)
+    {
+        layout_ok = is_contiguous(view, true);
+    }
+    else if((flags & PyBUF_C_CONTIGUOUS) == PyBUF_C_CONTIGUOUS ||
+            (flags & PyBUF_STRIDES) != PyBUF_STRIDES)
+    {
+        layout_ok = is_contiguous(view, false);
+    }
+    else if((flags & PyBUF_ANY_CONTIGUOUS) == PyBUF_ANY_CONTIGUOUS)
+    {
+        layout_ok = is_contiguous(view, true) || is_contiguous(view, false);
+    }
+
+    if(!layout_ok)
+    {
+        delete[] shape_and_strides;
+        PyErr_SetString(PyExc_BufferError, "Image data does not have the memory layout requested");
+        return -1;
+    }
+
+    if((flags & PyBUF_STRIDES) != PyBUF_STRIDES)
+    {
+        view->strides = NULL;
+    }
+    if((flags & PyBUF_ND) != PyBUF_ND)
+    {
+        view->shape = NULL;
+    }
+
+    view->obj = self;
+    Py_INCREF(self);
+    return 0;
+}
+
+void image_releasebuffer(PyObject *, Py_buffer *view)
+{
+    delete[] static_cast<Py_ssize_t *>(view->internal);
+}
+
+template<typename T>
+void add_buffer_protocol(p::object image_class)
+{
+    static PyBufferProcs buffer_procs;
+    buffer_procs.bf_getbuffer = &image_getbuffer<T>;
+    buffer_procs.bf_releasebuffer = &image_releasebuffer;
+
+    PyTypeObject *type_object = reinterpret_cast<PyTypeObject *>(image_class.ptr());
+    type_object->tp_as_buffer = &buffer_procs;
+#if PY_MAJOR_VERSION < 3
+    type_object->tp_flags |= Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
+}
+
+
 template<typename T>
 void defineImage_impl(const std::string suffix, const h::Type type)
 {
@@ -446,6 +577,8 @@ void defineImage_impl(const std::string suffix, const h::Type type)
     //            return (*this)(_);
     //        }
 
+    add_buffer_protocol<T>(image_class);
+
     p::implicitly_convertible<Image<T>, h::Buffer>();
     p::implicitly_convertible<Image<T>, h::Argument>();
     p::implicitly_convertible<Image<T>, h::Expr>();
@@ -671,6 +804,60 @@ bn::dtype type_to_dtype(const h::Type &t)
 }
 
 
+h::Type dtype_to_type(const bn::dtype &t)
+{
+    const std::vector<h::Type> types =
+    {
+        h::UInt(8), h::UInt(16), h::UInt(32),
+        h::Int(8), h::Int(16), h::Int(32),
+        h::Float(32), h::Float(64)
+    };
+
+    for(const h::Type &type : types)
+    {
+        if(type_to_dtype(type) == t)
+        {
+            return type;
+        }
+    }
+
+    const std::string type_repr = p::extract<std::string>(p::str(t));
+    printf("dtype_to_type received %s\n", type_repr.c_str());
+    throw std::invalid_argument("dtype_to_type received a numpy dtype with no known Halide::Type equivalent");
+}
+
+
+/// Lets numpy arrays be passed wherever a Halide::Buffer is expected,
+/// e.g. Func.realize(array) or ImageParam.set(array).
+/// The Buffer refers to the array data (no copy), taking into account the array strides,
+/// so the array must outlive any use of the Buffer.
+struct ndarray_to_buffer_converter
+{
+    ndarray_to_buffer_converter()
+    {
+        p::converter::registry::push_back(&convertible, &construct, p::type_id<h::Buffer>());
+    }
+
+    static void *convertible(PyObject *obj)
+    {
+        p::extract<bn::ndarray> array_extract(obj);
+        return array_extract.check() ? obj : NULL;
+    }
+
+    static void construct(PyObject *obj, p::converter::rvalue_from_python_stage1_data *data)
+    {
+        bn::ndarray array = p::extract<bn::ndarray>(obj);
+        buffer_t raw_buffer = ndarray_to_buffer_t(array);
+        const h::Type t = dtype_to_type(array.get_dtype());
+
+        typedef p::converter::rvalue_from_python_storage<h::Buffer> storage_t;
+        void *storage = reinterpret_cast<storage_t *>(data)->storage.bytes;
+        new (storage) h::Buffer(t, &raw_buffer);
+        data->convertible = storage;
+    }
+};
+
+
 bn::ndarray image_to_ndarray(p::object image_object)
 {
     p::extract<h::ImageBase &> image_base_extract(image_object);
@@ -703,7 +890,7 @@ bn::ndarray image_to_ndarray(p::object image_object)
     }
 
     // numpy counts stride in bytes, while Halide counts in number of elements
-    for(size_t i = 0; i < 4; i += 1)
+    for(size_t i = 0; i < stride_array.size(); i += 1)
     {
         stride_array[i] *= raw_buffer.elem_size;
     }
@@ -893,6 +1080,8 @@ void defineImage()
            "Will take into account the array size, dimensions, and type."
            "Created Image refers to the array data (no copy).");
 
+    ndarray_to_buffer_converter();
+
     p::def("image_to_ndarray", &image_to_ndarray, p::arg("image"),
            p::with_custodian_and_ward_postcall<0, 1>(), // the image reference count is increased
            "Creates a numpy array from a Halide::Image."
@@ -270,6 +270,39 @@ def test_image_to_ndarray():
 
     return
 
+def test_realize_into_ndarray():
+
+    if "image_to_ndarray" not in globals():
+        print("Skipping test_realize_into_ndarray")
+        return
+
+    import numpy
+
+    x, y = Var('x'), Var('y')
+    f = Func('f')
+    f[x, y] = cast(Int(32), x + 10 * y)
+
+    # Realize straight into a strided view of a larger array
+    a0 = numpy.zeros((40, 30), dtype=numpy.int32)
+    a1 = a0[::2, ::3]
+    f.realize(a1)
+    assert a1[3, 4] == 3 + 10 * 4
+    assert a0[6, 12] == 3 + 10 * 4
+    assert a0[1, 0] == 0
+
+    # Images expose their data via the buffer protocol
+    i0 = Image(Int(16), 20, 10)
+    i0[5, 7] = 42
+    v0 = memoryview(i0)
+    assert v0.shape == (20, 10)
+    a2 = numpy.asarray(i0)
+    assert a2[5, 7] == 42
+    a2[6, 7] = 17
+    assert i0(6, 7) == 17
+
+    return
+
+
 def test_param_bug():
     "see https://github.com/rodrigob/Halide/issues/1"
 
@@ -297,6 +330,7 @@ if __name__ == "__main__":
     test_float_or_int()
     test_ndarray_to_image()
     test_image_to_ndarray()
+    test_realize_into_ndarray()
     test_types()
     test_operator_order()
     test_basics()
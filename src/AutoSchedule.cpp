@@ -0,0 +1,614 @@
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+
+#include "AutoSchedule.h"
+#include "Bounds.h"
+#include "Debug.h"
+#include "FindCalls.h"
+#include "Func.h"
+#include "Inline.h"
+#include "IREquality.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+#include "RealizationOrder.h"
+#include "Simplify.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+using std::ostringstream;
+
+namespace {
+
+// Constants of the cost model. Costs are in units of one arithmetic
+// operation.
+
+// The cost of storing or loading one byte of an intermediate that has
+// fallen out of cache.
+const double memory_cost_per_byte = 1.0;
+
+// The cost of a call to an extern function.
+const double extern_call_cost = 10.0;
+
+// The largest fraction of extra work we'll spend recomputing the
+// overlap between neighbouring tiles in exchange for locality.
+const double max_redundant_work = 0.15;
+
+// The size of one side of a tile.
+const int tile_size = 64;
+
+// The fewest parallel tasks worth spawning.
+const int min_parallel_tasks = 4;
+
+// Count the arithmetic and the bytes loaded to evaluate an expression once.
+class CountCost : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Add *op) {IRVisitor::visit(op); arith++;}
+    void visit(const Sub *op) {IRVisitor::visit(op); arith++;}
+    void visit(const Mul *op) {IRVisitor::visit(op); arith++;}
+    void visit(const Div *op) {IRVisitor::visit(op); arith++;}
+    void visit(const Mod *op) {IRVisitor::visit(op); arith++;}
+    void visit(const Min *op) {IRVisitor::visit(op); arith++;}
+    void visit(const Max *op) {IRVisitor::visit(op); arith++;}
+    void visit(const EQ *op) {IRVisitor::visit(op); arith++;}
+    void visit(const NE *op) {IRVisitor::visit(op); arith++;}
+    void visit(const LT *op) {IRVisitor::visit(op); arith++;}
+    void visit(const LE *op) {IRVisitor::visit(op); arith++;}
+    void visit(const GT *op) {IRVisitor::visit(op); arith++;}
+    void visit(const GE *op) {IRVisitor::visit(op); arith++;}
+    void visit(const And *op) {IRVisitor::visit(op); arith++;}
+    void visit(const Or *op) {IRVisitor::visit(op); arith++;}
+    void visit(const Not *op) {IRVisitor::visit(op); arith++;}
+    void visit(const Select *op) {IRVisitor::visit(op); arith++;}
+    void visit(const Cast *op) {IRVisitor::visit(op); arith++;}
+
+    void visit(const Call *op) {
+        IRVisitor::visit(op);
+        if (op->call_type == Call::Halide || op->call_type == Call::Image) {
+            bytes += op->type.bytes();
+        } else if (op->call_type == Call::Extern) {
+            arith += extern_call_cost;
+        } else {
+            arith++;
+        }
+    }
+
+public:
+    double arith, bytes;
+    CountCost() : arith(0), bytes(0) {}
+};
+
+// Count the calls to a function, and check whether they all access it
+// at the coordinates of the site being defined.
+class FindUses : public IRVisitor {
+    const string &func;
+    const vector<Expr> &site;
+
+    using IRVisitor::visit;
+
+    void visit(const Call *op) {
+        IRVisitor::visit(op);
+        if (op->call_type != Call::Halide || op->name != func) return;
+        count++;
+        if (op->args.size() != site.size()) {
+            pointwise = false;
+            return;
+        }
+        for (size_t i = 0; i < site.size(); i++) {
+            if (!op->args[i].as<Variable>() || !equal(op->args[i], site[i])) {
+                pointwise = false;
+            }
+        }
+    }
+
+public:
+    int count;
+    bool pointwise;
+    FindUses(const string &f, const vector<Expr> &s) : func(f), site(s), count(0), pointwise(true) {}
+};
+
+// One definition (pure or update) of a function.
+struct Definition {
+    vector<Expr> values, site;
+    ReductionDomain domain;
+};
+
+vector<Definition> definitions(Function f) {
+    vector<Definition> result;
+    if (f.has_extern_definition()) return result;
+
+    Definition pure;
+    pure.values = f.values();
+    for (const string &arg : f.args()) {
+        pure.site.push_back(Variable::make(Int(32), arg));
+    }
+    result.push_back(pure);
+
+    for (const UpdateDefinition &u : f.updates()) {
+        Definition d;
+        d.values = u.values;
+        d.site = u.args;
+        d.domain = u.domain;
+        result.push_back(d);
+    }
+    return result;
+}
+
+// A constant estimate of a one-dimensional range.
+struct Span {
+    int64_t min, max;
+    bool known;
+
+    int64_t extent() const {return known ? max - min + 1 : -1;}
+};
+
+struct FuncInfo {
+    Function func;
+    bool is_output;
+
+    // Whether the user already chose a schedule for this function.
+    bool user_scheduled;
+
+    // The estimated region computed.
+    vector<Span> region;
+
+    // Cost per point of the region, summed over all definitions.
+    double arith, bytes;
+
+    // The functions that call this one directly.
+    set<string> consumers;
+
+    bool inlined;
+
+    // If this function is tiled, the name of the loop over tiles, and
+    // the size of each tile.
+    string tile_var;
+    int tile_width, tile_height;
+
+    // Set if this function is computed within the tiles of a consumer.
+    string compute_at;
+
+    FuncInfo() : is_output(false), user_scheduled(false), arith(0), bytes(0),
+                 inlined(false), tile_width(0), tile_height(0) {}
+
+    double points() const {
+        double p = 1;
+        for (const Span &s : region) {
+            if (!s.known) return -1;
+            p *= (double)s.extent();
+        }
+        return p;
+    }
+};
+
+// Has the user already scheduled this function?
+bool is_scheduled(Function f, bool is_output) {
+    const Schedule &s = f.schedule();
+    if (!is_output && !s.compute_level().is_inline()) return true;
+    if (!s.splits().empty() || !s.specializations().empty()) return true;
+    for (const Dim &d : s.dims()) {
+        if (d.for_type != ForType::Serial) return true;
+    }
+    return false;
+}
+
+// Convert a symbolic interval to a constant span, if possible.
+Span to_span(const Interval &i) {
+    Span s = {0, 0, false};
+    if (i.min.defined() && i.max.defined()) {
+        const int64_t *min = as_const_int(simplify(i.min));
+        const int64_t *max = as_const_int(simplify(i.max));
+        if (min && max) {
+            s.min = *min;
+            s.max = *max;
+            s.known = true;
+        }
+    }
+    return s;
+}
+
+void merge_span(Span &a, const Span &b) {
+    if (!a.known || !b.known) {
+        a.known = false;
+    } else {
+        a.min = std::min(a.min, b.min);
+        a.max = std::max(a.max, b.max);
+    }
+}
+
+// The regions of other functions required to compute a region of a
+// function using the given definitions.
+map<string, Box> regions_required(const vector<Definition> &defs,
+                                  const vector<string> &args,
+                                  const vector<Span> &region,
+                                  const FuncValueBounds &func_bounds) {
+    map<string, Box> result;
+    for (const Definition &d : defs) {
+        Scope<Interval> scope;
+        for (size_t i = 0; i < args.size(); i++) {
+            if (region[i].known) {
+                scope.push(args[i], Interval(make_const(Int(32), region[i].min),
+                                             make_const(Int(32), region[i].max)));
+            }
+        }
+        if (d.domain.defined()) {
+            for (const ReductionVariable &rv : d.domain.domain()) {
+                scope.push(rv.var, Interval(rv.min, simplify(rv.min + rv.extent - 1)));
+            }
+        }
+
+        vector<Expr> exprs = d.values;
+        exprs.insert(exprs.end(), d.site.begin(), d.site.end());
+        for (Expr e : exprs) {
+            map<string, Box> boxes = boxes_required(e, scope, func_bounds);
+            for (const std::pair<string, Box> &b : boxes) {
+                merge_boxes(result[b.first], b.second);
+            }
+        }
+    }
+    return result;
+}
+
+class AutoScheduler {
+    const Target &target;
+    map<string, Function> env;
+    vector<string> order;
+    map<string, FuncInfo> info;
+    FuncValueBounds func_bounds;
+    ostringstream schedule;
+
+    // The functions that consume a function, looking through any
+    // consumers that have been inlined.
+    set<string> effective_consumers(const string &name) {
+        set<string> result;
+        for (const string &c : info[name].consumers) {
+            if (info[c].inlined) {
+                set<string> more = effective_consumers(c);
+                result.insert(more.begin(), more.end());
+            } else {
+                result.insert(c);
+            }
+        }
+        return result;
+    }
+
+    // The definitions of a function, with all inlined functions
+    // substituted in.
+    vector<Definition> inlined_definitions(Function f) {
+        vector<Definition> defs = definitions(f);
+        for (size_t i = order.size(); i > 0; i--) {
+            const FuncInfo &g = info[order[i-1]];
+            if (!g.inlined) continue;
+            for (Definition &d : defs) {
+                for (Expr &e : d.values) {
+                    e = inline_function(e, g.func);
+                }
+                for (Expr &e : d.site) {
+                    e = inline_function(e, g.func);
+                }
+            }
+        }
+        return defs;
+    }
+
+    void compute_regions() {
+        for (size_t i = order.size(); i > 0; i--) {
+            FuncInfo &f = info[order[i-1]];
+            const vector<string> &args = f.func.args();
+
+            if (f.is_output) {
+                // Use the estimates, or failing that the bounds, on
+                // each dimension of an output.
+                for (size_t d = 0; d < args.size(); d++) {
+                    Span s = {0, 0, false};
+                    for (const vector<Bound> *bounds : {&f.func.schedule().estimates(),
+                                                        &f.func.schedule().bounds()}) {
+                        for (const Bound &b : *bounds) {
+                            if (b.var != args[d] || s.known) continue;
+                            const int64_t *min = as_const_int(b.min);
+                            const int64_t *extent = as_const_int(b.extent);
+                            if (min && extent) {
+                                s.min = *min;
+                                s.max = *min + *extent - 1;
+                                s.known = true;
+                            }
+                        }
+                    }
+                    user_assert(s.known)
+                        << "Can't auto schedule the pipeline, because there is no estimate "
+                        << "for dimension " << args[d] << " of the output " << f.func.name()
+                        << ". Use Func::estimate to provide one.\n";
+                    if (f.region.size() == args.size()) {
+                        merge_span(f.region[d], s);
+                    } else {
+                        f.region.push_back(s);
+                    }
+                }
+            }
+
+            internal_assert(f.region.size() == args.size())
+                << "No region computed for " << f.func.name() << "\n";
+
+            if (f.func.has_extern_definition()) {
+                // We can't tell what an extern stage will ask for.
+                for (const ExternFuncArgument &arg : f.func.extern_arguments()) {
+                    if (!arg.is_func()) continue;
+                    FuncInfo &g = info[Function(arg.func).name()];
+                    g.consumers.insert(f.func.name());
+                    Span unknown = {0, 0, false};
+                    g.region = vector<Span>(g.func.args().size(), unknown);
+                }
+                continue;
+            }
+
+            vector<Definition> defs = definitions(f.func);
+            for (const Definition &d : defs) {
+                for (Expr e : d.values) {
+                    CountCost cost;
+                    e.accept(&cost);
+                    f.arith += cost.arith;
+                    f.bytes += cost.bytes;
+                }
+            }
+
+            map<string, Box> required = regions_required(defs, args, f.region, func_bounds);
+            for (const std::pair<string, Box> &b : required) {
+                map<string, FuncInfo>::iterator g = info.find(b.first);
+                if (g == info.end() || b.first == f.func.name()) continue;
+                g->second.consumers.insert(f.func.name());
+                internal_assert(b.second.size() == g->second.func.args().size());
+                for (size_t d = 0; d < b.second.size(); d++) {
+                    Span s = to_span(b.second[d]);
+                    if (g->second.region.size() == b.second.size()) {
+                        merge_span(g->second.region[d], s);
+                    } else {
+                        g->second.region.push_back(s);
+                    }
+                }
+            }
+        }
+
+        for (const string &name : order) {
+            const FuncInfo &f = info[name];
+            debug(1) << "Auto scheduler: " << name << " costs " << f.arith
+                     << " ops and " << f.bytes << " bytes loaded per point over "
+                     << f.points() << " points\n";
+        }
+    }
+
+    // Decide whether to inline a function into its consumers. We
+    // inline when all uses are pointwise, or when recomputing the
+    // function at each use is cheaper than storing and loading it.
+    bool should_inline(const FuncInfo &f) {
+        if (f.is_output || f.user_scheduled ||
+            f.func.has_update_definition() || f.func.has_extern_definition()) {
+            return false;
+        }
+
+        bool pointwise = true, known = true;
+        double recompute = 0;
+        for (const string &c : f.consumers) {
+            const FuncInfo &consumer = info[c];
+            if (consumer.func.has_extern_definition()) return false;
+            known = known && consumer.points() >= 0;
+            for (const Definition &d : definitions(consumer.func)) {
+                FindUses uses(f.func.name(), d.site);
+                for (Expr e : d.values) {
+                    e.accept(&uses);
+                }
+                pointwise = pointwise && uses.pointwise;
+                recompute += f.arith * uses.count * consumer.points();
+            }
+        }
+        if (pointwise) return true;
+
+        double points = f.points();
+        if (points < 0 || !known) return false;
+
+        double extra_work = recompute - f.arith * points;
+        double bytes_stored = points * f.func.output_types()[0].bytes() * f.func.outputs();
+        return extra_work <= 2 * bytes_stored * memory_cost_per_byte;
+    }
+
+    // Decide whether to compute a function within the tiles of its
+    // sole consumer, by checking how much overlap between tiles we'd
+    // recompute.
+    bool should_compute_at(const FuncInfo &f, const FuncInfo &consumer) {
+        if (f.is_output || f.user_scheduled || f.func.has_extern_definition() ||
+            consumer.tile_var.empty() || consumer.func.has_update_definition()) {
+            return false;
+        }
+
+        double points = f.points();
+        if (points <= 0) return false;
+
+        // The region of the consumer covered by one tile.
+        vector<Span> tile = consumer.region;
+        tile[0].max = tile[0].min + consumer.tile_width - 1;
+        tile[1].max = tile[1].min + consumer.tile_height - 1;
+
+        vector<Definition> defs = inlined_definitions(consumer.func);
+        map<string, Box> required = regions_required(defs, consumer.func.args(), tile, func_bounds);
+        map<string, Box>::iterator iter = required.find(f.func.name());
+        if (iter == required.end()) return false;
+
+        double footprint = 1;
+        for (const Interval &i : iter->second.bounds) {
+            Span s = to_span(i);
+            if (!s.known) return false;
+            footprint *= (double)s.extent();
+        }
+
+        double tiles = 1;
+        for (size_t d = 0; d < 2; d++) {
+            int size = d == 0 ? consumer.tile_width : consumer.tile_height;
+            tiles *= (double)((consumer.region[d].extent() + size - 1) / size);
+        }
+
+        double redundancy = tiles * footprint / points - 1;
+        debug(1) << "Auto scheduler: computing " << f.func.name() << " per tile of "
+                 << consumer.func.name() << " would redo " << redundancy * 100 << "% of the work\n";
+        return redundancy <= max_redundant_work;
+    }
+
+    // Tile, vectorize and parallelize the loop nest of a function.
+    void schedule_loops(FuncInfo &f) {
+        Func func(f.func);
+        const vector<string> &args = f.func.args();
+        ostringstream directives;
+
+        // A scalar (e.g. a total computed by a reduction) has no
+        // loops to schedule.
+        if (args.empty()) return;
+
+        int vector_size = target.natural_vector_size(f.func.output_types()[0]);
+        Var x(args[0]);
+
+        if (f.compute_at.empty() && args.size() >= 2 &&
+            f.region[0].extent() >= 2 * tile_size &&
+            f.region[1].extent() >= 2 * tile_size) {
+            Var y(args[1]);
+            Var xo(args[0] + "_o"), yo(args[1] + "_o"), xi(args[0] + "_i"), yi(args[1] + "_i");
+            func.tile(x, y, xo, yo, xi, yi, tile_size, tile_size);
+            directives << ".tile(" << x.name() << ", " << y.name() << ", "
+                       << xo.name() << ", " << yo.name() << ", "
+                       << xi.name() << ", " << yi.name() << ", "
+                       << tile_size << ", " << tile_size << ")";
+            f.tile_var = xo.name();
+            f.tile_width = f.tile_height = tile_size;
+
+            if (tile_size >= vector_size) {
+                func.vectorize(xi, vector_size);
+                directives << ".vectorize(" << xi.name() << ", " << vector_size << ")";
+            }
+
+            // Parallelize over the outermost dimension, or the rows of
+            // tiles if there are no more dimensions.
+            if (args.size() > 2 && f.region.back().extent() >= min_parallel_tasks) {
+                func.parallel(Var(args.back()));
+                directives << ".parallel(" << args.back() << ")";
+            } else if (f.region[1].extent() >= min_parallel_tasks * tile_size) {
+                func.parallel(yo);
+                directives << ".parallel(" << yo.name() << ")";
+            }
+        } else {
+            if (f.region[0].extent() >= vector_size) {
+                func.vectorize(x, vector_size);
+                directives << ".vectorize(" << x.name() << ", " << vector_size << ")";
+            }
+            if (f.compute_at.empty() && args.size() >= 2 &&
+                f.region.back().extent() >= min_parallel_tasks) {
+                func.parallel(Var(args.back()));
+                directives << ".parallel(" << args.back() << ")";
+            }
+        }
+
+        if (!directives.str().empty()) {
+            schedule << f.func.name() << directives.str() << ";\n";
+        }
+
+        // Vectorize and parallelize the update definitions over any
+        // pure vars they still have.
+        for (size_t i = 0; i < f.func.updates().size(); i++) {
+            const vector<Expr> &site = f.func.updates()[i].args;
+            ostringstream update_directives;
+            Stage stage = func.update(i);
+
+            const Variable *inner = site[0].as<Variable>();
+            if (inner && inner->name == args[0] && f.region[0].extent() >= vector_size) {
+                stage.vectorize(x, vector_size);
+                update_directives << ".vectorize(" << x.name() << ", " << vector_size << ")";
+            }
+
+            const Variable *outer = site.back().as<Variable>();
+            if (f.compute_at.empty() && site.size() >= 2 &&
+                outer && outer->name == args.back() &&
+                f.region.back().extent() >= min_parallel_tasks) {
+                stage.parallel(Var(args.back()));
+                update_directives << ".parallel(" << args.back() << ")";
+            }
+
+            if (!update_directives.str().empty()) {
+                schedule << f.func.name() << ".update(" << i << ")"
+                         << update_directives.str() << ";\n";
+            }
+        }
+    }
+
+public:
+    AutoScheduler(const vector<Function> &outputs, const Target &t) : target(t) {
+        for (Function f : outputs) {
+            map<string, Function> more_funcs = find_transitive_calls(f);
+            env.insert(more_funcs.begin(), more_funcs.end());
+        }
+        order = realization_order(outputs, env);
+        func_bounds = compute_function_value_bounds(order, env);
+
+        for (const string &name : order) {
+            FuncInfo &f = info[name];
+            f.func = env[name];
+            for (Function o : outputs) {
+                f.is_output |= o.same_as(f.func);
+            }
+            f.user_scheduled = is_scheduled(f.func, f.is_output);
+        }
+    }
+
+    string run() {
+        compute_regions();
+
+        // Decide what to inline, consumers first.
+        for (size_t i = order.size(); i > 0; i--) {
+            FuncInfo &f = info[order[i-1]];
+            f.inlined = should_inline(f);
+        }
+
+        // Schedule everything else, consumers first so that we know
+        // their tiling when scheduling their producers.
+        for (size_t i = order.size(); i > 0; i--) {
+            FuncInfo &f = info[order[i-1]];
+            if (f.inlined || f.user_scheduled) continue;
+
+            Func func(f.func);
+            if (!f.is_output) {
+                set<string> consumers = effective_consumers(f.func.name());
+                if (consumers.size() == 1 &&
+                    should_compute_at(f, info[*consumers.begin()])) {
+                    const FuncInfo &c = info[*consumers.begin()];
+                    f.compute_at = c.func.name();
+                    func.compute_at(Func(c.func), Var(c.tile_var));
+                    schedule << f.func.name() << ".compute_at("
+                             << c.func.name() << ", " << c.tile_var << ");\n";
+                } else {
+                    func.compute_root();
+                    schedule << f.func.name() << ".compute_root();\n";
+                }
+            }
+
+            if (!f.func.has_extern_definition()) {
+                schedule_loops(f);
+            }
+        }
+
+        return schedule.str();
+    }
+};
+
+}
+
+string generate_schedules(const vector<Function> &outputs, const Target &target) {
+    AutoScheduler scheduler(outputs, target);
+    string result = scheduler.run();
+    debug(1) << "Auto schedule:\n" << result;
+    return result;
+}
+
+}
+}
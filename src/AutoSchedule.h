@@ -0,0 +1,31 @@
+#ifndef HALIDE_AUTO_SCHEDULE_H
+#define HALIDE_AUTO_SCHEDULE_H
+
+/** \file
+ *
+ * Defines the auto scheduler, which picks a schedule for the
+ * unscheduled functions of a pipeline.
+ */
+
+#include <string>
+#include <vector>
+
+#include "IR.h"
+#include "Target.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Schedule every function in the pipeline defined by the given
+ * outputs that the user has not already scheduled. Decides which
+ * functions to inline, which to compute at root, and which to
+ * compute within tiles of their consumer, using the estimated
+ * region of each function and a cost model of arithmetic and memory
+ * traffic. Then tiles, vectorizes and parallelizes the loop nests
+ * for the given target. Returns the chosen schedule as C++ source. */
+std::string generate_schedules(const std::vector<Function> &outputs, const Target &target);
+
+}
+}
+
+#endif
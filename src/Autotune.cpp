@@ -0,0 +1,486 @@
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <thread>
+
+#include "Autotune.h"
+#include "Debug.h"
+#include "Error.h"
+#include "Util.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+// GeneratorBase only lets its friends build its pipeline.
+class Autotuner {
+public:
+    static Pipeline build_pipeline(GeneratorBase *generator) {
+        return generator->build_pipeline();
+    }
+};
+
+namespace {
+
+struct Candidate {
+    GeneratorParamValues params;
+    std::unique_ptr<GeneratorBase> generator;
+    Pipeline pipeline;
+    Target target;
+    bool ok;
+    string error;
+    double time;
+};
+
+// Every combination of values in the space, in lexicographic order.
+vector<GeneratorParamValues> enumerate_space(const GeneratorParamValues &fixed,
+                                             const GeneratorParamSpace &space) {
+    vector<GeneratorParamValues> result(1, fixed);
+    for (const auto &dim : space) {
+        user_assert(!dim.second.empty())
+            << "No candidate values for GeneratorParam " << dim.first << "\n";
+        vector<GeneratorParamValues> next;
+        for (const GeneratorParamValues &partial : result) {
+            for (const string &value : dim.second) {
+                next.push_back(partial);
+                next.back()[dim.first] = value;
+            }
+        }
+        result.swap(next);
+    }
+    return result;
+}
+
+string describe(const GeneratorParamValues &params, const GeneratorParamSpace &space) {
+    std::ostringstream s;
+    for (const auto &dim : space) {
+        s << " " << dim.first << "=" << params.find(dim.first)->second;
+    }
+    return s.str();
+}
+
+vector<int> extents_for(const string &name, int dimensions, const AutotuneOptions &options) {
+    map<string, vector<int>>::const_iterator iter = options.extents.find(name);
+    vector<int> extents = (iter != options.extents.end()) ? iter->second : options.default_extents;
+    user_assert((int)extents.size() <= dimensions)
+        << "Too many extents given for " << name << ", which has "
+        << dimensions << " dimensions\n";
+    extents.resize(dimensions, 1);
+    return extents;
+}
+
+template<typename T>
+void fill_random(T *data, size_t size, std::mt19937 &rng) {
+    // Small values, so that e.g. sums of products of them don't
+    // overflow or saturate and change the speed of the code.
+    std::uniform_int_distribution<int> dist(0, 15);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (T)dist(rng);
+    }
+}
+
+Buffer make_random_buffer(Type t, const vector<int> &extents, const string &name, std::mt19937 &rng) {
+    Buffer b(t, extents, NULL, name);
+    size_t size = 1;
+    for (int e : extents) {
+        size *= e;
+    }
+    void *data = b.host_ptr();
+    if (t == Float(32)) {
+        fill_random((float *)data, size, rng);
+    } else if (t == Float(64)) {
+        fill_random((double *)data, size, rng);
+    } else if (t.bits() == 8 || t.bits() == 1) {
+        fill_random((uint8_t *)data, size, rng);
+    } else if (t.bits() == 16) {
+        fill_random((uint16_t *)data, size, rng);
+    } else if (t.bits() == 32) {
+        fill_random((uint32_t *)data, size, rng);
+    } else {
+        internal_assert(t.bits() == 64);
+        fill_random((uint64_t *)data, size, rng);
+    }
+    return b;
+}
+
+// Compile the candidates, several at a time. Compiling separate
+// pipelines shares no state beyond Halide's (synchronized) name
+// generation and LLVM initialization.
+void compile_candidates(vector<Candidate> &candidates, int threads) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < candidates.size(); i = next++) {
+            Candidate &c = candidates[i];
+            if (!c.ok) continue;
+            #ifdef WITH_EXCEPTIONS
+            try {
+                c.pipeline.compile_jit(c.target);
+            } catch (const Halide::Error &e) {
+                c.ok = false;
+                c.error = e.what();
+            }
+            #else
+            c.pipeline.compile_jit(c.target);
+            #endif
+        }
+    };
+
+    vector<std::thread> pool;
+    for (int i = 1; i < threads; i++) {
+        pool.push_back(std::thread(worker));
+    }
+    worker();
+    for (std::thread &t : pool) {
+        t.join();
+    }
+}
+
+// The minimum over some number of samples of the time taken to
+// realize the pipeline, like apps/support/benchmark.h.
+double benchmark(Pipeline p, Realization dst, const Target &target, int samples, int iterations) {
+    // Warm up, and check that it works.
+    p.realize(dst, target);
+
+    double best = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < samples; i++) {
+        auto t1 = std::chrono::high_resolution_clock::now();
+        for (int j = 0; j < iterations; j++) {
+            p.realize(dst, target);
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+        double dt = std::chrono::duration<double>(t2 - t1).count();
+        if (dt < best) best = dt;
+    }
+    return best / iterations;
+}
+
+void run_candidate(Candidate &c, const AutotuneOptions &options,
+                   map<string, Buffer> &inputs, std::mt19937 &rng) {
+    // Bind random data to the input buffers. Inputs of the same
+    // name, type, and shape are shared between candidates.
+    for (Parameter p : c.generator->get_filter_parameters()) {
+        if (!p.is_buffer()) continue;
+        vector<int> extents = extents_for(p.name(), p.dimensions(), options);
+        Buffer &b = inputs[p.name()];
+        bool matches = b.defined() && b.type() == p.type() && b.dimensions() == p.dimensions();
+        for (int i = 0; matches && i < p.dimensions(); i++) {
+            matches = (b.extent(i) == extents[i]);
+        }
+        if (!matches) {
+            b = make_random_buffer(p.type(), extents, p.name(), rng);
+        }
+        p.set_buffer(b);
+    }
+
+    vector<Buffer> outputs;
+    for (Func f : c.pipeline.outputs()) {
+        vector<int> extents = extents_for(f.name(), f.dimensions(), options);
+        for (Type t : f.output_types()) {
+            outputs.push_back(Buffer(t, extents));
+        }
+    }
+
+    c.time = benchmark(c.pipeline, Realization(outputs), c.target,
+                       options.samples, options.iterations);
+}
+
+}
+
+vector<string> parse_generator_param_range(const string &range) {
+    size_t dots = range.find("..");
+    if (dots == string::npos) {
+        return split_string(range, ",");
+    }
+
+    std::istringstream lo_str(range.substr(0, dots)), hi_str(range.substr(dots + 2));
+    int lo = 0, hi = 0;
+    user_assert((lo_str >> lo) && lo_str.eof() && (hi_str >> hi) && hi_str.eof() && lo > 0 && lo <= hi)
+        << "Invalid GeneratorParam range: " << range
+        << ". Ranges must be of the form lo..hi with 0 < lo <= hi\n";
+    vector<string> result;
+    for (int v = lo; v <= hi; v *= 2) {
+        result.push_back(std::to_string(v));
+        if (v > std::numeric_limits<int>::max() / 2) break;
+    }
+    return result;
+}
+
+AutotuneResult autotune_generator(const string &generator_name,
+                                  const GeneratorParamValues &fixed_params,
+                                  const GeneratorParamSpace &space,
+                                  const AutotuneOptions &options,
+                                  std::ostream &log) {
+    vector<GeneratorParamValues> configs = enumerate_space(fixed_params, space);
+
+    int threads = options.threads;
+    if (threads <= 0) {
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+
+    log << "Autotuning " << generator_name << " over " << configs.size() << " candidates\n";
+
+    AutotuneResult result;
+    result.time = std::numeric_limits<double>::infinity();
+    result.candidates = configs.size();
+
+    map<string, Buffer> inputs;
+    std::mt19937 rng(0);
+
+    // Work on a batch of candidates at a time, to bound the memory
+    // used by compiled code. Compilation is in parallel, but the
+    // candidates are run one at a time so that their timings don't
+    // interfere with each other.
+    for (size_t start = 0; start < configs.size(); start += threads) {
+        size_t end = std::min(configs.size(), start + threads);
+        vector<Candidate> batch(end - start);
+
+        // Defining the pipelines touches global state (e.g. the
+        // registry of Params in each Generator), so it happens on this
+        // thread.
+        for (size_t i = 0; i < batch.size(); i++) {
+            Candidate &c = batch[i];
+            c.params = configs[start + i];
+            c.ok = true;
+            c.time = std::numeric_limits<double>::infinity();
+            #ifdef WITH_EXCEPTIONS
+            try {
+            #endif
+                c.generator = GeneratorRegistry::create(generator_name, c.params);
+                c.pipeline = Autotuner::build_pipeline(c.generator.get());
+                // Generators may adjust their own target while building.
+                c.target = c.generator->get_target();
+                c.params = c.generator->get_generator_param_values();
+            #ifdef WITH_EXCEPTIONS
+            } catch (const Halide::Error &e) {
+                c.ok = false;
+                c.error = e.what();
+            }
+            #endif
+        }
+
+        compile_candidates(batch, threads);
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            Candidate &c = batch[i];
+            if (c.ok) {
+                #ifdef WITH_EXCEPTIONS
+                try {
+                    run_candidate(c, options, inputs, rng);
+                } catch (const Halide::Error &e) {
+                    c.ok = false;
+                    c.error = e.what();
+                }
+                #else
+                run_candidate(c, options, inputs, rng);
+                #endif
+            }
+
+            log << "  " << describe(configs[start + i], space) << ": ";
+            if (c.ok) {
+                log << c.time * 1000 << " ms\n";
+            } else {
+                log << "failed: " << c.error << "\n";
+            }
+
+            if (c.ok && c.time < result.time) {
+                result.time = c.time;
+                result.params = c.params;
+            }
+        }
+    }
+
+    if (result.params.empty()) {
+        log << "No candidates ran successfully\n";
+    } else {
+        log << "Best:" << describe(result.params, space) << ": " << result.time * 1000 << " ms\n";
+    }
+
+    return result;
+}
+
+void write_tuned_params_cpp(const string &filename,
+                            const string &generator_name,
+                            const Target &target,
+                            const AutotuneResult &result) {
+    std::ofstream f(filename.c_str());
+    user_assert(f.is_open()) << "Could not open " << filename << " for writing\n";
+
+    string var_name = generator_name + "_tuned_params";
+    for (char &c : var_name) {
+        if (!isalnum(c)) c = '_';
+    }
+
+    f << "// Generated by the Halide autotuner for " << generator_name
+      << " on target " << target.to_string() << ".\n"
+      << "// Best time: " << result.time * 1000 << " ms over "
+      << result.candidates << " candidates.\n"
+      << "#include <map>\n"
+      << "#include <string>\n\n"
+      << "static const std::map<std::string, std::string> " << var_name << " = {\n";
+    for (const auto &p : result.params) {
+        if (p.first == "target") continue;
+        f << "    {\"" << p.first << "\", \"" << p.second << "\"},\n";
+    }
+    f << "};\n";
+}
+
+int autotune_main(int argc, char **argv, std::ostream &cerr) {
+    const char kUsage[] = "autotune [-g GENERATOR_NAME] [-f FUNCTION_NAME] [-o OUTPUT_DIR] [-e EMIT_OPTIONS] "
+                          "[-s EXTENTS] [-n SAMPLES] [-j THREADS] "
+                          "target=target-string [generator_arg=value|values|lo..hi [...]]\n\n"
+                          "  Generator args with more than one value (a comma separated list, or lo..hi\n"
+                          "  meaning the powers of two times lo up to hi) are tuned.\n"
+                          "  -s  The extents of the buffers, as a comma separated list of WxH[x...] for\n"
+                          "      every buffer, and NAME:WxH[x...] for the input or output named NAME.\n"
+                          "  -n  The number of timing samples of each candidate (default 10).\n"
+                          "  -j  The number of candidates to compile in parallel (default: one per core).\n"
+                          "  -e  As for gengen, the optional files to emit for the winning candidate.\n";
+
+    map<string, string> flags_info = { { "-f", "" },
+                                       { "-g", "" },
+                                       { "-o", "" },
+                                       { "-e", "" },
+                                       { "-s", "" },
+                                       { "-n", "10" },
+                                       { "-j", "0" }};
+    GeneratorParamValues generator_args;
+
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] != '-') {
+            vector<string> v = split_string(argv[i], "=");
+            if (v.size() != 2 || v[0].empty() || v[1].empty()) {
+                cerr << kUsage;
+                return 1;
+            }
+            generator_args[v[0]] = v[1];
+            continue;
+        }
+        auto it = flags_info.find(argv[i]);
+        if (it != flags_info.end()) {
+            if (i + 1 >= argc) {
+                cerr << kUsage;
+                return 1;
+            }
+            it->second = argv[i + 1];
+            ++i;
+            continue;
+        }
+        cerr << "Unknown flag: " << argv[i] << "\n";
+        cerr << kUsage;
+        return 1;
+    }
+
+    vector<string> generator_names = GeneratorRegistry::enumerate();
+    string generator_name = flags_info["-g"];
+    if (generator_name.empty()) {
+        if (generator_names.size() != 1) {
+            cerr << "-g must be specified unless exactly one generator is registered\n";
+            cerr << kUsage;
+            return 1;
+        }
+        generator_name = generator_names[0];
+    }
+    string function_name = flags_info["-f"];
+    if (function_name.empty()) {
+        function_name = generator_name;
+    }
+    string output_dir = flags_info["-o"];
+    if (output_dir.empty()) {
+        cerr << "-o must always be specified.\n";
+        cerr << kUsage;
+        return 1;
+    }
+    if (generator_args.find("target") == generator_args.end()) {
+        cerr << "Target missing\n";
+        cerr << kUsage;
+        return 1;
+    }
+    Target target = parse_target_string(generator_args["target"]);
+
+    AutotuneOptions options;
+    options.samples = std::atoi(flags_info["-n"].c_str());
+    options.threads = std::atoi(flags_info["-j"].c_str());
+    for (const string &item : split_string(flags_info["-s"], ",")) {
+        if (item.empty()) continue;
+        size_t colon = item.find(':');
+        string name, sizes = item;
+        if (colon != string::npos) {
+            name = item.substr(0, colon);
+            sizes = item.substr(colon + 1);
+        }
+        vector<int> extents;
+        for (const string &e : split_string(sizes, "x")) {
+            extents.push_back(std::atoi(e.c_str()));
+            if (extents.back() <= 0) {
+                cerr << "Invalid extents: " << item << "\n";
+                cerr << kUsage;
+                return 1;
+            }
+        }
+        if (name.empty()) {
+            options.default_extents = extents;
+        } else {
+            options.extents[name] = extents;
+        }
+    }
+    if (options.samples <= 0) {
+        cerr << "-n must be positive\n";
+        cerr << kUsage;
+        return 1;
+    }
+
+    GeneratorParamValues fixed;
+    GeneratorParamSpace space;
+    for (const auto &arg : generator_args) {
+        vector<string> values = (arg.first == "target") ?
+            vector<string>(1, arg.second) : parse_generator_param_range(arg.second);
+        if (values.size() == 1) {
+            fixed[arg.first] = values[0];
+        } else {
+            space[arg.first] = values;
+        }
+    }
+
+    AutotuneResult result = autotune_generator(generator_name, fixed, space, options, cerr);
+    if (result.params.empty()) {
+        return 1;
+    }
+
+    // Persist the best configuration for this target, without the
+    // target itself, so that it can be passed to gengen with -p.
+    string base_path = output_dir + "/" + function_name + "." + target.to_string();
+    GeneratorParamValues tuned = result.params;
+    tuned.erase("target");
+    std::ostringstream comment;
+    comment << "Tuned for " << generator_name << " on target " << target.to_string() << "\n"
+            << "Best time: " << result.time * 1000 << " ms over " << result.candidates << " candidates\n";
+    write_generator_param_file(base_path + ".params", tuned, comment.str());
+    write_tuned_params_cpp(base_path + ".params.cpp", generator_name, target, result);
+
+    // Emit the winning filter, as gengen would.
+    vector<string> args = {argv[0],
+                           "-g", generator_name,
+                           "-f", function_name,
+                           "-o", output_dir,
+                           "-p", base_path + ".params",
+                           "target=" + generator_args["target"]};
+    if (!flags_info["-e"].empty()) {
+        args.push_back("-e");
+        args.push_back(flags_info["-e"]);
+    }
+    vector<char *> gengen_argv;
+    for (string &a : args) {
+        gengen_argv.push_back(&a[0]);
+    }
+    return generate_filter_main((int)gengen_argv.size(), gengen_argv.data(), cerr);
+}
+
+}
+}
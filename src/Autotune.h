@@ -0,0 +1,98 @@
+#ifndef HALIDE_AUTOTUNE_H
+#define HALIDE_AUTOTUNE_H
+
+/** \file
+ *
+ * Defines an empirical autotuner for Generators. It searches over the
+ * values of a Generator's GeneratorParams (e.g. schedule flags and
+ * split factors) by JIT-compiling and timing each candidate.
+ */
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Generator.h"
+
+namespace Halide {
+namespace Internal {
+
+/** The candidate values of each GeneratorParam to search over. */
+using GeneratorParamSpace = std::map<std::string, std::vector<std::string>>;
+
+/** Parse the candidate values of a GeneratorParam. The range is
+ * either a comma-separated list of values (e.g. "true,false"), or
+ * "lo..hi", which means lo, 2*lo, 4*lo, ... up to hi (e.g. "2..64"),
+ * which is the usual space of split factors and tile sizes. A single
+ * value is a range of size one. */
+EXPORT std::vector<std::string> parse_generator_param_range(const std::string &range);
+
+struct AutotuneOptions {
+    /** Each candidate is timed as the minimum over 'samples' runs of
+     * 'iterations' realizations each. */
+    int samples, iterations;
+
+    /** The number of candidates to JIT-compile in parallel. Zero
+     * means one per hardware thread. */
+    int threads;
+
+    /** The extents of each input and output buffer, by the name of
+     * its ImageParam or output Func. Buffers not listed here use
+     * default_extents. Missing trailing extents are one. */
+    std::map<std::string, std::vector<int>> extents;
+    std::vector<int> default_extents;
+
+    AutotuneOptions() : samples(10), iterations(1), threads(0) {}
+};
+
+struct AutotuneResult {
+    /** The values of all the GeneratorParams of the fastest
+     * candidate, including the ones that were not tuned. */
+    GeneratorParamValues params;
+
+    /** The time in seconds of one realization of the fastest
+     * candidate, or infinity if no candidate ran successfully. */
+    double time;
+
+    /** The number of candidates that were tried. */
+    size_t candidates;
+
+    AutotuneResult() : time(0), candidates(0) {}
+};
+
+/** Find the fastest values of the GeneratorParams in the given space
+ * for the named Generator. Every combination of values is created
+ * with the fixed params (which should include the target), and
+ * JIT-compiled, several at a time on separate threads. Each compiled
+ * candidate is then run on its own on random input data, with scalar
+ * inputs set to their default values. Progress is written to log.
+ *
+ * If Halide was built with exceptions, candidates that fail to
+ * compile or run are skipped; otherwise such an error is fatal. */
+EXPORT AutotuneResult autotune_generator(const std::string &generator_name,
+                                         const GeneratorParamValues &fixed_params,
+                                         const GeneratorParamSpace &space,
+                                         const AutotuneOptions &options,
+                                         std::ostream &log);
+
+/** Write a tuned configuration as C++ source that defines a map from
+ * GeneratorParam name to value, suitable for checking in. */
+EXPORT void write_tuned_params_cpp(const std::string &filename,
+                                   const std::string &generator_name,
+                                   const Target &target,
+                                   const AutotuneResult &result);
+
+/** autotune_main() is a command-line wrapper around
+ * autotune_generator(), in the style of generate_filter_main(). Any
+ * generator_arg whose value is a range (see
+ * parse_generator_param_range) is tuned. The best configuration is
+ * saved to OUTPUT_DIR/FUNCTION_NAME.TARGET.params (which
+ * generate_filter_main can read with -p) and .params.cpp, and the
+ * winning filter is then emitted as gengen would. */
+EXPORT int autotune_main(int argc, char **argv, std::ostream &cerr);
+
+}
+}
+
+#endif
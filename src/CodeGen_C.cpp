@@ -9,6 +9,7 @@
 #include "Var.h"
 #include "Lerp.h"
 #include "Simplify.h"
+#include "StorageFolding.h"
 
 namespace Halide {
 namespace Internal {
@@ -65,6 +66,7 @@ const string globals =
     "int halide_start_clock(void *ctx);\n"
     "int64_t halide_current_time_ns(void *ctx);\n"
     "void halide_profiler_pipeline_end(void *, void *);\n"
+    "void halide_telemetry_pipeline_end(void *, void *);\n"
     "}\n"
     "\n"
 
@@ -1203,7 +1205,14 @@ void CodeGen_C::visit(const ProducerConsumer *op) {
 }
 
 void CodeGen_C::visit(const For *op) {
-    if (op->for_type == ForType::Parallel) {
+    if (op->for_type == ForType::Parallel && is_async_loop_var(op->name)) {
+        // Each iteration of these loops waits on the other, so they
+        // must all get their own thread.
+        const IntImm *extent = op->extent.as<IntImm>();
+        internal_assert(extent) << "Async loops should have a constant extent\n";
+        do_indent();
+        stream << "#pragma omp parallel for num_threads(" << extent->value << ")\n";
+    } else if (op->for_type == ForType::Parallel) {
         do_indent();
         stream << "#pragma omp parallel for\n";
     } else {
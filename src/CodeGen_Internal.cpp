@@ -168,6 +168,7 @@ bool function_takes_user_context(const std::string &name) {
         "halide_device_malloc",
         "halide_device_sync",
         "halide_do_par_for",
+        "halide_do_async",
         "halide_do_task",
         "halide_error",
         "halide_free",
@@ -175,6 +176,8 @@ bool function_takes_user_context(const std::string &name) {
         "halide_print",
         "halide_profiler_pipeline_start",
         "halide_profiler_pipeline_end",
+        "halide_telemetry_pipeline_start",
+        "halide_telemetry_pipeline_end",
         "halide_spawn_thread",
         "halide_device_release",
         "halide_start_clock",
@@ -182,6 +185,8 @@ bool function_takes_user_context(const std::string &name) {
         "halide_memoization_cache_lookup",
         "halide_memoization_cache_store",
         "halide_memoization_cache_release",
+        "halide_memoization_hash_buffer",
+        "halide_memoization_hash_buffer_region",
         "halide_cuda_run",
         "halide_opencl_run",
         "halide_opengl_run",
@@ -207,5 +212,18 @@ bool function_takes_user_context(const std::string &name) {
     return starts_with(name, "halide_error_");
 }
 
+llvm::CodeGenOpt::Level get_codegen_opt_level(int opt_level) {
+    switch (opt_level) {
+    case 0:
+        return llvm::CodeGenOpt::None;
+    case 1:
+        return llvm::CodeGenOpt::Less;
+    case 2:
+        return llvm::CodeGenOpt::Default;
+    default:
+        return llvm::CodeGenOpt::Aggressive;
+    }
+}
+
 }
 }
@@ -49,6 +49,9 @@ bool constant_allocation_size(const std::vector<Expr> &extents, const std::strin
 /** Which built-in functions require a user-context first argument? */
 bool function_takes_user_context(const std::string &name);
 
+/** The llvm code generation level for a Target::opt_level(). */
+llvm::CodeGenOpt::Level get_codegen_opt_level(int opt_level);
+
 }}
 
 #endif
@@ -1,10 +1,12 @@
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <sstream>
 
 #include "IRPrinter.h"
 #include "CodeGen_LLVM.h"
 #include "IROperator.h"
+#include "IRMutator.h"
 #include "Debug.h"
 #include "Deinterleave.h"
 #include "Simplify.h"
@@ -14,6 +16,7 @@
 #include "Util.h"
 #include "LLVM_Runtime_Linker.h"
 #include "MatlabWrapper.h"
+#include "StorageFolding.h"
 
 #include "CodeGen_X86.h"
 #include "CodeGen_GPU_Host.h"
@@ -309,7 +312,14 @@ CodeGen_LLVM *CodeGen_LLVM::new_for_target(const Target &target,
     return NULL;
 }
 
+namespace {
+std::mutex initialize_llvm_mutex;
+}
+
 void CodeGen_LLVM::initialize_llvm() {
+    // Code generators may be constructed on several threads at once.
+    std::lock_guard<std::mutex> lock(initialize_llvm_mutex);
+
     // Initialize the targets we want to generate code for which are enabled
     // in llvm configuration
     if (!llvm_initialized) {
@@ -403,6 +413,7 @@ std::unique_ptr<llvm::Module> CodeGen_LLVM::compile(const Module &input) {
 
     // Add some target specific info to the module as metadata.
     module->addModuleFlag(llvm::Module::Warning, "halide_use_soft_float_abi", use_soft_float_abi() ? 1 : 0);
+    module->addModuleFlag(llvm::Module::Warning, "halide_opt_level", target.opt_level());
     #if LLVM_VERSION < 36
     module->addModuleFlag(llvm::Module::Warning, "halide_mcpu", ConstantDataArray::getString(*context, mcpu()));
     module->addModuleFlag(llvm::Module::Warning, "halide_mattrs", ConstantDataArray::getString(*context, mattrs()));
@@ -489,6 +500,45 @@ llvm::Function *add_argv_wrapper(llvm::Module *m, llvm::Function *fn, const std:
     return wrapper;
 }
 
+// LLVM can't do arithmetic on half-precision floats on most targets
+// without calling out to compiler runtime libraries, so do the math
+// in single precision and keep Float(16) purely as a storage type.
+class PromoteFloat16Arithmetic : public IRMutator {
+    using IRMutator::visit;
+
+    template<typename T>
+    Expr promote(const T *op) {
+        Expr a = mutate(op->a), b = mutate(op->b);
+        Type t = a.type();
+        if (t.is_float() && t.bits() == 16) {
+            Type wide = Float(32, t.lanes());
+            Expr result = T::make(Cast::make(wide, a), Cast::make(wide, b));
+            if (op->type == t) {
+                result = Cast::make(t, result);
+            }
+            return result;
+        } else if (a.same_as(op->a) && b.same_as(op->b)) {
+            return op;
+        } else {
+            return T::make(a, b);
+        }
+    }
+
+    void visit(const Add *op) {expr = promote(op);}
+    void visit(const Sub *op) {expr = promote(op);}
+    void visit(const Mul *op) {expr = promote(op);}
+    void visit(const Div *op) {expr = promote(op);}
+    void visit(const Mod *op) {expr = promote(op);}
+    void visit(const Min *op) {expr = promote(op);}
+    void visit(const Max *op) {expr = promote(op);}
+    void visit(const EQ *op) {expr = promote(op);}
+    void visit(const NE *op) {expr = promote(op);}
+    void visit(const LT *op) {expr = promote(op);}
+    void visit(const LE *op) {expr = promote(op);}
+    void visit(const GT *op) {expr = promote(op);}
+    void visit(const GE *op) {expr = promote(op);}
+};
+
 }
 
 void CodeGen_LLVM::compile_func(const LoweredFunc &f) {
@@ -540,7 +590,8 @@ void CodeGen_LLVM::compile_func(const LoweredFunc &f) {
 
     // Ok, we have a module, function, context, and a builder
     // pointing at a brand new basic block. We're good to go.
-    f.body.accept(this);
+    Stmt body = PromoteFloat16Arithmetic().mutate(f.body);
+    body.accept(this);
 
     return_with_error_code(ConstantInt::get(i32, 0));
 
@@ -834,7 +885,7 @@ llvm::Type *CodeGen_LLVM::llvm_type_of(Type t) {
 }
 
 void CodeGen_LLVM::optimize_module() {
-    debug(3) << "Optimizing module\n";
+    debug(3) << "Optimizing module at O" << target.opt_level() << "\n";
 
     if (debug::debug_level >= 3) {
         module->dump();
@@ -856,8 +907,10 @@ void CodeGen_LLVM::optimize_module() {
     // Make sure things marked as always-inline get inlined
     module_pass_manager.add(createAlwaysInlinerPass());
 
+    // The OptLevel Target features trade the speed of the generated
+    // code for faster compiles.
     PassManagerBuilder b;
-    b.OptLevel = 3;
+    b.OptLevel = target.opt_level();
     b.populateFunctionPassManager(function_pass_manager);
     b.populateModulePassManager(module_pass_manager);
 
@@ -1152,6 +1205,29 @@ void CodeGen_LLVM::visit(const Cast *op) {
     Halide::Type src = op->value.type();
     Halide::Type dst = op->type;
 
+    // Conversions to and from half precision all go via single
+    // precision. Note that this means double to half conversions
+    // round twice.
+    bool src_is_half = src.is_float() && src.bits() == 16;
+    bool dst_is_half = dst.is_float() && dst.bits() == 16;
+    if (src_is_half && !dst_is_half) {
+        Halide::Type f32 = Float(32, src.lanes());
+        if (dst == f32) {
+            value = float16_to_float32(op->value);
+        } else {
+            value = codegen(Cast::make(dst, Cast::make(f32, op->value)));
+        }
+        return;
+    } else if (dst_is_half && !src_is_half) {
+        Halide::Type f32 = Float(32, dst.lanes());
+        if (src == f32) {
+            value = float32_to_float16(op->value);
+        } else {
+            value = codegen(Cast::make(dst, Cast::make(f32, op->value)));
+        }
+        return;
+    }
+
     value = codegen(op->value);
 
     llvm::Type *llvm_dst = llvm_type_of(dst);
@@ -1191,6 +1267,53 @@ void CodeGen_LLVM::visit(const Cast *op) {
     }
 }
 
+Value *CodeGen_LLVM::float16_to_float32(Expr e) {
+    // Move the exponent and mantissa into place and rebias the
+    // exponent, then fix up infinities, nans, and denormals.
+    int lanes = e.type().lanes();
+    Halide::Type u32 = UInt(32, lanes), f32 = Float(32, lanes);
+    string bits_name = unique_name('h');
+    Expr bits = Variable::make(u32, bits_name);
+    Expr sign = (bits & make_const(u32, 0x8000)) << 16;
+    Expr shifted = (bits & make_const(u32, 0x7fff)) << 13;
+    Expr exponent = shifted & make_const(u32, 0x0f800000);
+    Expr normal = shifted + make_const(u32, (127 - 15) << 23);
+    Expr inf_or_nan = shifted + make_const(u32, (255 - 31) << 23);
+    // Denormals get renormalized by the float unit.
+    Expr magic = make_const(u32, 113 << 23);
+    Expr denormal = reinterpret(u32, reinterpret(f32, shifted + magic) - reinterpret(f32, magic));
+    Expr result = select(exponent == make_const(u32, 0x0f800000), inf_or_nan,
+                         select(exponent == make_const(u32, 0), denormal, normal));
+    result = reinterpret(f32, result | sign);
+    return codegen(Let::make(bits_name, Cast::make(u32, reinterpret(UInt(16, lanes), e)), result));
+}
+
+Value *CodeGen_LLVM::float32_to_float16(Expr e) {
+    // Round to nearest even, flushing overflow to infinity and
+    // keeping nans quiet.
+    int lanes = e.type().lanes();
+    Halide::Type u32 = UInt(32, lanes), f32 = Float(32, lanes);
+    string bits_name = unique_name('f');
+    Expr bits = Variable::make(u32, bits_name);
+    Expr sign = bits & make_const(u32, 0x80000000);
+    Expr abs_bits = bits ^ sign;
+    Expr overflow = select(abs_bits > make_const(u32, 255 << 23),
+                           make_const(u32, 0x7e00), make_const(u32, 0x7c00));
+    // Numbers too small to be normal halfs get rounded by adding a
+    // magic number in the float unit that puts the half mantissa in
+    // the low bits.
+    Expr magic = make_const(u32, ((127 - 15) + (23 - 10) + 1) << 23);
+    Expr denormal = reinterpret(u32, reinterpret(f32, abs_bits) + reinterpret(f32, magic)) - magic;
+    Expr mantissa_odd = (abs_bits >> 13) & make_const(u32, 1);
+    Expr normal = (abs_bits - make_const(u32, (127 - 15) << 23) +
+                   make_const(u32, 0xfff) + mantissa_odd) >> 13;
+    Expr result = select(abs_bits >= make_const(u32, (127 + 16) << 23), overflow,
+                         select(abs_bits < make_const(u32, 113 << 23), denormal, normal));
+    result = Cast::make(UInt(16, lanes), result | (sign >> 16));
+    result = reinterpret(Float(16, lanes), result);
+    return codegen(Let::make(bits_name, reinterpret(u32, e), result));
+}
+
 void CodeGen_LLVM::visit(const Variable *op) {
     value = sym_get(op->name);
 }
@@ -2984,10 +3107,14 @@ void CodeGen_LLVM::visit(const For *op) {
         // Return success
         return_with_error_code(ConstantInt::get(i32, 0));
 
-        // Move the builder back to the main function and call do_par_for
+        // Move the builder back to the main function and call
+        // do_par_for. The iterations of loops that run async
+        // producers concurrently with their consumers each need
+        // their own thread, so those go to do_async instead.
         builder->restoreIP(call_site);
-        llvm::Function *do_par_for = module->getFunction("halide_do_par_for");
-        internal_assert(do_par_for) << "Could not find halide_do_par_for in initial module\n";
+        const char *do_par_for_name = is_async_loop_var(op->name) ? "halide_do_async" : "halide_do_par_for";
+        llvm::Function *do_par_for = module->getFunction(do_par_for_name);
+        internal_assert(do_par_for) << "Could not find " << do_par_for_name << " in initial module\n";
         do_par_for->setDoesNotAlias(5);
         //do_par_for->setDoesNotCapture(5);
         ptr = builder->CreatePointerCast(ptr, i8->getPointerTo());
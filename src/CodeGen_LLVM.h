@@ -392,6 +392,15 @@ protected:
     /** Concatenate a bunch of llvm vectors. Must be of the same type. */
     llvm::Value *concat_vectors(const std::vector<llvm::Value *> &);
 
+    /** Convert a Float(16) Expr to Float(32), or a Float(32) Expr to
+     * Float(16) rounding to nearest even. The default versions work
+     * on the bits with integer operations, which vectorize on any
+     * target. Targets with hardware conversions override them. */
+    // @{
+    virtual llvm::Value *float16_to_float32(Expr e);
+    virtual llvm::Value *float32_to_float16(Expr e);
+    // @}
+
     /** Go looking for a vector version of a runtime function. Will
      * return the best match. Matches in the following order:
      *
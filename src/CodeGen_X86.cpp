@@ -598,6 +598,39 @@ void CodeGen_X86::visit(const Max *op) {
     }
 }
 
+Value *CodeGen_X86::float16_to_float32(Expr e) {
+    if (!target.has_feature(Target::F16C)) {
+        return CodeGen_Posix::float16_to_float32(e);
+    }
+
+    int lanes = e.type().lanes();
+    if (lanes == 1) {
+        // llvm selects vcvtph2ps for scalar conversions itself when
+        // f16c is enabled.
+        return builder->CreateFPExt(codegen(e), llvm_type_of(Float(32)));
+    }
+
+    Value *bits = codegen(reinterpret(UInt(16, lanes), e));
+    return call_intrin(llvm_type_of(Float(32, lanes)), 8, "llvm.x86.vcvtph2ps.256", {bits});
+}
+
+Value *CodeGen_X86::float32_to_float16(Expr e) {
+    if (!target.has_feature(Target::F16C)) {
+        return CodeGen_Posix::float32_to_float16(e);
+    }
+
+    int lanes = e.type().lanes();
+    if (lanes == 1) {
+        return builder->CreateFPTrunc(codegen(e), llvm_type_of(Float(16)));
+    }
+
+    // The immediate selects round-to-nearest-even.
+    Value *rounding = ConstantInt::get(i32, 0);
+    Value *bits = call_intrin(llvm_type_of(UInt(16, lanes)), 8, "llvm.x86.vcvtps2ph.256",
+                              {codegen(e), rounding});
+    return builder->CreateBitCast(bits, llvm_type_of(Float(16, lanes)));
+}
+
 string CodeGen_X86::mcpu() const {
     if (target.has_feature(Target::AVX)) return "corei7-avx";
     // We want SSE4.1 but not SSE4.2, hence "penryn" rather than "corei7"
@@ -47,6 +47,12 @@ protected:
     void visit(const NE *);
     void visit(const Select *);
     // @}
+
+    /** Use the f16c conversion instructions if we have them. */
+    // @{
+    llvm::Value *float16_to_float32(Expr e);
+    llvm::Value *float32_to_float16(Expr e);
+    // @}
 };
 
 }}
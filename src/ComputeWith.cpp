@@ -0,0 +1,292 @@
+#include <algorithm>
+
+#include "ComputeWith.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Debug.h"
+#include "Var.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+using std::set;
+using std::map;
+
+namespace {
+
+// Find a call to any of a set of functions.
+class CallsAnyOf : public IRVisitor {
+    const set<string> &names;
+
+    using IRVisitor::visit;
+
+    void visit(const Call *op) {
+        IRVisitor::visit(op);
+        if (op->call_type == Call::Halide && names.count(op->name)) {
+            result = op->name;
+        }
+    }
+public:
+    string result;
+    CallsAnyOf(const set<string> &n) : names(n) {}
+};
+
+// Strip off the lets, asserts, and evaluated statements (e.g. from
+// profiling) that wrap a loop in a produce step. Returns the
+// statement inside them.
+Stmt peel_wrappers(Stmt s, vector<Stmt> &wrappers) {
+    while (true) {
+        if (const LetStmt *let = s.as<LetStmt>()) {
+            wrappers.push_back(s);
+            s = let->body;
+        } else if (const Block *b = s.as<Block>()) {
+            if (!b->first.as<AssertStmt>() && !b->first.as<Evaluate>()) break;
+            wrappers.push_back(s);
+            s = b->rest;
+        } else {
+            break;
+        }
+    }
+    return s;
+}
+
+// Put back the wrappers removed by peel_wrappers around a new statement.
+Stmt rewrap(Stmt s, const vector<Stmt> &wrappers) {
+    for (size_t i = wrappers.size(); i > 0; i--) {
+        const Stmt &w = wrappers[i-1];
+        if (const LetStmt *let = w.as<LetStmt>()) {
+            s = LetStmt::make(let->name, let->value, s);
+        } else {
+            const Block *b = w.as<Block>();
+            internal_assert(b);
+            s = Block::make(b->first, s);
+        }
+    }
+    return s;
+}
+
+class FuseComputeWith : public IRMutator {
+    Function first, second;
+    const vector<string> &dims;
+
+    // The function whose pipeline is entered first, and the one
+    // nested inside its consume step.
+    string outer, inner;
+
+    // Pipelines entered between outer and inner.
+    set<string> enclosing;
+
+    Stmt inner_produce, inner_realize;
+
+    Stmt fuse_loops(Stmt a, Stmt b, size_t level, Expr a_cond, Expr b_cond) {
+        if (level == dims.size()) {
+            return Block::make(IfThenElse::make(a_cond, a),
+                               IfThenElse::make(b_cond, b));
+        }
+
+        vector<Stmt> a_wrappers, b_wrappers;
+        a = peel_wrappers(a, a_wrappers);
+        b = peel_wrappers(b, b_wrappers);
+
+        const For *fa = a.as<For>();
+        const For *fb = b.as<For>();
+        user_assert(fa && fa->name == outer + ".s0." + dims[level] &&
+                    fb && fb->name == inner + ".s0." + dims[level])
+            << "Can't compute " << first.name() << " with " << second.name()
+            << " because their loops over " << dims[level]
+            << " are not perfectly nested. Both Funcs must be computed by a"
+            << " plain loop nest down to the loop level they are fused at.\n";
+
+        // The fused loop covers both ranges. Each body only runs
+        // within its own range.
+        Expr var = Variable::make(Int(32), fa->name);
+        a_cond = a_cond && fa->min <= var && var < fa->min + fa->extent;
+        b_cond = b_cond && fb->min <= var && var < fb->min + fb->extent;
+
+        Stmt body = fuse_loops(fa->body, fb->body, level + 1, a_cond, b_cond);
+        body = LetStmt::make(fb->name, var, body);
+
+        Expr min = Min::make(fa->min, fb->min);
+        Expr max = Max::make(fa->min + fa->extent, fb->min + fb->extent);
+        Stmt s = For::make(fa->name, min, max - min, fa->for_type, fa->device_api, body);
+
+        // The lets from both loop nests are independent of each
+        // other. Put the ones for the outer function innermost, so
+        // that any profiling marker it carries is the last one set.
+        s = rewrap(s, a_wrappers);
+        s = rewrap(s, b_wrappers);
+        return s;
+    }
+
+    using IRMutator::visit;
+
+    void visit(const ProducerConsumer *op) {
+        if (outer.empty() && (op->name == first.name() || op->name == second.name())) {
+            outer = op->name;
+            inner = (outer == first.name()) ? second.name() : first.name();
+            enclosing.insert(outer);
+
+            Stmt consume = mutate(op->consume);
+            user_assert(inner_produce.defined())
+                << "Can't compute " << first.name() << " with " << second.name()
+                << " because " << inner << " is not computed within the consumer of "
+                << outer << ".\n";
+
+            Stmt produce = fuse_loops(op->produce, inner_produce, 0, const_true(), const_true());
+            stmt = ProducerConsumer::make(op->name, produce, op->update, consume);
+
+            // The storage for the inner function must now enclose
+            // the fused production.
+            if (const Realize *r = inner_realize.as<Realize>()) {
+                stmt = Realize::make(r->name, r->types, r->bounds, r->condition, stmt);
+            }
+
+            outer.clear();
+            inner.clear();
+            enclosing.clear();
+            inner_produce = inner_realize = Stmt();
+            fused++;
+        } else if (!outer.empty() && !inner_produce.defined() && op->name == inner) {
+            CallsAnyOf calls(enclosing);
+            op->produce.accept(&calls);
+            user_assert(calls.result.empty())
+                << "Can't compute " << first.name() << " with " << second.name()
+                << " because " << inner << " uses " << calls.result
+                << ", which would not yet have been computed.\n";
+            inner_produce = op->produce;
+            stmt = mutate(op->consume);
+        } else if (!outer.empty() && !inner_produce.defined()) {
+            enclosing.insert(op->name);
+            IRMutator::visit(op);
+            enclosing.erase(op->name);
+        } else {
+            IRMutator::visit(op);
+        }
+    }
+
+    void visit(const Realize *op) {
+        if (!outer.empty() && !inner_produce.defined() && op->name == inner) {
+            inner_realize = op;
+            stmt = mutate(op->body);
+        } else {
+            IRMutator::visit(op);
+        }
+    }
+
+public:
+    int fused;
+
+    FuseComputeWith(Function f, Function g, const vector<string> &d) :
+        first(f), second(g), dims(d), fused(0) {}
+};
+
+// The names of the loops of a function from the outermost down to the
+// given var, checking that they can be fused with another function.
+vector<string> fused_dims(Function f, Function g, const string &var) {
+    const vector<Dim> &dims = f.schedule().dims();
+    vector<string> result;
+    for (size_t i = dims.size(); i > 0; i--) {
+        const Dim &d = dims[i-1];
+        bool is_outermost = (d.var == Var::outermost().name());
+
+        user_assert(d.for_type == ForType::Serial || d.for_type == ForType::Parallel)
+            << "Can't compute " << f.name() << " with " << g.name() << " at " << var
+            << " because the loop over " << d.var << " is not serial or parallel.\n";
+
+        // The fused loops must run over the coordinates of the
+        // function directly, so that one function's loop variable
+        // can be substituted for the other's.
+        if (!is_outermost) {
+            const vector<string> &args = f.args();
+            user_assert(std::find(args.begin(), args.end(), d.var) != args.end())
+                << "Can't compute " << f.name() << " with " << g.name() << " at " << var
+                << " because the loop over " << d.var << " is not a pure variable of "
+                << f.name() << ".\n";
+            for (const Split &s : f.schedule().splits()) {
+                user_assert(s.old_var != d.var && s.outer != d.var && s.inner != d.var)
+                    << "Can't compute " << f.name() << " with " << g.name() << " at " << var
+                    << " because the loop over " << d.var << " has been split, fused, or renamed.\n";
+            }
+        }
+
+        result.push_back(d.var);
+        if (d.var == var) {
+            return result;
+        }
+    }
+    user_error << "Can't compute " << f.name() << " with " << g.name() << " at " << var
+               << " because " << f.name() << " has no loop over " << var << ".\n";
+    return result;
+}
+
+void validate_compute_with(Function f, Function g) {
+    for (Function h : {f, g}) {
+        user_assert(!h.has_update_definition())
+            << "Can't compute " << f.name() << " with " << g.name()
+            << " because " << h.name() << " has an update definition.\n";
+        user_assert(!h.has_extern_definition())
+            << "Can't compute " << f.name() << " with " << g.name()
+            << " because " << h.name() << " is an extern stage.\n";
+        user_assert(h.schedule().specializations().empty())
+            << "Can't compute " << f.name() << " with " << g.name()
+            << " because " << h.name() << " has specializations.\n";
+        user_assert(!h.schedule().memoized() && !h.schedule().async())
+            << "Can't compute " << f.name() << " with " << g.name()
+            << " because " << h.name() << " is memoized or async.\n";
+        user_assert(!h.schedule().compute_level().is_inline())
+            << "Can't compute " << f.name() << " with " << g.name()
+            << " because " << h.name() << " is scheduled inline.\n";
+    }
+    user_assert(f.schedule().compute_level() == g.schedule().compute_level())
+        << "Can't compute " << f.name() << " with " << g.name()
+        << " because they are computed at different loop levels.\n";
+}
+
+}
+
+Stmt fuse_compute_with(Stmt s, const map<string, Function> &env) {
+    for (const std::pair<string, Function> &p : env) {
+        Function f = p.second;
+        const LoopLevel &with = f.schedule().compute_with();
+        if (with.is_inline()) continue;
+
+        map<string, Function>::const_iterator iter = env.find(with.func);
+        user_assert(iter != env.end())
+            << "Func " << f.name() << " is scheduled to be computed with "
+            << with.func << ", which is not used in this pipeline.\n";
+        Function g = iter->second;
+        user_assert(!f.same_as(g))
+            << "Func " << f.name() << " can't be computed with itself.\n";
+
+        validate_compute_with(f, g);
+        vector<string> dims = fused_dims(f, g, with.var);
+        vector<string> other_dims = fused_dims(g, f, with.var);
+        user_assert(dims == other_dims)
+            << "Can't compute " << f.name() << " with " << g.name()
+            << " because their loops down to " << with.var
+            << " are not the same.\n";
+        for (size_t i = 0; i < dims.size(); i++) {
+            const Dim &a = f.schedule().dims()[f.schedule().dims().size() - 1 - i];
+            const Dim &b = g.schedule().dims()[g.schedule().dims().size() - 1 - i];
+            user_assert(a.for_type == b.for_type && a.device_api == b.device_api)
+                << "Can't compute " << f.name() << " with " << g.name()
+                << " because their loops over " << dims[i]
+                << " are scheduled differently.\n";
+        }
+
+        debug(3) << "Fusing loop nests of " << f.name() << " and " << g.name()
+                 << " down to " << with.var << "\n";
+        FuseComputeWith fuser(f, g, dims);
+        s = fuser.mutate(s);
+        user_assert(fuser.fused > 0)
+            << "Couldn't compute " << f.name() << " with " << g.name()
+            << ". A Func may only be computed with a Func that is itself"
+            << " computed by its own loop nest.\n";
+    }
+    return s;
+}
+
+}
+}
@@ -0,0 +1,27 @@
+#ifndef HALIDE_COMPUTE_WITH_H
+#define HALIDE_COMPUTE_WITH_H
+
+/** \file
+ *
+ * Defines the lowering pass that fuses the loop nests of Funcs
+ * scheduled with Func::compute_with.
+ */
+
+#include <map>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Merge the loop nests of each pair of functions related by
+ * compute_with into a single loop nest, down to and including the
+ * chosen loop level. Each fused loop covers the union of the two
+ * original ranges, and each body is guarded to run only within its
+ * own range. Must be run after bounds inference. */
+Stmt fuse_compute_with(Stmt s, const std::map<std::string, Function> &env);
+
+}
+}
+
+#endif
@@ -0,0 +1,510 @@
+#include <algorithm>
+#include <sstream>
+
+#include "CostReport.h"
+#include "Bounds.h"
+#include "BoundsInference.h"
+#include "ComputeWith.h"
+#include "Debug.h"
+#include "FindCalls.h"
+#include "Function.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRPrinter.h"
+#include "RealizationOrder.h"
+#include "RemoveUndef.h"
+#include "ScheduleFunctions.h"
+#include "Simplify.h"
+#include "SlidingWindow.h"
+
+namespace Halide {
+
+using std::map;
+using std::string;
+using std::vector;
+using std::ostringstream;
+
+int64_t FuncCost::total_ops() const {
+    int64_t total = 0;
+    for (const auto &i : ops) {
+        total += i.second;
+    }
+    return total;
+}
+
+double FuncCost::recompute_factor() const {
+    if (points_required == 0) return 0;
+    return (double)points_computed / points_required;
+}
+
+const FuncCost &CostReport::func(const string &name) const {
+    for (const FuncCost &f : funcs) {
+        if (f.name == name) return f;
+    }
+    user_error << "No Func called " << name << " in cost report.\n";
+    return funcs[0];
+}
+
+string CostReport::to_string() const {
+    ostringstream s;
+    for (const FuncCost &f : funcs) {
+        s << f.name << ":\n";
+        s << "  ops:";
+        if (f.ops.empty()) s << " none";
+        for (const auto &i : f.ops) {
+            s << " " << i.first << " " << i.second;
+        }
+        s << "\n  loads:";
+        if (f.loads.empty()) s << " none";
+        for (const auto &i : f.loads) {
+            s << " " << i.first << " " << i.second;
+        }
+        s << "\n  stores: " << f.stores << "\n";
+        if (f.points_required) {
+            s << "  points computed: " << f.points_computed
+              << ", distinct: " << f.points_required
+              << ", recompute factor: " << f.recompute_factor() << "\n";
+        }
+        for (const FuncCost::Allocation &a : f.allocations) {
+            s << "  allocation: " << a.bytes << " bytes at " << a.loop_level
+              << ", " << a.count << " times\n";
+        }
+    }
+    for (const string &l : unbounded_loops) {
+        s << "Warning: could not bound the extent of loop " << l << "\n";
+    }
+    return s.str();
+}
+
+void StmtProfile::add_profiler_results(const halide_profiler_state *state,
+                                       const string &pipeline_name) {
+    if (!state) return;
+    for (const halide_profiler_pipeline_stats *p = state->pipelines; p;
+         p = (const halide_profiler_pipeline_stats *)(p->next)) {
+        if (!pipeline_name.empty() && pipeline_name != p->name) continue;
+        for (int i = 0; i < p->num_funcs; i++) {
+            func_time[p->funcs[i].name] += p->funcs[i].time;
+        }
+    }
+}
+
+namespace Internal {
+
+namespace {
+
+// Replace the size of the outputs, the fields of bound images, and
+// scalar parameters with their values.
+class BindSizes : public IRMutator {
+    using IRMutator::visit;
+
+    const map<string, Expr> &output_sizes;
+
+    // Get the value of a variable like "input.extent.1".
+    Expr buffer_field(const string &name, Buffer b) {
+        size_t dot = name.rfind('.');
+        if (dot == string::npos || dot == 0) return Expr();
+        size_t prev = name.rfind('.', dot - 1);
+        if (prev == string::npos) return Expr();
+        string field = name.substr(prev + 1, dot - prev - 1);
+        string dim = name.substr(dot + 1);
+        if (dim.empty() || dim.find_first_not_of("0123456789") != string::npos) return Expr();
+        int d = atoi(dim.c_str());
+        if (d >= b.dimensions()) return Expr();
+        if (field == "min") return b.min(d);
+        if (field == "extent") return b.extent(d);
+        if (field == "stride") return b.stride(d);
+        return Expr();
+    }
+
+    void visit(const Variable *op) {
+        map<string, Expr>::const_iterator iter = output_sizes.find(op->name);
+        if (iter != output_sizes.end()) {
+            expr = iter->second;
+            return;
+        }
+        Buffer b = op->image;
+        if (op->param.defined()) {
+            if (!op->param.is_buffer()) {
+                if (!op->type.is_handle()) {
+                    expr = op->param.get_scalar_expr();
+                } else {
+                    expr = op;
+                }
+                return;
+            }
+            b = op->param.get_buffer();
+        }
+        if (b.defined()) {
+            Expr e = buffer_field(op->name, b);
+            if (e.defined()) {
+                expr = e;
+                return;
+            }
+        }
+        expr = op;
+    }
+
+public:
+    BindSizes(const map<string, Expr> &s) : output_sizes(s) {}
+};
+
+// Substitute in the values of enclosing lets, which are stored in
+// terms of the enclosing loop variables only. Undefined values mark
+// names that shouldn't be substituted.
+class ExpandLets : public IRMutator {
+    using IRMutator::visit;
+
+    const Scope<Expr> &lets;
+    Scope<int> shadowed;
+
+    void visit(const Variable *op) {
+        if (!shadowed.contains(op->name) && lets.contains(op->name)) {
+            Expr e = lets.get(op->name);
+            if (e.defined()) {
+                expr = e;
+                return;
+            }
+        }
+        expr = op;
+    }
+
+    void visit(const Let *op) {
+        Expr value = mutate(op->value);
+        shadowed.push(op->name, 0);
+        Expr body = mutate(op->body);
+        shadowed.pop(op->name);
+        expr = Let::make(op->name, value, body);
+    }
+
+    void visit(const LetStmt *op) {
+        Expr value = mutate(op->value);
+        shadowed.push(op->name, 0);
+        Stmt body = mutate(op->body);
+        shadowed.pop(op->name);
+        stmt = LetStmt::make(op->name, value, body);
+    }
+
+    void visit(const For *op) {
+        Expr min = mutate(op->min);
+        Expr extent = mutate(op->extent);
+        shadowed.push(op->name, 0);
+        Stmt body = mutate(op->body);
+        shadowed.pop(op->name);
+        stmt = For::make(op->name, min, extent, op->for_type, op->device_api, body);
+    }
+
+public:
+    ExpandLets(const Scope<Expr> &l) : lets(l) {}
+};
+
+// Count the arithmetic and loads in evaluating one site of a
+// definition.
+class CountOps : public IRVisitor {
+    using IRVisitor::visit;
+
+    void op(Type t) {
+        ostringstream s;
+        s << t.element_of();
+        ops[s.str()] += t.lanes();
+    }
+
+    void visit(const Add *o) {IRVisitor::visit(o); op(o->type);}
+    void visit(const Sub *o) {IRVisitor::visit(o); op(o->type);}
+    void visit(const Mul *o) {IRVisitor::visit(o); op(o->type);}
+    void visit(const Div *o) {IRVisitor::visit(o); op(o->type);}
+    void visit(const Mod *o) {IRVisitor::visit(o); op(o->type);}
+    void visit(const Min *o) {IRVisitor::visit(o); op(o->type);}
+    void visit(const Max *o) {IRVisitor::visit(o); op(o->type);}
+    void visit(const EQ *o) {IRVisitor::visit(o); op(o->a.type());}
+    void visit(const NE *o) {IRVisitor::visit(o); op(o->a.type());}
+    void visit(const LT *o) {IRVisitor::visit(o); op(o->a.type());}
+    void visit(const LE *o) {IRVisitor::visit(o); op(o->a.type());}
+    void visit(const GT *o) {IRVisitor::visit(o); op(o->a.type());}
+    void visit(const GE *o) {IRVisitor::visit(o); op(o->a.type());}
+    void visit(const And *o) {IRVisitor::visit(o); op(o->type);}
+    void visit(const Or *o) {IRVisitor::visit(o); op(o->type);}
+    void visit(const Not *o) {IRVisitor::visit(o); op(o->type);}
+    void visit(const Select *o) {IRVisitor::visit(o); op(o->type);}
+    void visit(const Cast *o) {IRVisitor::visit(o); op(o->type);}
+
+    void visit(const Call *o) {
+        IRVisitor::visit(o);
+        if (o->call_type == Call::Halide || o->call_type == Call::Image) {
+            loads[o->name] += o->type.lanes();
+        } else {
+            op(o->type);
+        }
+    }
+
+public:
+    map<string, int64_t> ops, loads;
+};
+
+class CountCosts : public IRVisitor {
+    using IRVisitor::visit;
+
+    // The values of enclosing lets, and the bounds of enclosing loop
+    // variables.
+    Scope<Expr> lets;
+    Scope<Interval> loops;
+    vector<string> loop_levels;
+
+    // The pure definitions currently being computed.
+    Scope<int> pure;
+
+    // The number of times the current statement runs.
+    int64_t trips;
+
+    Expr expand(Expr e) {
+        return simplify(ExpandLets(lets).mutate(e));
+    }
+
+    // Get a constant upper bound for an expression over all
+    // iterations of the enclosing loops.
+    bool upper_bound(Expr e, int64_t &result) {
+        Interval i = bounds_of_expr_in_scope(expand(e), loops);
+        if (!i.max.defined()) return false;
+        const int64_t *c = as_const_int(simplify(i.max));
+        if (!c) return false;
+        result = *c;
+        return true;
+    }
+
+    FuncCost &cost(const string &name) {
+        FuncCost &c = costs[name];
+        c.name = name;
+        return c;
+    }
+
+    void visit(const LetStmt *op) {
+        lets.push(op->name, expand(op->value));
+        op->body.accept(this);
+        lets.pop(op->name);
+    }
+
+    void visit(const For *op) {
+        int64_t extent = 1;
+        if (!upper_bound(op->extent, extent)) {
+            if (std::find(unbounded_loops.begin(), unbounded_loops.end(), op->name) ==
+                unbounded_loops.end()) {
+                unbounded_loops.push_back(op->name);
+            }
+        }
+        extent = std::max(extent, (int64_t)0);
+
+        Interval min = bounds_of_expr_in_scope(expand(op->min), loops);
+        Interval var(min.min, Expr());
+        if (min.max.defined()) {
+            var.max = simplify(min.max + (int)extent - 1);
+        }
+
+        loop_iterations[op->name] += trips * extent;
+
+        lets.push(op->name, Expr());
+        loops.push(op->name, var);
+        loop_levels.push_back(op->name);
+        int64_t old_trips = trips;
+        trips *= extent;
+        op->body.accept(this);
+        trips = old_trips;
+        loop_levels.pop_back();
+        loops.pop(op->name);
+        lets.pop(op->name);
+    }
+
+    void visit(const ProducerConsumer *op) {
+        // The distinct points computed are the union of the regions
+        // computed over every iteration of the enclosing loops.
+        Box b = box_provided(ExpandLets(lets).mutate(op->produce), op->name, loops);
+        int64_t points = b.empty() ? 0 : 1;
+        for (size_t i = 0; i < b.size(); i++) {
+            const int64_t *extent = NULL;
+            if (b[i].min.defined() && b[i].max.defined()) {
+                extent = as_const_int(simplify(b[i].max - b[i].min + 1));
+            }
+            points = extent ? points * std::max(*extent, (int64_t)0) : 0;
+        }
+        FuncCost &c = cost(op->name);
+        c.points_required = std::max(c.points_required, points);
+
+        pure.push(op->name, 0);
+        op->produce.accept(this);
+        pure.pop(op->name);
+        if (op->update.defined()) {
+            op->update.accept(this);
+        }
+        op->consume.accept(this);
+    }
+
+    void visit(const Provide *op) {
+        CountOps count;
+        for (Expr v : op->values) {
+            v.accept(&count);
+        }
+        for (Expr a : op->args) {
+            a.accept(&count);
+        }
+        FuncCost &c = cost(op->name);
+        for (const auto &i : count.ops) {
+            c.ops[i.first] += i.second * trips;
+        }
+        for (const auto &i : count.loads) {
+            c.loads[i.first] += i.second * trips;
+        }
+        c.stores += trips * op->values.size();
+        if (pure.contains(op->name)) {
+            c.points_computed += trips;
+        }
+    }
+
+    void visit(const Realize *op) {
+        int64_t elems = 1;
+        for (const Range &r : op->bounds) {
+            int64_t extent = 0;
+            if (!upper_bound(r.extent, extent)) {
+                elems = 0;
+                break;
+            }
+            elems *= std::max(extent, (int64_t)0);
+        }
+        int64_t bytes = 0;
+        for (Type t : op->types) {
+            bytes += elems * t.bytes();
+        }
+
+        string level = loop_levels.empty() ? "root" : loop_levels.back();
+        FuncCost &c = cost(op->name);
+        bool found = false;
+        for (FuncCost::Allocation &a : c.allocations) {
+            if (a.loop_level == level) {
+                a.bytes = std::max(a.bytes, bytes);
+                a.count += trips;
+                found = true;
+            }
+        }
+        if (!found) {
+            FuncCost::Allocation a = {level, bytes, trips};
+            c.allocations.push_back(a);
+        }
+
+        op->body.accept(this);
+    }
+
+    void visit(const IfThenElse *op) {
+        Expr cond = expand(op->condition);
+        if (is_one(cond)) {
+            op->then_case.accept(this);
+            return;
+        } else if (is_zero(cond)) {
+            if (op->else_case.defined()) {
+                op->else_case.accept(this);
+            }
+            return;
+        } else if (!op->else_case.defined()) {
+            op->then_case.accept(this);
+            return;
+        }
+
+        // We don't know which way it goes, so count whichever branch
+        // does more work. The loops of the other branch are dropped
+        // along with its costs.
+        map<string, FuncCost> before = costs;
+        vector<string> unbounded_before = unbounded_loops;
+        map<string, int64_t> iterations_before = loop_iterations;
+        op->then_case.accept(this);
+        map<string, FuncCost> then_costs = costs;
+        vector<string> then_unbounded = unbounded_loops;
+        map<string, int64_t> then_iterations = loop_iterations;
+        costs.swap(before);
+        unbounded_loops.swap(unbounded_before);
+        loop_iterations.swap(iterations_before);
+        op->else_case.accept(this);
+        if (total_work(then_costs) > total_work(costs)) {
+            costs.swap(then_costs);
+            unbounded_loops.swap(then_unbounded);
+            loop_iterations.swap(then_iterations);
+        }
+    }
+
+    static int64_t total_work(const map<string, FuncCost> &c) {
+        int64_t total = 0;
+        for (const auto &i : c) {
+            total += i.second.total_ops() + i.second.stores;
+            for (const auto &l : i.second.loads) {
+                total += l.second;
+            }
+        }
+        return total;
+    }
+
+public:
+    map<string, FuncCost> costs;
+    vector<string> unbounded_loops;
+    map<string, int64_t> loop_iterations;
+
+    CountCosts() : trips(1) {}
+};
+
+}  // namespace
+
+CostReport analyze_costs(const vector<Function> &outputs,
+                         const vector<int32_t> &sizes,
+                         const Target &target) {
+    map<string, Function> env;
+    for (Function f : outputs) {
+        map<string, Function> more_funcs = find_transitive_calls(f);
+        env.insert(more_funcs.begin(), more_funcs.end());
+    }
+    vector<string> order = realization_order(outputs, env);
+
+    // Mirror the first stages of lowering, up to the point where the
+    // region computed of each function is final.
+    bool any_memoized = false;
+    Stmt s = schedule_functions(outputs, order, env, target, any_memoized);
+    FuncValueBounds func_bounds = compute_function_value_bounds(order, env);
+    s = bounds_inference(s, outputs, order, env, func_bounds);
+    s = fuse_compute_with(s, env);
+    s = sliding_window(s, env);
+    s = remove_undef(s);
+
+    map<string, Expr> output_sizes;
+    for (Function f : outputs) {
+        user_assert((int)sizes.size() == f.dimensions())
+            << "Can't analyze the costs of " << f.name() << ", which has "
+            << f.dimensions() << " dimensions, for an output with "
+            << sizes.size() << " dimensions.\n";
+        for (int k = 0; k < f.outputs(); k++) {
+            string buffer_name = f.name();
+            if (f.outputs() > 1) {
+                buffer_name += "." + std::to_string(k);
+            }
+            int stride = 1;
+            for (int d = 0; d < f.dimensions(); d++) {
+                string dim = std::to_string(d);
+                output_sizes[buffer_name + ".min." + dim] = 0;
+                output_sizes[buffer_name + ".extent." + dim] = sizes[d];
+                output_sizes[buffer_name + ".stride." + dim] = stride;
+                stride *= sizes[d];
+            }
+        }
+    }
+    s = BindSizes(output_sizes).mutate(s);
+    debug(2) << "Statement analyzed for costs:\n" << s << "\n";
+
+    CountCosts counter;
+    s.accept(&counter);
+
+    CostReport report;
+    for (const string &name : order) {
+        map<string, FuncCost>::const_iterator iter = counter.costs.find(name);
+        if (iter != counter.costs.end()) {
+            report.funcs.push_back(iter->second);
+        }
+    }
+    report.unbounded_loops = counter.unbounded_loops;
+    report.loop_iterations = counter.loop_iterations;
+    return report;
+}
+
+}
+}
@@ -0,0 +1,126 @@
+#ifndef HALIDE_COST_REPORT_H
+#define HALIDE_COST_REPORT_H
+
+/** \file
+ *
+ * Defines a static estimate of the work a schedule does, derived from
+ * bounds inference without running the pipeline, and the performance
+ * data used to annotate lowered code.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "IR.h"
+#include "Target.h"
+#include "runtime/HalideRuntime.h"
+
+namespace Halide {
+
+/** The work done by one Func in a pipeline, counted statically for
+ * concrete output sizes. Vectorized loops are counted per lane. */
+struct FuncCost {
+    std::string name;
+
+    /** Arithmetic operations done while computing the Func, keyed by
+     * the type they operate on (e.g. "float32"). */
+    std::map<std::string, int64_t> ops;
+
+    /** Values loaded while computing the Func, keyed by the Func or
+     * image they are loaded from. */
+    std::map<std::string, int64_t> loads;
+
+    /** Values stored to the Func, over all of its definitions. */
+    int64_t stores;
+
+    /** The number of points of the pure definition computed, summed
+     * over every realization, and the number of distinct points among
+     * them. Both are zero for extern Funcs. */
+    int64_t points_computed, points_required;
+
+    /** An allocation of the Func, at the loop level it is stored
+     * at. */
+    struct Allocation {
+        std::string loop_level;
+        int64_t bytes;
+        /** The number of times the allocation is made. */
+        int64_t count;
+    };
+    std::vector<Allocation> allocations;
+
+    FuncCost() : stores(0), points_computed(0), points_required(0) {}
+
+    /** The total number of arithmetic operations, of any type. */
+    EXPORT int64_t total_ops() const;
+
+    /** The number of times each point of the pure definition is
+     * computed on average. One if there is no redundant recompute
+     * from overlapping compute_at regions. */
+    EXPORT double recompute_factor() const;
+};
+
+/** The costs of every Func in a pipeline. */
+struct CostReport {
+    /** One entry per Func that is not inlined, in realization order. */
+    std::vector<FuncCost> funcs;
+
+    /** Loops whose extent depends on something other than the output
+     * size, bound images, and scalar parameter values. They are counted
+     * as having one iteration. */
+    std::vector<std::string> unbounded_loops;
+
+    /** The total number of iterations of each loop, by name, summed
+     * over every time the loop runs. Like the costs, this only counts
+     * the branch that does more work wherever a condition can't be
+     * resolved. */
+    std::map<std::string, int64_t> loop_iterations;
+
+    /** Get the costs of a Func by name. */
+    EXPORT const FuncCost &func(const std::string &name) const;
+
+    /** Format the report as a human-readable table. */
+    EXPORT std::string to_string() const;
+};
+
+/** Performance data to annotate an HTML rendering of lowered code
+ * with (see Pipeline::compile_to_lowered_stmt). Either part may be
+ * left empty. */
+struct StmtProfile {
+    /** Time spent computing each Func, by name, in any unit. */
+    std::map<std::string, double> func_time;
+
+    /** A static cost report for the pipeline (see
+     * Pipeline::analyze). Gives loop trip counts and allocation sizes,
+     * and if there are no times, each Func's share of the work. */
+    CostReport costs;
+
+    StmtProfile() {}
+    StmtProfile(const CostReport &c) : costs(c) {}
+
+    /** Add the times recorded by the profiler (see Target::Profile) for
+     * the pipeline with the given name, or for every pipeline if the
+     * name is empty. Get the state from halide_profiler_get_state(),
+     * or for JIT-compiled pipelines from
+     * Internal::JITSharedRuntime::profiler_state(), once the pipelines
+     * have finished running. */
+    EXPORT void add_profiler_results(const halide_profiler_state *state,
+                                     const std::string &pipeline_name = "");
+};
+
+namespace Internal {
+
+/** Lower the pipeline defined by the given outputs as far as bounds
+ * inference and sliding window, set the outputs to the given size,
+ * and count the work done by each function. Scalar parameters take
+ * their current values, and image parameters the size of the
+ * buffers bound to them. */
+CostReport analyze_costs(const std::vector<Function> &outputs,
+                         const std::vector<int32_t> &sizes,
+                         const Target &target);
+
+}
+
+}
+
+#endif
@@ -861,6 +861,19 @@ Func &Func::memoize() {
     return *this;
 }
 
+Func &Func::memoize_by_content() {
+    invalidate_cache();
+    func.schedule().memoized() = true;
+    func.schedule().memoize_hash_buffers() = true;
+    return *this;
+}
+
+Func &Func::async() {
+    invalidate_cache();
+    func.schedule().async() = true;
+    return *this;
+}
+
 Stage Func::specialize(Expr c) {
     invalidate_cache();
     return Stage(func.schedule(), name()).specialize(c);
@@ -927,6 +940,29 @@ Func &Func::bound(Var var, Expr min, Expr extent) {
     return *this;
 }
 
+Func &Func::estimate(Var var, Expr min, Expr extent) {
+    invalidate_cache();
+    bool found = false;
+    for (size_t i = 0; i < func.args().size(); i++) {
+        if (var.name() == func.args()[i]) {
+            found = true;
+        }
+    }
+    user_assert(found)
+        << "Can't provide an estimate for variable " << var.name()
+        << " of function " << name()
+        << " because " << var.name()
+        << " is not one of the pure variables of " << name() << ".\n";
+    user_assert(as_const_int(min) && as_const_int(extent))
+        << "The estimate for variable " << var.name()
+        << " of function " << name()
+        << " must have a constant min and extent.\n";
+
+    Bound b = {var.name(), min, extent};
+    func.schedule().estimates().push_back(b);
+    return *this;
+}
+
 Func &Func::tile(VarOrRVar x, VarOrRVar y,
                  VarOrRVar xo, VarOrRVar yo,
                  VarOrRVar xi, VarOrRVar yi,
@@ -1135,6 +1171,22 @@ Func &Func::store_root() {
     return *this;
 }
 
+Func &Func::slide_in_strips(Expr strip_size) {
+    invalidate_cache();
+    user_assert(strip_size.defined() &&
+                (strip_size.type().is_int() || strip_size.type().is_uint()))
+        << "The strip size passed to slide_in_strips for Func " << name()
+        << " must be an integer\n";
+    func.schedule().slide_strip_size() = cast<int>(strip_size);
+    return *this;
+}
+
+Func &Func::compute_with(Func f, Var var) {
+    invalidate_cache();
+    func.schedule().compute_with() = LoopLevel(f.name(), var.name());
+    return *this;
+}
+
 Func &Func::compute_inline() {
     invalidate_cache();
     func.schedule().compute_level() = LoopLevel();
@@ -1631,6 +1683,13 @@ void Func::compile_to_lowered_stmt(const string &filename,
     pipeline().compile_to_lowered_stmt(filename, args, fmt, target);
 }
 
+void Func::compile_to_lowered_stmt(const string &filename,
+                                   const vector<Argument> &args,
+                                   const StmtProfile &profile,
+                                   const Target &target) {
+    pipeline().compile_to_lowered_stmt(filename, args, profile, target);
+}
+
 void Func::print_loop_nest() {
     pipeline().print_loop_nest();
 }
@@ -1701,6 +1760,14 @@ void Func::realize(Realization dst, const Target &target) {
     pipeline().realize(dst, target);
 }
 
+BoundRealization Func::bind_realization(Buffer b, const Target &target) {
+    return pipeline().bind_realization(b, target);
+}
+
+BoundRealization Func::bind_realization(Realization dst, const Target &target) {
+    return pipeline().bind_realization(dst, target);
+}
+
 void Func::infer_input_bounds(Buffer dst) {
     pipeline().infer_input_bounds(dst);
 }
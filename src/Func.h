@@ -433,6 +433,15 @@ public:
     }
     // @}
 
+    /** Compile this function and validate it against the given
+     * output buffer or buffers once, returning an object that can
+     * realize into them repeatedly without redoing that work. See
+     * \ref Pipeline::bind_realization */
+    // @{
+    EXPORT BoundRealization bind_realization(Realization dst, const Target &target = Target());
+    EXPORT BoundRealization bind_realization(Buffer dst, const Target &target = Target());
+    // @}
+
     /** For a given size of output, or a given output buffer,
      * determine the bounds required of all unbound ImageParams
      * referenced. Communicates the result by allocating new buffers
@@ -506,6 +515,13 @@ public:
                                         StmtOutputFormat fmt = Text,
                                         const Target &target = get_target_from_environment());
 
+    /** Write out an HTML representation of lowered code annotated
+     * with performance data. See \ref Pipeline::compile_to_lowered_stmt */
+    EXPORT void compile_to_lowered_stmt(const std::string &filename,
+                                        const std::vector<Argument> &args,
+                                        const StmtProfile &profile,
+                                        const Target &target = get_target_from_environment());
+
     /** Write out the loop nests specified by the schedule for this
      * Function. Helpful for understanding what a schedule is
      * doing. */
@@ -688,7 +704,13 @@ public:
      * 5, uint32_t = 6, int32_t = 7, uint64_t = 8, int64_t = 9. The
      * data follows the header, as a densely packed array of the given
      * size and the given type. If given the extension .tmp, this file
-     * format can be natively read by the program ImageStack. */
+     * format can be natively read by the program ImageStack.
+     *
+     * To dump large Funcs at less cost to the pipeline, set
+     * HL_DEBUG_TO_FILE_ASYNC=1 in the environment to write the files on
+     * a background thread, and HL_DEBUG_TO_FILE_COMPRESS=1 to compress
+     * TIFF files (see halide_debug_to_file_set_async and
+     * halide_debug_to_file_set_compression). */
     EXPORT void debug_to_file(const std::string &filename);
 
     /** The name of this function, either given during construction,
@@ -877,6 +899,14 @@ public:
      */
     EXPORT Func &bound(Var var, Expr min, Expr extent);
 
+    /** Tell the auto scheduler roughly what range of a function will
+     * be evaluated, without constraining the generated code the way
+     * \ref Func::bound does. The min and extent must be integer
+     * constants. Estimates are needed on each dimension of the
+     * outputs of a Pipeline that has no bounds on it before calling
+     * \ref Pipeline::auto_schedule */
+    EXPORT Func &estimate(Var var, Expr min, Expr extent);
+
     /** Split two dimensions at once by the given factors, and then
      * reorder the resulting dimensions to be xi, yi, xo, yo from
      * innermost outwards. This gives a tiled traversal. */
@@ -1348,6 +1378,42 @@ public:
      */
     EXPORT Func &memoize();
 
+    /** Like memoize(), but the function may also depend on input
+     * buffers without a memoize_tag: the contents of the ImageParams
+     * and extern stage Images that it depends on are hashed into the
+     * cache key. Where the region of an input read by each
+     * realization can be computed up front, only that region is
+     * hashed, so a Func computed at tile granularity with compute_at
+     * is cached per tile, and only the tiles whose inputs changed are
+     * recomputed. A cached tile is used in place, without copying. An
+     * input that is only reachable through another Func or an extern
+     * stage is hashed in full, once per run of the pipeline.
+     */
+    EXPORT Func &memoize_by_content();
+
+    /** Compute this function on its own thread, concurrently with its
+     * consumer. This requires that the function is stored outside of
+     * a serial loop and computed within it, such that its storage can
+     * be folded into a circular buffer over that loop (see \ref
+     * Func::store_at). The circular buffer is then enlarged so that
+     * the producer can work one iteration ahead of the consumer, and
+     * a pair of semaphores hands iterations back and forth between
+     * the two threads. If the storage can't be folded, the function
+     * is computed synchronously as usual. E.g.
+     *
+     \code
+     Func f, g;
+     Var x, y;
+     f(x, y) = expensive(x, y);
+     g(x, y) = f(x, y-1) + f(x, y+1);
+     f.store_root().compute_at(g, y).async();
+     \endcode
+     *
+     * computes each new row of f on one thread while another thread
+     * computes the previous row of g.
+     */
+    EXPORT Func &async();
+
 
     /** Allocate storage for this function within f's loop over
      * var. Scheduling storage is optional, and can be used to
@@ -1453,6 +1519,60 @@ public:
      * outside the outermost loop. */
     EXPORT Func &store_root();
 
+    /** Sliding window optimization only happens over serial loops,
+     * so if this function is computed at a parallel loop and stored
+     * outside of it, every iteration recomputes the overlap with its
+     * neighbours. This directive instead cuts the parallel loop at
+     * the compute level into strips of the given size. The strips
+     * run in parallel, each with its own storage for this function,
+     * and within a strip the original loop runs serially so that the
+     * sliding window and storage folding optimizations apply. Only
+     * the first iteration of each strip pays for warming up the
+     * window. E.g:
+     *
+     \code
+     Func f, g;
+     Var x, y;
+     g(x, y) = x*y;
+     f(x, y) = g(x, y) + g(x, y+1) + g(x, y+2);
+     f.parallel(y);
+     g.store_root().compute_at(f, y).slide_in_strips(16);
+     \endcode
+     *
+     * computes each row of g once per strip of 16 rows of f, plus
+     * two extra rows at the start of each strip.
+     */
+    EXPORT Func &slide_in_strips(Expr strip_size);
+
+    /** Compute this function in the same loop nest as another
+     * function, from the outermost loop down to and including the
+     * loop over the given var. Both functions must be computed at
+     * the same loop level, and must be traversed by the same pure
+     * variables down to the fused one. Each fused loop runs over
+     * the union of the two functions' ranges, and each function is
+     * only computed within its own range. This is useful when several
+     * consumers read the same producer, or for the outputs of a
+     * multi-output Pipeline, so that each row of the producer is
+     * used by all of them while it's still in cache. E.g:
+     *
+     \code
+     Func f, g, h;
+     Var x, y;
+     f(x, y) = x + y;
+     g(x, y) = f(x, y) * 2;
+     h(x, y) = f(x, y+1) - 1;
+     f.compute_root();
+     Pipeline p({g, h});
+     h.compute_with(g, y);
+     \endcode
+     *
+     * computes g and h in a single loop over y. A function computed
+     * with another must not have an update definition, and must not
+     * depend on the other function or on anything computed between
+     * the two.
+     */
+    EXPORT Func &compute_with(Func f, Var var);
+
     /** Aggressively inline all uses of this function. This is the
      * default schedule, so you're unlikely to need to call this. For
      * a Func with an update definition, that means it gets computed
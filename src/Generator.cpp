@@ -1,4 +1,8 @@
+#include <cstdio>
+#include <fstream>
+
 #include "Generator.h"
+#include "IRHash.h"
 #include "Output.h"
 
 namespace {
@@ -48,14 +52,21 @@ const std::map<std::string, Halide::Type> &get_halide_type_enum_map() {
 
 int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
     const char kUsage[] = "gengen [-g GENERATOR_NAME] [-f FUNCTION_NAME] [-o OUTPUT_DIR] [-r RUNTIME_NAME] [-e EMIT_OPTIONS] "
-                          "target=target-string [generator_arg=value [...]]\n\n"
+                          "[-p PARAMS_FILE] [-c CACHE_DIR] target=target-string [generator_arg=value [...]]\n\n"
                           "  -e  A comma separated list of optional files to emit. Accepted values are "
-                          "[assembly, bitcode, stmt, html]\n";
+                          "[assembly, bitcode, stmt, html]\n"
+                          "  -p  A file of generator_arg=value lines, e.g. as written by the autotuner. "
+                          "Args given on the command line take precedence.\n"
+                          "  -c  An existing directory in which to cache the emitted files. If the generator "
+                          "lowers to the same code as a previous run, its files are copied from the cache "
+                          "instead of being compiled again.\n";
 
     std::map<std::string, std::string> flags_info = { { "-f", "" },
                                                       { "-g", "" },
                                                       { "-o", "" },
                                                       { "-e", "" },
+                                                      { "-p", "" },
+                                                      { "-c", "" },
                                                       { "-r", "" }};
     std::map<std::string, std::string> generator_args;
 
@@ -84,6 +95,12 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
         return 1;
     }
 
+    if (!flags_info["-p"].empty()) {
+        // std::map::insert doesn't replace the args already given.
+        GeneratorParamValues file_args = read_generator_param_file(flags_info["-p"]);
+        generator_args.insert(file_args.begin(), file_args.end());
+    }
+
     std::string runtime_name = flags_info["-r"];
 
     std::vector<std::string> generator_names = GeneratorRegistry::enumerate();
@@ -123,6 +140,7 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
         return 1;
     }
     GeneratorBase::EmitOptions emit_options;
+    emit_options.cache_dir = flags_info["-c"];
     std::vector<std::string> emit_flags = split_string(flags_info["-e"], ",");
     for (const std::string &opt : emit_flags) {
         if (opt == "assembly") {
@@ -158,6 +176,36 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
     return 0;
 }
 
+GeneratorParamValues read_generator_param_file(const std::string &filename) {
+    std::ifstream f(filename.c_str());
+    user_assert(f.is_open()) << "Could not open GeneratorParam file " << filename << "\n";
+    GeneratorParamValues values;
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        size_t eq = line.find('=');
+        user_assert(eq != std::string::npos && eq > 0 && eq + 1 < line.size())
+            << "Malformed line in GeneratorParam file " << filename << ": " << line << "\n";
+        values[line.substr(0, eq)] = line.substr(eq + 1);
+    }
+    return values;
+}
+
+void write_generator_param_file(const std::string &filename,
+                                const GeneratorParamValues &values,
+                                const std::string &comment) {
+    std::ofstream f(filename.c_str());
+    user_assert(f.is_open()) << "Could not open " << filename << " for writing\n";
+    for (const std::string &line : split_string(comment, "\n")) {
+        if (!line.empty()) {
+            f << "# " << line << "\n";
+        }
+    }
+    for (const auto &value : values) {
+        f << value.first << "=" << value.second << "\n";
+    }
+}
+
 GeneratorParamBase::GeneratorParamBase(const std::string &name) : name(name) {
     ObjectInstanceRegistry::register_instance(this, 0, ObjectInstanceRegistry::GeneratorParam,
                                               this, nullptr);
@@ -244,6 +292,7 @@ void GeneratorBase::build_params() {
             filter_arguments.push_back(Argument(param->name(),
                 param->is_buffer() ? Argument::InputBuffer : Argument::InputScalar,
                 param->type(), param->dimensions(), def, min, max));
+            filter_parameters.push_back(*param);
         }
 
         std::vector<void *> vg = ObjectInstanceRegistry::instances_in_range(
@@ -295,6 +344,38 @@ std::vector<Argument> GeneratorBase::get_filter_output_types() {
     return output_types;
 }
 
+namespace {
+
+std::string hex_string(uint64_t h) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+    return buf;
+}
+
+// Key a lowered module for the generator cache. IRHasher covers the
+// lowered code exactly (including the type of every node and the
+// bits of every constant), the target, the signature of each
+// function and the contents of embedded buffers.
+std::string filter_cache_key(const Module &module) {
+    return hex_string(IRHasher().include(module).value());
+}
+
+bool copy_file(const std::string &from, const std::string &to) {
+    std::ifstream in(from.c_str(), std::ios::binary);
+    if (!in.is_open()) return false;
+    std::ofstream out(to.c_str(), std::ios::binary);
+    if (!out.is_open()) return false;
+    out << in.rdbuf();
+    return out.good();
+}
+
+bool file_exists(const std::string &name) {
+    std::ifstream f(name.c_str());
+    return f.is_open();
+}
+
+}  // namespace
+
 void GeneratorBase::emit_filter(const std::string &output_dir,
                                 const std::string &function_name,
                                 const std::string &file_base_name,
@@ -305,28 +386,62 @@ void GeneratorBase::emit_filter(const std::string &output_dir,
 
     std::vector<Halide::Argument> inputs = get_filter_arguments();
     std::string base_path = output_dir + "/" + (file_base_name.empty() ? function_name : file_base_name);
+
+    // The extensions of the files to emit.
+    std::string object_ext;
+    // If the target arch is pnacl, then the output "object" file is
+    // actually a pnacl bitcode file.
+    if (Target(target).arch == Target::PNaCl) {
+        object_ext = ".bc";
+    } else if (Target(target).os == Target::Windows &&
+               !Target(target).has_feature(Target::MinGW)) {
+        // If it's windows, then we're emitting a COFF file
+        object_ext = ".obj";
+    } else {
+        // Otherwise it is an ELF or Mach-o
+        object_ext = ".o";
+    }
+    std::vector<std::string> extensions;
+    if (options.emit_o) extensions.push_back(object_ext);
+    if (options.emit_assembly) extensions.push_back(".s");
+    // In this case, bitcode refers to the LLVM IR generated by Halide
+    // and passed to LLVM, for both the pnacl and ordinary archs
+    if (options.emit_bitcode) extensions.push_back(".bc");
+    if (options.emit_h) extensions.push_back(".h");
+    if (options.emit_cpp) extensions.push_back(".cpp");
+    if (options.emit_stmt) extensions.push_back(".stmt");
+    if (options.emit_stmt_html) extensions.push_back(".html");
+
+    // If everything we'd emit is already in the cache, copy it from
+    // there. Lowering is cheap next to LLVM's optimization and
+    // codegen, so we lower once to compute the key.
+    std::string cache_path;
+    if (!options.cache_dir.empty()) {
+        Module module = pipeline.compile_to_module(inputs, function_name, target);
+        cache_path = options.cache_dir + "/" + function_name + "-" + filter_cache_key(module);
+        bool hit = true;
+        for (const std::string &ext : extensions) {
+            hit = hit && file_exists(cache_path + ext);
+        }
+        if (hit) {
+            for (const std::string &ext : extensions) {
+                user_assert(copy_file(cache_path + ext, base_path + ext))
+                    << "Could not copy " << cache_path + ext << " to " << base_path + ext << "\n";
+            }
+            debug(1) << "Reused cached " << cache_path << " for " << base_path << "\n";
+            return;
+        }
+    }
+
     if (options.emit_o || options.emit_assembly || options.emit_bitcode) {
         Outputs output_files;
         if (options.emit_o) {
-            // If the target arch is pnacl, then the output "object" file is
-            // actually a pnacl bitcode file.
-            if (Target(target).arch == Target::PNaCl) {
-                output_files.object_name = base_path + ".bc";
-            } else if (Target(target).os == Target::Windows &&
-                       !Target(target).has_feature(Target::MinGW)) {
-                // If it's windows, then we're emitting a COFF file
-                output_files.object_name = base_path + ".obj";
-            } else {
-                // Otherwise it is an ELF or Mach-o
-                output_files.object_name = base_path + ".o";
-            }
+            output_files.object_name = base_path + object_ext;
         }
         if (options.emit_assembly) {
             output_files.assembly_name = base_path + ".s";
         }
         if (options.emit_bitcode) {
-            // In this case, bitcode refers to the LLVM IR generated by Halide
-            // and passed to LLVM, for both the pnacl and ordinary archs
             output_files.bitcode_name = base_path + ".bc";
         }
         pipeline.compile_to(output_files, inputs, function_name, target);
@@ -343,6 +458,22 @@ void GeneratorBase::emit_filter(const std::string &output_dir,
     if (options.emit_stmt_html) {
         pipeline.compile_to_lowered_stmt(base_path + ".html", inputs, Halide::HTML, target);
     }
+
+    if (!cache_path.empty()) {
+        // Failing to fill the cache isn't an error; the next build
+        // will just compile again. Each file is written under a
+        // temporary name unique to this output path and then renamed,
+        // so that concurrent builds never see a partial file.
+        std::string tmp_suffix = "." + hex_string(IRHasher().include(base_path).value()) + ".tmp";
+        for (const std::string &ext : extensions) {
+            std::string tmp = cache_path + ext + tmp_suffix;
+            if (!copy_file(base_path + ext, tmp) ||
+                std::rename(tmp.c_str(), (cache_path + ext).c_str()) != 0) {
+                debug(1) << "Could not add " << base_path + ext << " to the generator cache\n";
+                std::remove(tmp.c_str());
+            }
+        }
+    }
 }
 
 Func GeneratorBase::call_extern(std::initializer_list<ExternFuncArgument> function_arguments,
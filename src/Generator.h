@@ -108,7 +108,11 @@ EXPORT extern const std::map<std::string, Halide::Type> &get_halide_type_enum_ma
 /** generate_filter_main() is a convenient wrapper for GeneratorRegistry::create() +
  * compile_to_files();
  * it can be trivially wrapped by a "real" main() to produce a command-line utility
- * for ahead-of-time filter compilation. */
+ * for ahead-of-time filter compilation. GeneratorParam values may also be read from
+ * a file (e.g. one written by the autotuner) with -p; values given on the command
+ * line take precedence. With -c CACHE_DIR, the emitted files are also saved
+ * in CACHE_DIR, keyed by a hash of the lowered code, and later runs that
+ * lower to the same code reuse them instead of compiling again. */
 EXPORT int generate_filter_main(int argc, char **argv, std::ostream &cerr);
 
 class GeneratorParamBase {
@@ -531,12 +535,34 @@ namespace Internal {
 // without considering that.
 using GeneratorParamValues = std::map<std::string, std::string>;
 
+/** Read GeneratorParam values from a file of name=value lines, as
+ * written by write_generator_param_file. Blank lines and lines
+ * beginning with '#' are ignored. */
+EXPORT GeneratorParamValues read_generator_param_file(const std::string &filename);
+
+/** Write GeneratorParam values to a file as name=value lines,
+ * preceded by the given comment (if any). */
+EXPORT void write_generator_param_file(const std::string &filename,
+                                       const GeneratorParamValues &values,
+                                       const std::string &comment = "");
+
 class GeneratorBase : public NamesInterface {
 public:
     GeneratorParam<Target> target{ "target", Halide::get_host_target() };
 
     struct EmitOptions {
         bool emit_o, emit_h, emit_cpp, emit_assembly, emit_bitcode, emit_stmt, emit_stmt_html;
+
+        /** If set, an existing directory in which to cache emitted
+         * files. The key is a lossless hash of the lowered module
+         * (including its target and the contents of any embedded
+         * buffers), so files are reused whenever the generator and
+         * its params produce the same code. The key includes a format
+         * version that is bumped when Halide's IR changes, but not
+         * every change to code generation, so clear the cache after
+         * updating Halide. */
+        std::string cache_dir;
+
         EmitOptions()
             : emit_o(true), emit_h(true), emit_cpp(false), emit_assembly(false),
               emit_bitcode(false), emit_stmt(false), emit_stmt_html(false) {}
@@ -572,6 +598,14 @@ public:
         return filter_arguments;
     }
 
+    /** Return the Parameters behind the filter arguments, in the same
+     * order, so that values can be bound to them before JIT-compiling
+     * and running the Generator's pipeline. */
+    std::vector<Parameter> get_filter_parameters() {
+        build_params();
+        return filter_parameters;
+    }
+
     EXPORT std::vector<Argument> get_filter_output_types();
 
     /** Given a data type, return an estimate of the "natural" vector size
@@ -607,6 +641,7 @@ private:
     // through these in a predictable order; do not change to unordered_map (etc)
     // without considering that.
     std::vector<Argument> filter_arguments;
+    std::vector<Parameter> filter_parameters;
     std::map<std::string, Internal::GeneratorParamBase *> generator_params;
     bool params_built;
 
@@ -614,6 +649,9 @@ private:
 
     EXPORT void build_params();
 
+    // The autotuner needs to build the pipeline to JIT-compile it.
+    friend class Autotuner;
+
     // Provide private, unimplemented, wrong-result-type methods here
     // so that Generators don't attempt to call the global methods
     // of the same name by accident: use the get_target() method instead.
@@ -0,0 +1,430 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "IRHash.h"
+#include "IROperator.h"
+#include "Debug.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// Bump this whenever the serialization below changes, or whenever a
+// change to Halide means that identical IR should no longer produce
+// identical code.
+const char *const ir_hash_version = "halide-ir-hash-1";
+
+}
+
+IRHasher::IRHasher() : hash(14695981039346656037ULL) {
+    include(string(ir_hash_version));
+}
+
+// A 64-bit FNV-1a hash.
+IRHasher &IRHasher::include_bytes(const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return *this;
+}
+
+IRHasher &IRHasher::include(int64_t x) {
+    // Serialize in a fixed byte order, so that the hash doesn't
+    // depend on the host.
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (uint8_t)((uint64_t)x >> (i * 8));
+    }
+    return include_bytes(bytes, 8);
+}
+
+IRHasher &IRHasher::include(const string &s) {
+    include((int64_t)s.size());
+    return include_bytes(s.data(), s.size());
+}
+
+IRHasher &IRHasher::include(Type t) {
+    include((int64_t)t.code());
+    include((int64_t)t.bits());
+    return include((int64_t)t.lanes());
+}
+
+IRHasher &IRHasher::include(const Expr &e) {
+    if (e.defined()) {
+        e.accept(this);
+    } else {
+        include(string("undef"));
+    }
+    return *this;
+}
+
+IRHasher &IRHasher::include(const Stmt &s) {
+    if (s.defined()) {
+        s.accept(this);
+    } else {
+        include(string("undef"));
+    }
+    return *this;
+}
+
+IRHasher &IRHasher::include(const Argument &arg) {
+    include(arg.name);
+    include((int64_t)arg.kind);
+    include((int64_t)arg.dimensions);
+    include(arg.type);
+    include(arg.def);
+    include(arg.min);
+    return include(arg.max);
+}
+
+IRHasher &IRHasher::include(const LoweredFunc &f) {
+    include(f.name);
+    include((int64_t)f.linkage);
+    include((int64_t)f.args.size());
+    for (const Argument &arg : f.args) {
+        include(arg);
+    }
+    return include(f.body);
+}
+
+IRHasher &IRHasher::include(const Buffer &b) {
+    if (!b.defined()) {
+        return include(string("undef"));
+    }
+    include(b.name());
+    include(b.type());
+    const buffer_t *buf = b.raw_buffer();
+    for (int i = 0; i < 4; i++) {
+        include((int64_t)buf->min[i]);
+        include((int64_t)buf->extent[i]);
+        include((int64_t)buf->stride[i]);
+    }
+    include((int64_t)buf->elem_size);
+    if (!buf->host) {
+        return include(string("no host"));
+    }
+    // The number of elements spanned by the buffer.
+    size_t span = 1;
+    for (int i = 0; i < 4 && buf->extent[i]; i++) {
+        span += (size_t)(buf->extent[i] - 1) * std::abs(buf->stride[i]);
+    }
+    include((int64_t)span);
+    return include_bytes(buf->host, span * buf->elem_size);
+}
+
+IRHasher &IRHasher::include(const Module &m) {
+    include(m.name());
+    include(m.target().to_string());
+    include((int64_t)m.functions.size());
+    for (const LoweredFunc &f : m.functions) {
+        include(f);
+    }
+    include((int64_t)m.buffers.size());
+    for (const Buffer &b : m.buffers) {
+        include(b);
+    }
+    return *this;
+}
+
+void IRHasher::include_node(const char *tag, Type t) {
+    include(string(tag));
+    include(t);
+}
+
+void IRHasher::include_params(const Parameter &param, const Buffer &image) {
+    if (param.defined()) {
+        include(string("param"));
+        include(param.name());
+        include(param.type());
+        include((int64_t)param.is_buffer());
+        include((int64_t)param.dimensions());
+    }
+    if (image.defined()) {
+        include(string("image"));
+        include(image.name());
+        include(image.type());
+        include((int64_t)image.dimensions());
+    }
+}
+
+void IRHasher::visit(const IntImm *op) {
+    include_node("IntImm", op->type);
+    include(op->value);
+}
+
+void IRHasher::visit(const UIntImm *op) {
+    include_node("UIntImm", op->type);
+    include((int64_t)op->value);
+}
+
+void IRHasher::visit(const FloatImm *op) {
+    include_node("FloatImm", op->type);
+    int64_t bits;
+    static_assert(sizeof(bits) == sizeof(op->value), "double is not 64 bits");
+    memcpy(&bits, &op->value, sizeof(bits));
+    include(bits);
+}
+
+void IRHasher::visit(const StringImm *op) {
+    include_node("StringImm", op->type);
+    include(op->value);
+}
+
+void IRHasher::visit(const Cast *op) {
+    include_node("Cast", op->type);
+    include(op->value);
+}
+
+void IRHasher::visit(const Variable *op) {
+    include_node("Variable", op->type);
+    include(op->name);
+    include_params(op->param, op->image);
+    if (op->reduction_domain.defined()) {
+        const vector<ReductionVariable> &domain = op->reduction_domain.domain();
+        include(string("rdom"));
+        include((int64_t)domain.size());
+        for (const ReductionVariable &rv : domain) {
+            include(rv.var);
+            include(rv.min);
+            include(rv.extent);
+        }
+    }
+}
+
+#define HASH_BINARY_OP(T)                       \
+    void IRHasher::visit(const T *op) {         \
+        include_node(#T, op->type);                   \
+        include(op->a);                         \
+        include(op->b);                         \
+    }
+
+HASH_BINARY_OP(Add)
+HASH_BINARY_OP(Sub)
+HASH_BINARY_OP(Mul)
+HASH_BINARY_OP(Div)
+HASH_BINARY_OP(Mod)
+HASH_BINARY_OP(Min)
+HASH_BINARY_OP(Max)
+HASH_BINARY_OP(EQ)
+HASH_BINARY_OP(NE)
+HASH_BINARY_OP(LT)
+HASH_BINARY_OP(LE)
+HASH_BINARY_OP(GT)
+HASH_BINARY_OP(GE)
+HASH_BINARY_OP(And)
+HASH_BINARY_OP(Or)
+
+#undef HASH_BINARY_OP
+
+void IRHasher::visit(const Not *op) {
+    include_node("Not", op->type);
+    include(op->a);
+}
+
+void IRHasher::visit(const Select *op) {
+    include_node("Select", op->type);
+    include(op->condition);
+    include(op->true_value);
+    include(op->false_value);
+}
+
+void IRHasher::visit(const Load *op) {
+    include_node("Load", op->type);
+    include(op->name);
+    include(op->index);
+    include_params(op->param, op->image);
+}
+
+void IRHasher::visit(const Ramp *op) {
+    include_node("Ramp", op->type);
+    include(op->base);
+    include(op->stride);
+    include((int64_t)op->lanes);
+}
+
+void IRHasher::visit(const Broadcast *op) {
+    include_node("Broadcast", op->type);
+    include(op->value);
+    include((int64_t)op->lanes);
+}
+
+void IRHasher::visit(const Call *op) {
+    include_node("Call", op->type);
+    include(op->name);
+    include((int64_t)op->call_type);
+    include((int64_t)op->value_index);
+    include((int64_t)op->args.size());
+    for (Expr arg : op->args) {
+        include(arg);
+    }
+    include_params(op->param, op->image);
+}
+
+void IRHasher::visit(const Let *op) {
+    include_node("Let", op->type);
+    include(op->name);
+    include(op->value);
+    include(op->body);
+}
+
+void IRHasher::visit(const LetStmt *op) {
+    include(string("LetStmt"));
+    include(op->name);
+    include(op->value);
+    include(op->body);
+}
+
+void IRHasher::visit(const AssertStmt *op) {
+    include(string("AssertStmt"));
+    include(op->condition);
+    include(op->message);
+}
+
+void IRHasher::visit(const ProducerConsumer *op) {
+    include(string("ProducerConsumer"));
+    include(op->name);
+    include(op->produce);
+    include(op->update);
+    include(op->consume);
+}
+
+void IRHasher::visit(const For *op) {
+    include(string("For"));
+    include(op->name);
+    include(op->min);
+    include(op->extent);
+    include((int64_t)op->for_type);
+    include((int64_t)op->device_api);
+    include(op->body);
+}
+
+void IRHasher::visit(const Store *op) {
+    include(string("Store"));
+    include(op->name);
+    include(op->value);
+    include(op->index);
+}
+
+void IRHasher::visit(const Provide *op) {
+    include(string("Provide"));
+    include(op->name);
+    include((int64_t)op->values.size());
+    for (Expr v : op->values) {
+        include(v);
+    }
+    include((int64_t)op->args.size());
+    for (Expr a : op->args) {
+        include(a);
+    }
+}
+
+void IRHasher::visit(const Allocate *op) {
+    include(string("Allocate"));
+    include(op->name);
+    include(op->type);
+    include((int64_t)op->extents.size());
+    for (Expr e : op->extents) {
+        include(e);
+    }
+    include(op->condition);
+    include(op->new_expr);
+    include(op->free_function);
+    include(op->body);
+}
+
+void IRHasher::visit(const Free *op) {
+    include(string("Free"));
+    include(op->name);
+}
+
+void IRHasher::visit(const Realize *op) {
+    include(string("Realize"));
+    include(op->name);
+    include((int64_t)op->types.size());
+    for (Type t : op->types) {
+        include(t);
+    }
+    include((int64_t)op->bounds.size());
+    for (const Range &r : op->bounds) {
+        include(r.min);
+        include(r.extent);
+    }
+    include(op->condition);
+    include(op->body);
+}
+
+void IRHasher::visit(const Block *op) {
+    include(string("Block"));
+    include(op->first);
+    include(op->rest);
+}
+
+void IRHasher::visit(const IfThenElse *op) {
+    include(string("IfThenElse"));
+    include(op->condition);
+    include(op->then_case);
+    include(op->else_case);
+}
+
+void IRHasher::visit(const Evaluate *op) {
+    include(string("Evaluate"));
+    include(op->value);
+}
+
+namespace {
+
+uint64_t hash_of(const Module &m) {
+    return IRHasher().include(m).value();
+}
+
+Module module_storing(Expr value) {
+    Module m("test", get_host_target());
+    vector<Argument> args;
+    args.push_back(Argument("in", Argument::InputBuffer, UInt(8), 1));
+    args.push_back(Argument("out", Argument::OutputBuffer, UInt(8), 1));
+    Stmt body = Store::make("out", value, 0);
+    m.append(LoweredFunc("test", args, body, LoweredFunc::External));
+    return m;
+}
+
+}
+
+void ir_hash_test() {
+    Expr x = Variable::make(Int(32), "x");
+
+    // Identical IR built separately hashes the same.
+    internal_assert(hash_of(module_storing(x + 1)) == hash_of(module_storing(x + 1)));
+
+    // Float constants that print the same still hash differently.
+    internal_assert(hash_of(module_storing(Expr(1e-7f))) != hash_of(module_storing(Expr(2e-7f))));
+
+    // So do loads that differ only in type.
+    Expr load_f32 = Load::make(Float(32), "in", 0, Buffer(), Parameter());
+    Expr load_i32 = Load::make(Int(32), "in", 0, Buffer(), Parameter());
+    internal_assert(hash_of(module_storing(load_f32)) != hash_of(module_storing(load_i32)));
+
+    // And functions whose arguments differ only in type or kind.
+    Module a("test", get_host_target()), b("test", get_host_target()), c("test", get_host_target());
+    Stmt body = Evaluate::make(0);
+    a.append(LoweredFunc("f", {Argument("p", Argument::InputScalar, Int(32), 0)}, body, LoweredFunc::External));
+    b.append(LoweredFunc("f", {Argument("p", Argument::InputScalar, UInt(32), 0)}, body, LoweredFunc::External));
+    c.append(LoweredFunc("f", {Argument("p", Argument::InputBuffer, Int(32), 0)}, body, LoweredFunc::External));
+    internal_assert(hash_of(a) != hash_of(b));
+    internal_assert(hash_of(a) != hash_of(c));
+
+    // And the target is part of the hash.
+    Module d("test", get_host_target().with_feature(Target::Debug));
+    d.append(LoweredFunc("f", {Argument("p", Argument::InputScalar, Int(32), 0)}, body, LoweredFunc::External));
+    internal_assert(hash_of(a) != hash_of(d));
+
+    std::cout << "IR hash test passed\n";
+}
+
+}
+}
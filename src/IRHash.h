@@ -0,0 +1,118 @@
+#ifndef HALIDE_IR_HASH_H
+#define HALIDE_IR_HASH_H
+
+/** \file
+ * Defines a hash of IR that is stable across processes, for keying
+ * persistent caches.
+ */
+
+#include "IRVisitor.h"
+#include "Module.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Incrementally computes a 64-bit hash of a lossless serialization
+ * of IR. Unlike the text produced by IRPrinter, the serialization
+ * includes the type of every node, the exact bits of every constant,
+ * and every field of every node, so two pieces of IR hash the same
+ * only if they are structurally identical (up to hash collisions).
+ * The hash depends only on the IR, so it is the same in every
+ * process. Images and parameters referred to by the IR are included
+ * by name; hash their contents separately if they matter. Every
+ * hasher starts from a format version, which is bumped whenever the
+ * serialization or the meaning of the IR changes, so that persistent
+ * caches keyed on it are invalidated. */
+class IRHasher : public IRVisitor {
+public:
+    EXPORT IRHasher();
+
+    /** Add some IR to the hash. */
+    // @{
+    EXPORT IRHasher &include(const Expr &);
+    EXPORT IRHasher &include(const Stmt &);
+    EXPORT IRHasher &include(Type);
+    EXPORT IRHasher &include(const Argument &);
+    EXPORT IRHasher &include(const LoweredFunc &);
+    // @}
+
+    /** Add a buffer's name, type and shape to the hash, along with
+     * its contents if it has any on the host. */
+    EXPORT IRHasher &include(const Buffer &);
+
+    /** Add a module to the hash, including its name, target, the
+     * signature and body of every function, and every embedded
+     * buffer. */
+    EXPORT IRHasher &include(const Module &);
+
+    /** Add a string or an integer to the hash. Strings are prefixed
+     * with their length, so that the concatenation of several strings
+     * is unambiguous. */
+    // @{
+    EXPORT IRHasher &include(const std::string &);
+    EXPORT IRHasher &include(int64_t);
+    // @}
+
+    /** Add raw bytes to the hash. */
+    EXPORT IRHasher &include_bytes(const void *data, size_t size);
+
+    /** The hash of everything included so far. */
+    uint64_t value() const {return hash;}
+
+protected:
+    using IRVisitor::visit;
+
+    void visit(const IntImm *);
+    void visit(const UIntImm *);
+    void visit(const FloatImm *);
+    void visit(const StringImm *);
+    void visit(const Cast *);
+    void visit(const Variable *);
+    void visit(const Add *);
+    void visit(const Sub *);
+    void visit(const Mul *);
+    void visit(const Div *);
+    void visit(const Mod *);
+    void visit(const Min *);
+    void visit(const Max *);
+    void visit(const EQ *);
+    void visit(const NE *);
+    void visit(const LT *);
+    void visit(const LE *);
+    void visit(const GT *);
+    void visit(const GE *);
+    void visit(const And *);
+    void visit(const Or *);
+    void visit(const Not *);
+    void visit(const Select *);
+    void visit(const Load *);
+    void visit(const Ramp *);
+    void visit(const Broadcast *);
+    void visit(const Call *);
+    void visit(const Let *);
+    void visit(const LetStmt *);
+    void visit(const AssertStmt *);
+    void visit(const ProducerConsumer *);
+    void visit(const For *);
+    void visit(const Store *);
+    void visit(const Provide *);
+    void visit(const Allocate *);
+    void visit(const Free *);
+    void visit(const Realize *);
+    void visit(const Block *);
+    void visit(const IfThenElse *);
+    void visit(const Evaluate *);
+
+private:
+    uint64_t hash;
+
+    void include_node(const char *tag, Type t);
+    void include_params(const Parameter &param, const Buffer &image);
+};
+
+EXPORT void ir_hash_test();
+
+}
+}
+
+#endif
@@ -37,6 +37,11 @@ class Inliner : public IRMutator {
                        << f.name() << " because the function is scheduled inline.\n";
         }
 
+        if (s.async()) {
+            user_error << "Cannot compute function "
+                       << f.name() << " asynchronously because the function is scheduled inline.\n";
+        }
+
         for (size_t i = 0; i < s.dims().size(); i++) {
             Dim d = s.dims()[i];
             if (d.for_type == ForType::Parallel) {
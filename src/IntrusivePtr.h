@@ -8,19 +8,27 @@
  */
 
 #include <stdlib.h>
+#include <atomic>
 
 #include "Util.h"
 
 namespace Halide {
 namespace Internal {
 
-/** A class representing a reference count to be used with IntrusivePtr */
+/** A class representing a reference count to be used with
+ * IntrusivePtr. The count is atomic, so handles to the same object
+ * may be copied and destroyed from multiple threads at once. */
 class RefCount {
-    int count;
+    std::atomic<int> count;
 public:
     RefCount() : count(0) {}
-    void increment() {count++;}
-    void decrement() {count--;}
+    RefCount(const RefCount &other) : count(other.count.load()) {}
+    RefCount &operator=(const RefCount &other) {
+        count = other.count.load();
+        return *this;
+    }
+    int increment() {return ++count;}
+    int decrement() {return --count;}
     bool is_zero() const {return count == 0;}
 };
 
@@ -70,8 +78,7 @@ private:
             // the counts due to the cycle. The next line then makes
             // the ref_count negative, which prevents actually
             // entering the destructor recursively.
-            ref_count(p).decrement();
-            if (ref_count(p).is_zero()) {
+            if (ref_count(p).decrement() == 0) {
                 destroy(p);
             }
         }
@@ -257,7 +257,7 @@ void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &fu
     engine_builder.setMCJITMemoryManager(std::unique_ptr<RTDyldMemoryManager>(new HalideJITMemoryManager(dependencies)));
     #endif
 
-    engine_builder.setOptLevel(CodeGenOpt::Aggressive);
+    engine_builder.setOptLevel(get_codegen_opt_level(target.opt_level()));
     engine_builder.setMCPU(mcpu);
     std::vector<string> mattrs_array = {mattrs};
     engine_builder.setMAttrs(mattrs_array);
@@ -456,6 +456,62 @@ void JITModule::memoization_cache_set_size(int64_t size) const {
     }
 }
 
+bool JITModule::memoization_cache_use_shared_file(const std::string &path, int64_t size) const {
+    std::map<std::string, Symbol>::const_iterator set_cache =
+        exports().find("halide_set_custom_memoization_cache");
+    if (set_cache == exports().end()) {
+        return false;
+    }
+    typedef const halide_memoization_cache_t *(*set_cache_fn)(const halide_memoization_cache_t *);
+    set_cache_fn set_custom_cache = reinterpret_bits<set_cache_fn>(set_cache->second.address);
+
+    // Return to the in-process cache, and release whatever the
+    // previous implementation holds (for the shared cache, its
+    // mapping of the file and its file descriptor). The second call
+    // just tells us which implementation is the in-process one, which
+    // mustn't be cleaned up.
+    const halide_memoization_cache_t *previous = set_custom_cache(NULL);
+    const halide_memoization_cache_t *in_process = set_custom_cache(NULL);
+    if (previous != in_process) {
+        previous->cleanup();
+    }
+    if (path.empty()) {
+        return true;
+    }
+
+    std::map<std::string, Symbol>::const_iterator shared_cache =
+        exports().find("halide_shared_memoization_cache");
+    if (shared_cache == exports().end()) {
+        return false;
+    }
+    typedef const halide_memoization_cache_t *(*shared_cache_fn)(void *, const char *, int64_t);
+    const halide_memoization_cache_t *cache =
+        (reinterpret_bits<shared_cache_fn>(shared_cache->second.address))(NULL, path.c_str(), size);
+    if (cache == NULL) {
+        return false;
+    }
+    set_custom_cache(cache);
+    return true;
+}
+
+halide_profiler_state *JITModule::profiler_state() const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_profiler_get_state");
+    if (f == exports().end()) {
+        return NULL;
+    }
+    return (reinterpret_bits<halide_profiler_state *(*)()>(f->second.address))();
+}
+
+halide_telemetry_pipeline_stats *JITModule::telemetry_pipelines() const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_telemetry_get_pipelines");
+    if (f == exports().end()) {
+        return NULL;
+    }
+    return (reinterpret_bits<halide_telemetry_pipeline_stats *(*)()>(f->second.address))();
+}
+
 bool JITModule::compiled() const {
   return jit_module.ptr->execution_engine != NULL;
 }
@@ -466,6 +522,8 @@ JITHandlers runtime_internal_handlers;
 JITHandlers default_handlers;
 JITHandlers active_handlers;
 int64_t default_cache_size;
+std::string default_shared_cache_path;
+int64_t default_shared_cache_size;
 
 void merge_handlers(JITHandlers &base, const JITHandlers &addins) {
     if (addins.custom_print) {
@@ -704,6 +762,11 @@ JITModule &make_module(llvm::Module *for_module, Target target,
                 shared_runtimes(MainShared).memoization_cache_set_size(default_cache_size);
             }
 
+            if (!default_shared_cache_path.empty()) {
+                shared_runtimes(MainShared).memoization_cache_use_shared_file(default_shared_cache_path,
+                                                                              default_shared_cache_size);
+            }
+
             runtime.jit_module.ptr->name = "MainShared";
         } else {
             runtime.jit_module.ptr->name = "GPU";
@@ -809,5 +872,34 @@ void JITSharedRuntime::memoization_cache_set_size(int64_t size) {
     }
 }
 
+bool JITSharedRuntime::memoization_cache_use_shared_file(const std::string &path, int64_t size) {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+
+    default_shared_cache_path = path;
+    default_shared_cache_size = size;
+    if (shared_runtimes(MainShared).compiled()) {
+        return shared_runtimes(MainShared).memoization_cache_use_shared_file(path, size);
+    }
+    return true;
+}
+
+halide_profiler_state *JITSharedRuntime::profiler_state() {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+
+    if (!shared_runtimes(MainShared).compiled()) {
+        return NULL;
+    }
+    return shared_runtimes(MainShared).profiler_state();
+}
+
+halide_telemetry_pipeline_stats *JITSharedRuntime::telemetry_pipelines() {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+
+    if (!shared_runtimes(MainShared).compiled()) {
+        return NULL;
+    }
+    return shared_runtimes(MainShared).telemetry_pipelines();
+}
+
 }
 }
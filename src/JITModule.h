@@ -133,6 +133,9 @@ struct JITModule {
     EXPORT int copy_to_host(struct buffer_t *buf) const;
     EXPORT int device_free(struct buffer_t *buf) const;
     EXPORT void memoization_cache_set_size(int64_t size) const;
+    EXPORT bool memoization_cache_use_shared_file(const std::string &path, int64_t size) const;
+    EXPORT halide_profiler_state *profiler_state() const;
+    EXPORT halide_telemetry_pipeline_stats *telemetry_pipelines() const;
 
     /** Return true if compile_module has been called on this module. */
     EXPORT bool compiled() const;
@@ -172,6 +175,35 @@ public:
      */
     EXPORT static void memoization_cache_set_size(int64_t size);
 
+    /** Keep memoized results in a file mapped into memory, shared with
+     * other processes that use the same file. The file is created
+     * with the given size if it doesn't exist. Pipelines must be
+     * compiled with Target::MemoizeStableKeys for their results to
+     * be found by other processes. Pass an empty path to return to
+     * the in-process cache. Switching files, or returning to the
+     * in-process cache, unmaps and closes the previous file. Returns
+     * false if the file can't be used.
+     * If you are compiling statically, you should include
+     * HalideRuntime.h and call halide_shared_memoization_cache()
+     * and halide_set_custom_memoization_cache() instead.
+     */
+    EXPORT static bool memoization_cache_use_shared_file(const std::string &path, int64_t size);
+
+    /** Get the state of the profiler used by pipelines jit-compiled
+     * with Target::Profile, or NULL if the runtime hasn't been
+     * compiled yet. If you are compiling statically, you should
+     * include HalideRuntime.h and call halide_profiler_get_state()
+     * instead.
+     */
+    EXPORT static halide_profiler_state *profiler_state();
+
+    /** Get the statistics recorded for pipelines jit-compiled with
+     * Target::Telemetry, or NULL if there are none yet. If you are
+     * compiling statically, you should include HalideRuntime.h and
+     * call halide_telemetry_get_pipelines() instead.
+     */
+    EXPORT static halide_telemetry_pipeline_stats *telemetry_pipelines();
+
     EXPORT static void release_all();
 };
 
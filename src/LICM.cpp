@@ -0,0 +1,392 @@
+#include <iostream>
+#include <map>
+#include <set>
+
+#include "LICM.h"
+#include "CodeGen_GPU_Dev.h"
+#include "Debug.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRPrinter.h"
+#include "Scope.h"
+#include "Substitute.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::pair;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Is a call free of side-effects, and safe to make ahead of time?
+bool is_pure_call(const Call *op, bool buffers_rewritten) {
+    if (op->call_type == Call::Intrinsic) {
+        // Note that likely is deliberately absent: partition_loops
+        // needs to find it where it was written.
+        if (op->name == Call::extract_buffer_min ||
+            op->name == Call::extract_buffer_max) {
+            return !buffers_rewritten;
+        }
+        return (op->name == Call::bitwise_and ||
+                op->name == Call::bitwise_not ||
+                op->name == Call::bitwise_xor ||
+                op->name == Call::bitwise_or ||
+                op->name == Call::shift_left ||
+                op->name == Call::shift_right ||
+                op->name == Call::abs ||
+                op->name == Call::absd ||
+                op->name == Call::reinterpret ||
+                op->name == Call::lerp ||
+                op->name == Call::popcount ||
+                op->name == Call::count_leading_zeros ||
+                op->name == Call::count_trailing_zeros);
+    } else if (op->call_type == Call::Extern) {
+        // The math functions in the runtime, e.g. sqrt_f32.
+        static const set<string> math_functions = {
+            "sqrt", "sin", "asin", "cos", "acos", "tan", "atan", "atan2",
+            "sinh", "asinh", "cosh", "acosh", "tanh", "atanh", "exp", "log",
+            "pow", "floor", "ceil", "round", "trunc", "is_nan"
+        };
+        size_t n = op->name.size();
+        if (n < 5 || op->name[n - 4] != '_' || op->name[n - 3] != 'f') {
+            return false;
+        }
+        string suffix = op->name.substr(n - 3);
+        if (suffix != "f16" && suffix != "f32" && suffix != "f64") {
+            return false;
+        }
+        return math_functions.count(op->name.substr(0, n - 4)) > 0;
+    } else {
+        // Image and Halide calls read memory.
+        return false;
+    }
+}
+
+// Check whether an expression can be computed before a loop instead
+// of inside it.
+class CanLift : public IRVisitor {
+    using IRVisitor::visit;
+
+    const Scope<int> &defined_in_loop;
+    bool buffers_rewritten;
+
+    void visit(const Variable *op) {
+        if (defined_in_loop.contains(op->name)) {
+            result = false;
+        }
+    }
+
+    void visit(const Load *op) {
+        // The loop may write to the buffer, and if the loop runs zero
+        // times the address may not be valid.
+        result = false;
+    }
+
+    void visit(const Call *op) {
+        if (!is_pure_call(op, buffers_rewritten)) {
+            result = false;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+    // Integer division and modulus by zero trap.
+    void visit(const Div *op) {
+        if (!op->type.is_float() && (!is_const(op->b) || is_zero(op->b))) {
+            result = false;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+    void visit(const Mod *op) {
+        if (!op->type.is_float() && (!is_const(op->b) || is_zero(op->b))) {
+            result = false;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+public:
+    bool result;
+
+    CanLift(const Scope<int> &s, bool r) : defined_in_loop(s), buffers_rewritten(r), result(true) {}
+};
+
+// Lifting an expression this cheap just costs a register. This list
+// mirrors the lets that the simplifier substitutes back in, so that
+// it doesn't undo our work.
+bool should_lift(Expr e) {
+    if (is_const(e) || e.as<Variable>()) {
+        return false;
+    }
+
+    if (const Broadcast *a = e.as<Broadcast>()) {
+        return should_lift(a->value);
+    }
+
+    if (const Cast *a = e.as<Cast>()) {
+        return should_lift(a->value);
+    }
+
+    if (const Add *a = e.as<Add>()) {
+        return !((is_const(a->a) && a->b.as<Variable>()) ||
+                 (is_const(a->b) && a->a.as<Variable>()));
+    }
+
+    if (const Sub *a = e.as<Sub>()) {
+        return !((is_const(a->a) && a->b.as<Variable>()) ||
+                 (is_const(a->b) && a->a.as<Variable>()));
+    }
+
+    if (const Ramp *a = e.as<Ramp>()) {
+        return should_lift(a->base) || should_lift(a->stride);
+    }
+
+    return true;
+}
+
+// Does a statement rewrite any buffer_t that extract_buffer_min or
+// extract_buffer_max might read?
+class RewritesBuffers : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Call *op) {
+        // Extern stages may rewrite the buffers passed to them.
+        if (op->name == Call::rewrite_buffer ||
+            op->name == Call::copy_buffer_t ||
+            (op->call_type == Call::Extern && !is_pure_call(op, false))) {
+            result = true;
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    bool result;
+    RewritesBuffers() : result(false) {}
+};
+
+// Replace the loop-invariant subexpressions of a loop body with
+// variables, and record their values.
+class LiftLoopInvariants : public IRMutator {
+    using IRMutator::visit;
+
+    // The loop variable, and everything bound inside the loop body.
+    Scope<int> defined_in_loop;
+    bool buffers_rewritten;
+
+    map<Expr, string, IRDeepCompare> lifted;
+
+    void visit(const Let *op) {
+        Expr value = mutate(op->value);
+        defined_in_loop.push(op->name, 0);
+        Expr body = mutate(op->body);
+        defined_in_loop.pop(op->name);
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            expr = op;
+        } else {
+            expr = Let::make(op->name, value, body);
+        }
+    }
+
+    void visit(const LetStmt *op) {
+        Expr value = mutate(op->value);
+        defined_in_loop.push(op->name, 0);
+        Stmt body = mutate(op->body);
+        defined_in_loop.pop(op->name);
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            stmt = op;
+        } else {
+            stmt = LetStmt::make(op->name, value, body);
+        }
+    }
+
+    void visit(const For *op) {
+        Expr min = mutate(op->min);
+        Expr extent = mutate(op->extent);
+        defined_in_loop.push(op->name, 0);
+        Stmt body = mutate(op->body);
+        defined_in_loop.pop(op->name);
+        if (min.same_as(op->min) && extent.same_as(op->extent) && body.same_as(op->body)) {
+            stmt = op;
+        } else {
+            stmt = For::make(op->name, min, extent, op->for_type, op->device_api, body);
+        }
+    }
+
+    void visit(const Allocate *op) {
+        // The allocation's name may be referred to as a Variable
+        // (e.g. when making a buffer_t for it).
+        defined_in_loop.push(op->name, 0);
+        IRMutator::visit(op);
+        defined_in_loop.pop(op->name);
+    }
+
+public:
+    using IRMutator::mutate;
+
+    vector<pair<string, Expr>> lets;
+
+    LiftLoopInvariants(const string &loop_var, bool r) : buffers_rewritten(r) {
+        defined_in_loop.push(loop_var, 0);
+    }
+
+    Expr mutate(Expr e) {
+        if (e.defined() && should_lift(e)) {
+            CanLift check(defined_in_loop, buffers_rewritten);
+            e.accept(&check);
+            if (check.result) {
+                string name;
+                map<Expr, string, IRDeepCompare>::iterator iter = lifted.find(e);
+                if (iter == lifted.end()) {
+                    name = unique_name('t');
+                    lifted[e] = name;
+                    lets.push_back(std::make_pair(name, e));
+                } else {
+                    name = iter->second;
+                }
+                return Variable::make(e.type(), name);
+            }
+        }
+        return IRMutator::mutate(e);
+    }
+};
+
+class LoopInvariantCodeMotion : public IRMutator {
+    using IRMutator::visit;
+
+    // Lifting out of GPU loops would put lets between the block and
+    // thread loops, which the GPU backends don't expect, so leave
+    // device code alone.
+    bool is_device_loop(const For *op) {
+        return (CodeGen_GPU_Dev::is_gpu_var(op->name) ||
+                (op->device_api != DeviceAPI::Parent &&
+                 op->device_api != DeviceAPI::Host));
+    }
+
+    void visit(const For *op) {
+        if (is_device_loop(op)) {
+            stmt = op;
+            return;
+        }
+
+        // Lift out of the inner loops first, so that invariants move
+        // out one loop level at a time.
+        Stmt body = mutate(op->body);
+
+        RewritesBuffers rewrites;
+        body.accept(&rewrites);
+
+        LiftLoopInvariants lifter(op->name, rewrites.result);
+        body = lifter.mutate(body);
+
+        if (body.same_as(op->body)) {
+            stmt = op;
+            return;
+        }
+
+        stmt = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+        for (size_t i = lifter.lets.size(); i > 0; i--) {
+            const pair<string, Expr> &let = lifter.lets[i - 1];
+            debug(3) << "Lifting " << let.first << " = " << let.second << " out of loop over " << op->name << "\n";
+            stmt = LetStmt::make(let.first, let.second, stmt);
+        }
+    }
+};
+
+}  // namespace
+
+Stmt loop_invariant_code_motion(Stmt s) {
+    return LoopInvariantCodeMotion().mutate(s);
+}
+
+namespace {
+
+void check(Stmt s, Expr lifted, Stmt correct_body) {
+    Stmt result = loop_invariant_code_motion(s);
+    const LetStmt *let = result.as<LetStmt>();
+    if (!lifted.defined()) {
+        if (!equal(result, s)) {
+            internal_error
+                << "Nothing should have been lifted out of:\n" << s
+                << "But got:\n" << result << "\n";
+        }
+        return;
+    }
+    if (!let || !equal(let->value, lifted)) {
+        internal_error
+            << "Expected " << lifted << " to be lifted out of:\n" << s
+            << "But got:\n" << result << "\n";
+    }
+    const For *loop = let->body.as<For>();
+    internal_assert(loop) << "Expected a loop after the lifted let in:\n" << result << "\n";
+    // The correct body refers to the lifted expression as t.
+    Stmt correct = substitute("t", Variable::make(lifted.type(), let->name), correct_body);
+    if (!equal(loop->body, correct)) {
+        internal_error
+            << "Incorrect loop body after lifting " << lifted << " out of:\n" << s
+            << "Got:\n" << loop->body
+            << "Instead of:\n" << correct << "\n";
+    }
+}
+
+}  // namespace
+
+void licm_test() {
+    Expr x = Variable::make(Int(32), "x");
+    Expr a = Variable::make(Int(32), "a");
+    Expr b = Variable::make(Int(32), "b");
+    Expr f = Variable::make(Float(32), "f");
+
+    // The product of two strides is lifted.
+    Expr lifted = a * b;
+    Expr t = Variable::make(Int(32), "t");
+    Stmt s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                       Store::make("buf", x, x + a * b));
+    check(s, lifted, Store::make("buf", x, x + t));
+
+    // Anything that depends on the loop variable isn't.
+    s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                  Store::make("buf", x, x * b));
+    check(s, Expr(), Stmt());
+
+    // Neither are loads.
+    s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                  Store::make("buf", x, x + Load::make(Int(32), "buf2", a, Buffer(), Parameter())));
+    check(s, Expr(), Stmt());
+
+    // Nor division by something that might be zero.
+    s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                  Store::make("buf", x, x + a / b));
+    check(s, Expr(), Stmt());
+
+    // Nor trivial expressions.
+    s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                  Store::make("buf", x, x + (a + 1)));
+    check(s, Expr(), Stmt());
+
+    // Nor expressions that use a let defined in the loop.
+    s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                  LetStmt::make("a", x, Store::make("buf", x, a * b)));
+    check(s, Expr(), Stmt());
+
+    // Pure math functions are lifted, and repeated expressions are
+    // lifted once.
+    lifted = sqrt(f);
+    s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                  Block::make(Store::make("buf", sqrt(f), x),
+                              Store::make("buf", sqrt(f) * 2.0f, x + 1)));
+    t = Variable::make(Float(32), "t");
+    check(s, lifted, Block::make(Store::make("buf", t, x),
+                                 Store::make("buf", t * 2.0f, x + 1)));
+
+    std::cout << "Loop invariant code motion test passed" << std::endl;
+}
+
+}
+}
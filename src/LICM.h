@@ -0,0 +1,29 @@
+#ifndef HALIDE_LICM_H
+#define HALIDE_LICM_H
+
+/** \file
+ * Defines the lowering pass that hoists loop-invariant expressions out
+ * of loops.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Lift expressions that don't depend on a loop's variable (or on
+ * anything else defined inside the loop) into lets just outside that
+ * loop, working from the innermost loops outwards. This is mostly
+ * address arithmetic built from the mins and strides of buffers and
+ * from Params. Only expressions that are safe to compute even when
+ * the loop runs zero times are lifted: nothing that loads from
+ * memory, calls anything impure, or could trap. Done before
+ * vectorization. */
+Stmt loop_invariant_code_motion(Stmt s);
+
+EXPORT void licm_test();
+
+}
+}
+
+#endif
@@ -2,9 +2,18 @@
 #include "LLVM_Output.h"
 #include "CodeGen_LLVM.h"
 #include "CodeGen_C.h"
+#include "CodeGen_Internal.h"
+#include "IRVisitor.h"
 
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <functional>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <set>
+#include <thread>
 
 namespace Halide {
 
@@ -41,6 +50,21 @@ bool get_md_bool(LLVMMDNodeArgumentType value, bool &result) {
     return false;
 }
 
+bool get_md_int(LLVMMDNodeArgumentType value, int &result) {
+    if (!value) return false;
+    #if LLVM_VERSION < 36 || defined(WITH_NATIVE_CLIENT)
+    llvm::ConstantInt *c = llvm::cast<llvm::ConstantInt>(value);
+    #else
+    llvm::ConstantAsMetadata *cam = llvm::cast<llvm::ConstantAsMetadata>(value);
+    llvm::ConstantInt *c = llvm::cast<llvm::ConstantInt>(cam->getValue());
+    #endif
+    if (c) {
+        result = (int)c->getSExtValue();
+        return true;
+    }
+    return false;
+}
+
 bool get_md_string(LLVMMDNodeArgumentType value, std::string &result) {
     #if LLVM_VERSION < 36
     if (llvm::dyn_cast<llvm::ConstantAggregateZero>(value)) {
@@ -120,6 +144,10 @@ void clone_target_options(const llvm::Module &from, llvm::Module &to) {
         #endif
     }
 
+    int opt_level = 3;
+    if (Internal::get_md_int(from.getModuleFlag("halide_opt_level"), opt_level))
+        to.addModuleFlag(llvm::Module::Warning, "halide_opt_level", opt_level);
+
     std::string mattrs;
     if (Internal::get_md_string(from.getModuleFlag("halide_mattrs"), mattrs)) {
         #if LLVM_VERSION < 36
@@ -146,12 +174,15 @@ llvm::TargetMachine *get_target_machine(const llvm::Module &module) {
     std::string mattrs = "";
     get_target_options(module, options, mcpu, mattrs);
 
+    int opt_level = 3;
+    Internal::get_md_int(module.getModuleFlag("halide_opt_level"), opt_level);
+
     return target->createTargetMachine(module.getTargetTriple(),
                                        mcpu, mattrs,
                                        options,
                                        llvm::Reloc::PIC_,
                                        llvm::CodeModel::Default,
-                                       llvm::CodeGenOpt::Aggressive);
+                                       Internal::get_codegen_opt_level(opt_level));
 }
 
 #if LLVM_VERSION < 37
@@ -247,8 +278,203 @@ void emit_file(llvm::Module &module, const std::string &filename, llvm::TargetMa
 #endif
 }
 
+namespace {
+
+// The number of threads to use to compile independent parts of a
+// module. Defaults to one per core. HL_COMPILE_THREADS=1 compiles
+// everything on the calling thread. The environment is only read the
+// first time.
+int compile_threads() {
+    static const int threads = []() {
+#ifdef _MSC_VER
+        char buf[32];
+        size_t read = 0;
+        getenv_s(&read, buf, "HL_COMPILE_THREADS");
+        int threads = read ? atoi(buf) : 0;
+#else
+        char *buf = getenv("HL_COMPILE_THREADS");
+        int threads = buf ? atoi(buf) : 0;
+#endif
+        if (threads <= 0) {
+            threads = (int)std::thread::hardware_concurrency();
+        }
+        return std::max(threads, 1);
+    }();
+    return threads;
+}
+
+// Run some independent jobs on up to compile_threads() threads,
+// including the calling one. LLVM contexts are not thread-safe, so
+// each job must only touch LLVM state in a context of its own.
+void run_in_parallel(size_t jobs, std::function<void(size_t)> job) {
+    size_t threads = std::min((size_t)compile_threads(), jobs);
+    if (threads <= 1) {
+        for (size_t i = 0; i < jobs; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    #ifdef WITH_EXCEPTIONS
+    std::vector<std::exception_ptr> errors(jobs);
+    #endif
+    auto worker = [&]() {
+        for (size_t i = next++; i < jobs; i = next++) {
+            #ifdef WITH_EXCEPTIONS
+            try {
+                job(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            #else
+            job(i);
+            #endif
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < threads; i++) {
+        pool.push_back(std::thread(worker));
+    }
+    worker();
+    for (std::thread &t : pool) {
+        t.join();
+    }
+
+    #ifdef WITH_EXCEPTIONS
+    for (std::exception_ptr e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+    #endif
+}
+
+// Copy an llvm module into another context, by way of bitcode.
+std::unique_ptr<llvm::Module> clone_module(llvm::Module &module, llvm::LLVMContext &context) {
+    llvm::SmallVector<char, 0> buffer;
+    {
+        llvm::raw_svector_ostream stream(buffer);
+        WriteBitcodeToFile(&module, stream);
+        stream.flush();
+    }
+    llvm::StringRef data(buffer.data(), buffer.size());
+
+    #if LLVM_VERSION >= 36
+    auto ret_val = llvm::parseBitcodeFile(llvm::MemoryBufferRef(data, module.getModuleIdentifier()), context);
+    #else
+    llvm::MemoryBuffer *bitcode_buffer = llvm::MemoryBuffer::getMemBuffer(data);
+    auto ret_val = llvm::parseBitcodeFile(bitcode_buffer, context);
+    delete bitcode_buffer;
+    #endif
+    internal_assert(ret_val) << "Could not copy module " << module.getModuleIdentifier()
+                             << ": " << ret_val.getError().message() << "\n";
+
+    std::unique_ptr<llvm::Module> result(std::move(*ret_val));
+    return result;
+}
+
+// Link the definitions in src into dst. Both must be in the same context.
+void link_llvm_modules(llvm::Module &dst, std::unique_ptr<llvm::Module> src) {
+    std::string err_msg;
+    #if LLVM_VERSION >= 38
+    bool failed = llvm::Linker::linkModules(dst, std::move(src));
+    #elif LLVM_VERSION >= 36
+    bool failed = llvm::Linker::LinkModules(&dst, src.get());
+    #else
+    bool failed = llvm::Linker::LinkModules(&dst, src.get(), llvm::Linker::DestroySource, &err_msg);
+    #endif
+    internal_assert(!failed) << "Failure linking separately compiled functions: " << err_msg << "\n";
+}
+
+// Find the calls to extern functions in a function body.
+class FindExternCalls : public Internal::IRVisitor {
+    using Internal::IRVisitor::visit;
+
+    void visit(const Internal::Call *op) {
+        Internal::IRVisitor::visit(op);
+        if (op->call_type == Internal::Call::Extern) {
+            calls.insert(op->name);
+        }
+    }
+public:
+    std::set<std::string> calls;
+};
+
+// Split a module into parts that can be compiled separately, where no
+// function in one part calls a function in another. Modules that
+// can't safely be compiled piecewise are returned in one part.
+std::vector<Module> split_module(const Module &module) {
+    const Target &t = module.target();
+    if (module.functions.size() <= 1 ||
+        !module.buffers.empty() ||
+        t.has_gpu_feature() ||
+        t.has_feature(Target::Matlab) ||
+        t.arch == Target::PNaCl) {
+        return {module};
+    }
+
+    // Union the functions that call each other.
+    const std::vector<Internal::LoweredFunc> &funcs = module.functions;
+    std::vector<size_t> group(funcs.size());
+    for (size_t i = 0; i < funcs.size(); i++) {
+        group[i] = i;
+    }
+    std::function<size_t(size_t)> find = [&](size_t i) {
+        return group[i] == i ? i : (group[i] = find(group[i]));
+    };
+    for (size_t i = 0; i < funcs.size(); i++) {
+        FindExternCalls calls;
+        funcs[i].body.accept(&calls);
+        for (size_t j = 0; j < funcs.size(); j++) {
+            if (calls.calls.count(funcs[j].name)) {
+                group[find(i)] = find(j);
+            }
+        }
+    }
+
+    std::vector<Module> parts;
+    std::map<size_t, size_t> part_of_group;
+    for (size_t i = 0; i < funcs.size(); i++) {
+        size_t g = find(i);
+        if (!part_of_group.count(g)) {
+            part_of_group[g] = parts.size();
+            parts.push_back(Module(module.name() + "_" + funcs[i].name, t));
+        }
+        parts[part_of_group[g]].append(funcs[i]);
+    }
+    return parts;
+}
+
+}
+
 std::unique_ptr<llvm::Module> compile_module_to_llvm_module(const Module &module, llvm::LLVMContext &context) {
-    return codegen_llvm(module, context);
+    std::vector<Module> parts = split_module(module);
+    if (parts.size() == 1 || compile_threads() == 1) {
+        return codegen_llvm(module, context);
+    }
+
+    // Generate and optimize each part in a context of its own, in
+    // parallel, and then link the results into the given context. Each
+    // part has its own copy of the runtime functions it uses; these
+    // are weak or linkonce, so the linker merges them.
+    Internal::debug(1) << "Compiling " << parts.size() << " parts of module "
+                       << module.name() << " in parallel\n";
+    std::vector<std::unique_ptr<llvm::LLVMContext>> contexts(parts.size());
+    std::vector<std::unique_ptr<llvm::Module>> results(parts.size());
+    run_in_parallel(parts.size(), [&](size_t i) {
+        contexts[i].reset(new llvm::LLVMContext);
+        results[i] = codegen_llvm(parts[i], *contexts[i]);
+    });
+
+    std::unique_ptr<llvm::Module> result = clone_module(*results[0], context);
+    result->setModuleIdentifier(module.name());
+    for (size_t i = 1; i < results.size(); i++) {
+        link_llvm_modules(*result, clone_module(*results[i], context));
+    }
+
+    // Free the modules before their contexts.
+    results.clear();
+    return result;
 }
 
 void compile_llvm_module_to_object(llvm::Module &module, const std::string &filename) {
@@ -262,8 +488,24 @@ void compile_llvm_module_to_assembly(llvm::Module &module, const std::string &fi
 void compile_llvm_module_to_native(llvm::Module &module,
                                    const std::string &object_filename,
                                    const std::string &assembly_filename) {
-    emit_file(module, object_filename, llvm::TargetMachine::CGFT_ObjectFile);
-    emit_file(module, assembly_filename, llvm::TargetMachine::CGFT_AssemblyFile);
+    if (compile_threads() == 1) {
+        emit_file(module, object_filename, llvm::TargetMachine::CGFT_ObjectFile);
+        emit_file(module, assembly_filename, llvm::TargetMachine::CGFT_AssemblyFile);
+        return;
+    }
+
+    // The object file and the assembly are independent, so generate
+    // them at the same time, the assembly from a copy of the module in
+    // a context of its own.
+    llvm::LLVMContext context;
+    std::unique_ptr<llvm::Module> copy = clone_module(module, context);
+    run_in_parallel(2, [&](size_t i) {
+        if (i == 0) {
+            emit_file(module, object_filename, llvm::TargetMachine::CGFT_ObjectFile);
+        } else {
+            emit_file(*copy, assembly_filename, llvm::TargetMachine::CGFT_AssemblyFile);
+        }
+    });
 }
 
 void compile_llvm_module_to_llvm_bitcode(llvm::Module &module, const std::string &filename) {
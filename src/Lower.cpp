@@ -11,6 +11,7 @@
 #include "Bounds.h"
 #include "BoundsInference.h"
 #include "CSE.h"
+#include "ComputeWith.h"
 #include "Debug.h"
 #include "DebugToFile.h"
 #include "Deinterleave.h"
@@ -22,6 +23,7 @@
 #include "InjectImageIntrinsics.h"
 #include "InjectOpenGLIntrinsics.h"
 #include "Inline.h"
+#include "LICM.h"
 #include "IRMutator.h"
 #include "IROperator.h"
 #include "IRPrinter.h"
@@ -40,6 +42,7 @@
 #include "Simplify.h"
 #include "StorageFlattening.h"
 #include "StorageFolding.h"
+#include "StrengthReduction.h"
 #include "Substitute.h"
 #include "Tracing.h"
 #include "UnifyDuplicateLets.h"
@@ -79,7 +82,7 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
 
     if (any_memoized) {
         debug(1) << "Injecting memoization...\n";
-        s = inject_memoization(s, env, pipeline_name, outputs);
+        s = inject_memoization(s, env, pipeline_name, outputs, t);
         debug(2) << "Lowering after injecting memoization:\n" << s << '\n';
     } else {
         debug(1) << "Skipping injecting memoization...\n";
@@ -117,6 +120,10 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
     s = bounds_inference(s, outputs, order, env, func_bounds);
     debug(2) << "Lowering after computation bounds inference:\n" << s << '\n';
 
+    debug(1) << "Fusing loop nests of functions computed with each other...\n";
+    s = fuse_compute_with(s, env);
+    debug(2) << "Lowering after fusing loop nests:\n" << s << '\n';
+
     debug(1) << "Performing sliding window optimization...\n";
     s = sliding_window(s, env);
     debug(2) << "Lowering after sliding window:\n" << s << '\n';
@@ -137,7 +144,7 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
     debug(2) << "Lowering after uniquifying variable names:\n" << s << "\n\n";
 
     debug(1) << "Performing storage folding optimization...\n";
-    s = storage_folding(s);
+    s = storage_folding(s, env);
     debug(2) << "Lowering after storage folding:\n" << s << '\n';
 
     debug(1) << "Injecting debug_to_file calls...\n";
@@ -203,6 +210,10 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
     s = remove_trivial_for_loops(s);
     debug(2) << "Lowering after second simplifcation:\n" << s << "\n\n";
 
+    debug(1) << "Hoisting loop invariants...\n";
+    s = loop_invariant_code_motion(s);
+    debug(2) << "Lowering after hoisting loop invariants:\n" << s << "\n\n";
+
     debug(1) << "Unrolling...\n";
     s = unroll_loops(s);
     s = simplify(s);
@@ -223,6 +234,10 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
     s = simplify(s);
     debug(2) << "Lowering after partitioning loops:\n" << s << "\n\n";
 
+    debug(1) << "Strength-reducing loop indices...\n";
+    s = strength_reduce_loop_indices(s);
+    debug(2) << "Lowering after strength-reducing loop indices:\n" << s << "\n\n";
+
     debug(1) << "Injecting early frees...\n";
     s = inject_early_frees(s);
     debug(2) << "Lowering after injecting early frees:\n" << s << "\n\n";
@@ -244,6 +259,12 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
     s = simplify(s);
     debug(1) << "Lowering after final simplification:\n" << s << "\n\n";
 
+    if (t.has_feature(Target::Telemetry)) {
+        debug(1) << "Injecting telemetry...\n";
+        s = inject_telemetry(s, pipeline_name);
+        debug(2) << "Lowering after injecting telemetry:\n" << s << "\n\n";
+    }
+
     if (!custom_passes.empty()) {
         for (size_t i = 0; i < custom_passes.size(); i++) {
             debug(1) << "Running custom lowering pass " << i << "...\n";
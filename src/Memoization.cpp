@@ -1,13 +1,18 @@
 #include "Memoization.h"
+#include "Bounds.h"
 #include "Error.h"
 #include "IRMutator.h"
 #include "IROperator.h"
+#include "IRHash.h"
 #include "Param.h"
 #include "Scope.h"
+#include "Substitute.h"
 #include "Util.h"
 #include "Var.h"
 
+#include <atomic>
 #include <map>
+#include <set>
 
 namespace Halide {
 namespace Internal {
@@ -16,7 +21,7 @@ namespace {
 
 class FindParameterDependencies : public IRGraphVisitor {
 public:
-    FindParameterDependencies() { }
+    FindParameterDependencies(bool h) : hash_buffers(h) { }
     ~FindParameterDependencies() { }
 
     void visit_function(const Function &function) {
@@ -70,7 +75,16 @@ public:
     }
 
     void visit(const Variable *var) {
-        if (var->param.defined()) {
+        if (var->param.defined() && var->param.is_buffer() && hash_buffers) {
+            // A field of a buffer, such as its min or extent. Key on
+            // just that field, so that Funcs computed inside loops
+            // don't depend on the contents of the whole buffer.
+            struct DependencyInfo info;
+            info.type = var->type;
+            info.size_expr = info.type.bytes();
+            info.value_expr = var;
+            dependency_info[DependencyKey(info.type.bytes(), var->name)] = info;
+        } else if (var->param.defined()) {
             record(var->param);
         }
         IRGraphVisitor::visit(var);
@@ -81,12 +95,20 @@ public:
 
         info.type = parameter.type();
 
-        if (parameter.is_buffer()) {
+        if (parameter.is_buffer() && hash_buffers) {
+            // Use a hash of the buffer's contents, computed once at
+            // the start of the pipeline.
+            info.type = UInt(64);
+            info.size_expr = info.type.bytes();
+            info.value_expr = Internal::Variable::make(info.type, parameter.name() + ".content_hash");
+            hashed_buffers.insert(parameter.name());
+        } else if (parameter.is_buffer()) {
             internal_error << "Buffer parameter " << parameter.name() <<
                 " encountered in computed_cached computation.\n" <<
                 "Computations which depend on buffer parameters " <<
                 "cannot be scheduled compute_cached.\n" <<
-                "Use memoize_tag to provide cache key information for buffer.\n";
+                "Use memoize_tag to provide cache key information for buffer,\n" <<
+                "or schedule the Func with memoize_by_content.\n";
         } else if (info.type.is_handle()) {
             internal_error << "Handle parameter " << parameter.name() <<
                 " encountered in computed_cached computation.\n" <<
@@ -136,6 +158,11 @@ public:
     };
 
     std::map<DependencyKey, DependencyInfo> dependency_info;
+
+    // Whether to key on the contents of buffers, and the names of
+    // the buffers that are.
+    bool hash_buffers;
+    std::set<std::string> hashed_buffers;
 };
 
 typedef std::pair<FindParameterDependencies::DependencyKey, FindParameterDependencies::DependencyInfo> DependencyKeyInfoPair;
@@ -146,6 +173,12 @@ class KeyInfo {
     const std::string &top_level_name;
     const std::string &function_name;
 
+    // If the key is to be stable across processes, two independent
+    // hashes of the function's definition.
+    bool stable;
+    uint64_t identity_hash;
+    uint32_t identity_check;
+
     size_t parameters_alignment() {
         int32_t max_alignment = 0;
         // Find maximum natural alignment needed.
@@ -190,8 +223,14 @@ class KeyInfo {
 #endif
 
 public:
-  KeyInfo(const Function &function, const std::string &name)
-        : top_level_name(name), function_name(function.name())
+    // Pass stable = true, with two independent hashes of the
+    // function's definition, for a key that is stable across
+    // processes.
+    KeyInfo(const Function &function, const std::string &name,
+            bool stable = false, uint64_t identity_hash = 0, uint32_t identity_check = 0)
+        : dependencies(function.schedule().memoize_hash_buffers()),
+          top_level_name(name), function_name(function.name()),
+          stable(stable), identity_hash(identity_hash), identity_check(identity_check)
     {
         dependencies.visit_function(function);
         size_t size_so_far = 0;
@@ -214,6 +253,9 @@ public:
         }
     }
 
+    // The names of the buffers whose content hashes are in the key.
+    const std::set<std::string> &hashed_buffers() { return dependencies.hashed_buffers; }
+
     // Return the number of bytes needed to store the cache key
     // for the target function. Make sure it takes 4 bytes in cache key.
     Expr key_size() { return cast<int32_t>(key_size_expr); };
@@ -253,27 +295,38 @@ public:
         index += name_size;
         alignment += 4 + function_name.size();
 #else
-        // Store a pointer to a string identifying the filter and
-        // function. Assume this will be unique due to CSE. This can
-        // break with loading and unloading of code, though the name
-        // mechanism can also break in those conditions. For JIT, a
-        // counter is needed as the address may be reused. This isn't
-        // a problem when using full names as the function names
-        // already are uniquefied by a counter.
-        writes.push_back(Store::make(key_name,
-                                     StringImm::make(std::to_string(top_level_name.size()) + ":" + top_level_name +
-                                                     std::to_string(function_name.size()) + ":" + function_name),
-                                     (index / Handle().bytes())));
-        size_t alignment = Handle().bytes();
-        index += Handle().bytes();
-
-        // Halide compilation is not threadsafe anyway...
-        static int32_t memoize_instance = 0;
-        writes.push_back(Store::make(key_name,
-                                     memoize_instance++, // Use and increment counter
-                                     (index / Int(32).bytes())));
-        alignment += 4;
-        index += 4;
+        if (stable) {
+            // Addresses and compilation counters differ from process
+            // to process, so identify the function by its definition.
+            writes.push_back(Store::make(key_name, make_const(UInt(64), identity_hash),
+                                         (index / Handle().bytes())));
+            index += Handle().bytes();
+            writes.push_back(Store::make(key_name, make_const(UInt(32), identity_check),
+                                         (index / UInt(32).bytes())));
+            index += 4;
+        } else {
+            // Store a pointer to a string identifying the filter and
+            // function. Assume this will be unique due to CSE. This can
+            // break with loading and unloading of code, though the name
+            // mechanism can also break in those conditions. For JIT, a
+            // counter is needed as the address may be reused. This isn't
+            // a problem when using full names as the function names
+            // already are uniquefied by a counter.
+            writes.push_back(Store::make(key_name,
+                                         StringImm::make(std::to_string(top_level_name.size()) + ":" + top_level_name +
+                                                         std::to_string(function_name.size()) + ":" + function_name),
+                                         (index / Handle().bytes())));
+            index += Handle().bytes();
+
+            // Pipelines may be lowered on several threads at once
+            // (e.g. by the autotuner), so the counter is atomic.
+            static std::atomic<int32_t> memoize_instance(0);
+            writes.push_back(Store::make(key_name,
+                                         (int32_t)(memoize_instance++), // Use and increment counter
+                                         (index / Int(32).bytes())));
+            index += 4;
+        }
+        size_t alignment = Handle().bytes() + 4;
 #endif
 
         size_t needed_alignment = parameters_alignment();
@@ -352,20 +405,183 @@ public:
 
 }
 
+// Find the names of the Funcs realized in a Stmt.
+class FindRealizations : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Realize *op) {
+        names.push_back(op->name);
+        IRVisitor::visit(op);
+    }
+
+public:
+    std::vector<std::string> names;
+};
+
+// Does an Expr refer to the bounds of any of the given Funcs? Those
+// are only defined inside the realizations of the Funcs.
+class UsesFuncBounds : public IRVisitor {
+    using IRVisitor::visit;
+
+    const std::vector<std::string> &funcs;
+
+    void visit(const Variable *op) {
+        for (const std::string &f : funcs) {
+            if (starts_with(op->name, f + ".")) {
+                result = true;
+            }
+        }
+    }
+
+public:
+    bool result;
+    UsesFuncBounds(const std::vector<std::string> &f) : funcs(f), result(false) {}
+};
+
 // Inject caching structure around memoized realizations.
+// Hashes what a memoized Func computes, for keys that are stable
+// across processes: its definition, and the definitions of every Func
+// it calls, directly or indirectly (including Funcs that will be
+// inlined into it). Schedules aren't included, as they don't change
+// the values computed.
+class DefinitionHasher : public IRHasher {
+    const std::map<std::string, Function> &env;
+    std::set<std::string> seen;
+    std::vector<Function> pending;
+
+    using IRHasher::visit;
+
+    void add_callee(const std::string &name) {
+        std::map<std::string, Function>::const_iterator iter = env.find(name);
+        if (iter != env.end() && seen.insert(name).second) {
+            pending.push_back(iter->second);
+        }
+    }
+
+    void visit(const Call *op) {
+        IRHasher::visit(op);
+        if (op->call_type == Call::Halide) {
+            add_callee(op->name);
+        }
+    }
+
+    void include_exprs(const std::vector<Expr> &exprs) {
+        include((int64_t)exprs.size());
+        for (const Expr &e : exprs) {
+            include(e);
+        }
+    }
+
+    void include_definition(const Function &f) {
+        include(f.name());
+        include((int64_t)f.args().size());
+        for (const std::string &arg : f.args()) {
+            include(arg);
+        }
+        include((int64_t)f.output_types().size());
+        for (Type t : f.output_types()) {
+            include(t);
+        }
+        include_exprs(f.values());
+
+        include((int64_t)f.updates().size());
+        for (const UpdateDefinition &u : f.updates()) {
+            include_exprs(u.args);
+            include_exprs(u.values);
+            if (u.domain.defined()) {
+                include((int64_t)u.domain.domain().size());
+                for (const ReductionVariable &rv : u.domain.domain()) {
+                    include(rv.var);
+                    include(rv.min);
+                    include(rv.extent);
+                }
+            }
+        }
+
+        if (f.has_extern_definition()) {
+            include(f.extern_function_name());
+            include((int64_t)f.extern_arguments().size());
+            for (const ExternFuncArgument &arg : f.extern_arguments()) {
+                include((int64_t)arg.arg_type);
+                if (arg.is_func()) {
+                    Function callee(arg.func);
+                    include(callee.name());
+                    add_callee(callee.name());
+                } else if (arg.is_expr()) {
+                    include(arg.expr);
+                } else if (arg.is_buffer()) {
+                    include(arg.buffer.name());
+                } else if (arg.is_image_param()) {
+                    include(arg.image_param.name());
+                }
+            }
+        }
+    }
+
+public:
+    DefinitionHasher(const std::map<std::string, Function> &env,
+                     const std::string &salt) : env(env) {
+        include(salt);
+    }
+
+    uint64_t hash(const std::string &top_level_name, const Function &f) {
+        include(top_level_name);
+        seen.insert(f.name());
+        include_definition(f);
+        // Each callee is hashed once, in the order first called.
+        for (size_t i = 0; i < pending.size(); i++) {
+            include_definition(pending[i]);
+        }
+        return value();
+    }
+};
+
 class InjectMemoization : public IRMutator {
 public:
     const std::map<std::string, Function> &env;
     const std::string &top_level_name;
     const std::vector<Function> &outputs;
 
+    const Target &target;
+
   InjectMemoization(const std::map<std::string, Function> &e, const std::string &name,
-                    const std::vector<Function> &outputs) :
-    env(e), top_level_name(name), outputs(outputs) {}
+                    const std::vector<Function> &outputs, const Target &t) :
+    env(e), top_level_name(name), outputs(outputs), target(t) {}
+
+    // The buffers whose contents are part of some cache key.
+    std::set<std::string> hashed_buffers;
 private:
 
     using IRMutator::visit;
 
+    // Get an Expr that hashes the contents of the region of a buffer
+    // read by a realization, or an undefined Expr if that region
+    // can't be computed before the realization runs.
+    Expr region_hash(const std::string &buffer, const Box &box,
+                     const std::vector<std::string> &inner_funcs) {
+        std::vector<Expr> region_args;
+        region_args.push_back(Call::make(Handle(), Call::null_handle, std::vector<Expr>(), Call::Intrinsic));
+        region_args.push_back(make_zero(UInt(8)));
+        for (size_t i = 0; i < box.size(); i++) {
+            if (!box[i].min.defined() || !box[i].max.defined()) {
+                return Expr();
+            }
+            UsesFuncBounds uses(inner_funcs);
+            box[i].min.accept(&uses);
+            box[i].max.accept(&uses);
+            if (uses.result) {
+                return Expr();
+            }
+            region_args.push_back(box[i].min);
+            region_args.push_back(box[i].max - box[i].min + 1);
+            region_args.push_back(0);
+        }
+        Expr region = Call::make(Handle(), Call::create_buffer_t, region_args, Call::Intrinsic);
+        return Call::make(UInt(64), "halide_memoization_hash_buffer_region",
+                          {Variable::make(type_of<buffer_t *>(), buffer + ".buffer"), region},
+                          Call::Extern);
+    }
+
     void visit(const ProducerConsumer *op) {
         std::map<std::string, Function>::const_iterator iter = env.find(op->name);
         if (iter != env.end() &&
@@ -395,9 +611,49 @@ private:
             Stmt update = mutate(op->update);
             Stmt consume = mutate(op->consume);
 
-            KeyInfo key_info(f, top_level_name);
+            bool stable = target.has_feature(Target::MemoizeStableKeys);
+            uint64_t identity_hash = 0;
+            uint32_t identity_check = 0;
+            if (stable) {
+                // The pipeline and Func names, plus what the Func
+                // computes. The second hash is salted differently, so
+                // that a collision needs both to collide.
+                identity_hash = DefinitionHasher(env, "hash").hash(top_level_name, f);
+                identity_check = (uint32_t)DefinitionHasher(env, "check").hash(top_level_name, f);
+            }
+
+            KeyInfo key_info(f, top_level_name, stable, identity_hash, identity_check);
 
             std::string cache_key_name = op->name + ".cache_key";
+            Stmt key = key_info.generate_key(cache_key_name);
+
+            // Where possible, key on just the region of each input
+            // buffer that this realization reads, rather than on the
+            // whole buffer. For a Func computed inside a loop, this
+            // means a tile is only recomputed when the part of the
+            // input it depends on changes.
+            std::vector<std::pair<std::string, Expr>> region_hashes;
+            if (!key_info.hashed_buffers().empty()) {
+                Stmt s = op->update.defined() ? Block::make(op->produce, op->update) : op->produce;
+                std::map<std::string, Box> boxes = boxes_required(s);
+                FindRealizations inner;
+                s.accept(&inner);
+                for (const std::string &buffer : key_info.hashed_buffers()) {
+                    Expr hash;
+                    std::map<std::string, Box>::const_iterator b = boxes.find(buffer);
+                    if (b != boxes.end()) {
+                        hash = region_hash(buffer, b->second, inner.names);
+                    }
+                    if (hash.defined()) {
+                        std::string hash_name = op->name + "." + buffer + ".region_hash";
+                        key = substitute(buffer + ".content_hash", Variable::make(UInt(64), hash_name), key);
+                        region_hashes.push_back(std::make_pair(hash_name, hash));
+                    } else {
+                        hashed_buffers.insert(buffer);
+                    }
+                }
+            }
+
             std::string cache_result_name = op->name + ".cache_result";
             std::string cache_miss_name = op->name + ".cache_miss";
             std::string computed_bounds_name = op->name + ".computed_bounds.buffer";
@@ -442,7 +698,10 @@ private:
                                               Call::Intrinsic);
             Stmt computed_bounds_let = LetStmt::make(computed_bounds_name, computed_bounds, cache_lookup);
 
-            Stmt generate_key = Block::make(key_info.generate_key(cache_key_name), computed_bounds_let);
+            Stmt generate_key = Block::make(key, computed_bounds_let);
+            for (const std::pair<std::string, Expr> &h : region_hashes) {
+                generate_key = LetStmt::make(h.first, h.second, generate_key);
+            }
             Stmt cache_key_alloc =
                 Allocate::make(cache_key_name, UInt(8), {key_info.key_size()},
                                const_true(), generate_key);
@@ -456,10 +715,22 @@ private:
 
 Stmt inject_memoization(Stmt s, const std::map<std::string, Function> &env,
                         const std::string &name,
-                        const std::vector<Function> &outputs) {
-    InjectMemoization injector(env, name, outputs);
+                        const std::vector<Function> &outputs,
+                        const Target &target) {
+    InjectMemoization injector(env, name, outputs, target);
+
+    s = injector.mutate(s);
+
+    // Input buffers don't change while the pipeline runs, so hash each
+    // one once up front rather than at every cache lookup.
+    for (const std::string &buffer : injector.hashed_buffers) {
+        Expr hash = Call::make(UInt(64), "halide_memoization_hash_buffer",
+                               {Variable::make(type_of<buffer_t *>(), buffer + ".buffer")},
+                               Call::Extern);
+        s = LetStmt::make(buffer + ".content_hash", hash, s);
+    }
 
-    return injector.mutate(s);
+    return s;
 }
 
 class RewriteMemoizedAllocations : public IRMutator {
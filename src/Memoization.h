@@ -10,6 +10,7 @@
 #include <map>
 
 #include "IR.h"
+#include "Target.h"
 
 namespace Halide {
 namespace Internal {
@@ -18,11 +19,16 @@ namespace Internal {
  *  lookup call to the runtime cache implementation, and if there is a
  *  miss, compute the results and call the runtime to store it back to
  *  the cache.
- *  Should leave non-memoized Funcs unchanged.
+ *  Should leave non-memoized Funcs unchanged. If the target has
+ *  the MemoizeStableKeys feature, the keys identify each Func by a
+ *  hash of its definition and the definitions of the Funcs it calls,
+ *  so that they are the same in every process running the same
+ *  pipeline.
  */
 Stmt inject_memoization(Stmt s, const std::map<std::string, Function> &env,
                         const std::string &name,
-                        const std::vector<Function> &outputs);
+                        const std::vector<Function> &outputs,
+                        const Target &target);
 
 /** This should be called after Storage Flattening has added Allocation
  *  IR nodes. It connects the memoization cache lookups to the Allocations
@@ -49,8 +49,7 @@ void compile_module_to_native(const Module &module,
 
     llvm::LLVMContext context;
     std::unique_ptr<llvm::Module> llvm(compile_module_to_llvm_module(module, context));
-    compile_llvm_module_to_object(*llvm, object_filename);
-    compile_llvm_module_to_assembly(*llvm, assembly_filename);
+    compile_llvm_module_to_native(*llvm, object_filename, assembly_filename);
 }
 
 void compile_module_to_llvm_bitcode(const Module &module, std::string filename)  {
@@ -87,6 +86,12 @@ void compile_module_to_html(const Module &module, std::string filename) {
     Internal::print_to_html(filename, module);
 }
 
+void compile_module_to_html(const Module &module, const StmtProfile &profile, std::string filename) {
+    if (filename.empty()) filename = module.name() + ".html";
+
+    Internal::print_to_html(filename, module, profile);
+}
+
 void compile_module_to_text(const Module &module, std::string filename) {
     if (filename.empty()) filename = module.name() + ".stmt";
 
@@ -7,6 +7,7 @@
  * objects from Halide Module objects.
  */
 
+#include "CostReport.h"
 #include "Module.h"
 
 namespace Halide {
@@ -51,6 +52,12 @@ EXPORT void compile_module_to_c(const Module &module,
  * module with the extension .html. */
 EXPORT void compile_module_to_html(const Module &module, std::string filename = "");
 
+/** Output the module to HTML, annotated with the given performance
+ * data. The default filename is the name of the module with the
+ * extension .html. */
+EXPORT void compile_module_to_html(const Module &module, const StmtProfile &profile,
+                                   std::string filename = "");
+
 /** Output the module to a text statement file. The default filename
  * is the name of the module with the extension .stmt. */
 EXPORT void compile_module_to_text(const Module &module, std::string filename = "");
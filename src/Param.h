@@ -119,6 +119,11 @@ public:
         return type_of<T>();
     }
 
+    /** Get the internal parameter object this refers to. */
+    Internal::Parameter parameter() const {
+        return param;
+    }
+
     /** Get or set the possible range of this parameter. Use undefined
      * Exprs to mean unbounded. */
     // @{
@@ -1,7 +1,12 @@
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #include "Pipeline.h"
 #include "Argument.h"
+#include "AutoSchedule.h"
 #include "Func.h"
 #include "IRVisitor.h"
 #include "LLVM_Headers.h"
@@ -39,6 +44,71 @@ struct InferredArgument {
     }
 };
 
+/** The jit-compiled code for a Pipeline and the arguments it takes,
+ * copied together under the Pipeline's jit mutex. Calls into jitted
+ * code go through a snapshot, so that another thread recompiling the
+ * Pipeline, or switching it to the result of a tiered compile, can't
+ * change either out from under them. */
+struct JITSnapshot {
+    JITModule module;
+    Target target;
+    vector<InferredArgument> args;
+};
+
+/** A background compile of the optimized module for a tiered jit
+ * compile (see Target::TieredJIT). Shared between the compiling
+ * thread and the Pipeline, so that the Pipeline can abandon a compile
+ * without waiting for it: the thread holds its own reference, and the
+ * result is thrown away when the last reference goes. The Pipeline
+ * still joins the thread, when it next starts a compile or when it is
+ * destroyed, so that no compile outlives it. */
+struct TieredJITCompile {
+    mutable RefCount ref_count;
+
+    /** Set once the thread is done, whether or not it succeeded. */
+    std::mutex mutex;
+    std::condition_variable done_cond;
+    bool done;
+
+    /** The optimized module. Only touched by the compiling thread
+     * until ready is set. */
+    JITModule module;
+    std::atomic<bool> ready;
+
+    /** Set if the Pipeline no longer wants the result. */
+    std::atomic<bool> cancelled;
+
+    TieredJITCompile() : done(false), ready(false), cancelled(false) {}
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cond.wait(lock, [this]() { return done; });
+    }
+
+    void finish() {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        done_cond.notify_all();
+    }
+
+    bool is_done() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return done;
+    }
+};
+
+namespace Internal {
+template<>
+EXPORT RefCount &ref_count<TieredJITCompile>(const TieredJITCompile *p) {
+    return p->ref_count;
+}
+
+template<>
+EXPORT void destroy<TieredJITCompile>(const TieredJITCompile *p) {
+    delete p;
+}
+}
+
 struct PipelineContents {
     mutable RefCount ref_count;
 
@@ -49,8 +119,67 @@ struct PipelineContents {
     JITModule jit_module;
     Target jit_target;
 
+    /** When jit-compiling with Target::TieredJIT, the background
+     * compile of the optimized module, if one is in progress or its
+     * result hasn't been switched to yet. */
+    IntrusivePtr<TieredJITCompile> tiered_jit;
+
+    /** The threads running or that ran tiered jit compiles, including
+     * cancelled ones, that haven't been joined yet. */
+    struct TieredJITThread {
+        IntrusivePtr<TieredJITCompile> compile;
+        std::thread thread;
+    };
+    vector<TieredJITThread> tiered_jit_threads;
+
+    /** Join the threads of compiles that have finished. If wait is
+     * true, wait for and join all of them instead. */
+    void join_tiered_jit_threads(bool wait) {
+        vector<TieredJITThread> running;
+        for (TieredJITThread &t : tiered_jit_threads) {
+            if (wait || t.compile.ptr->is_done()) {
+                t.thread.join();
+            } else {
+                running.push_back(std::move(t));
+            }
+        }
+        tiered_jit_threads.swap(running);
+    }
+
+    /** Wait for the background compile of a tiered jit compile, if
+     * any, to finish. */
+    void wait_for_tiered_jit() {
+        if (tiered_jit.defined()) {
+            tiered_jit.ptr->wait();
+        }
+    }
+
+    /** Switch to the optimized module from a tiered jit compile if
+     * it's ready. Calls into jitted code hold their own reference to
+     * the module they started with (see JITSnapshot), so replacing
+     * jit_module doesn't disturb them. */
+    void swap_in_tiered_jit() {
+        if (tiered_jit.defined() && tiered_jit.ptr->ready) {
+            debug(2) << "Switching to the optimized jit module\n";
+            jit_module = tiered_jit.ptr->module;
+            tiered_jit = IntrusivePtr<TieredJITCompile>();
+        }
+    }
+
+    /** Abandon any background compilation without waiting for it. It
+     * runs to completion on its own thread, and its result is
+     * discarded. The thread is joined later (see
+     * join_tiered_jit_threads). */
+    void cancel_tiered_jit() {
+        if (tiered_jit.defined()) {
+            tiered_jit.ptr->cancelled = true;
+            tiered_jit = IntrusivePtr<TieredJITCompile>();
+        }
+    }
+
     /** Clear all cached state */
     void invalidate_cache() {
+        cancel_tiered_jit();
         module = Module("", Target());
         jit_module = JITModule();
         jit_target = Target();
@@ -80,6 +209,13 @@ struct PipelineContents {
      * define_extern calls. */
     std::map<std::string, JITExtern> jit_externs;
 
+    /** Guards the jit-compiled state above (jit_module, jit_target,
+     * inferred_args and the tiered jit members), so that threads
+     * calling the thread-safe forms of realize compile only once and
+     * see a consistent module and argument list. Recursive because
+     * compile_jit takes it and is also called with it held. */
+    std::recursive_mutex jit_mutex;
+
     PipelineContents() :
         module("", Target()) {
         user_context_arg.arg = Argument("__user_context", Argument::InputScalar, Handle(), 0);
@@ -89,6 +225,10 @@ struct PipelineContents {
 
     ~PipelineContents() {
         clear_custom_lowering_passes();
+        // Don't leave a compile running on its own once the Pipeline
+        // is gone (e.g. when the program exits), including ones that
+        // were cancelled.
+        join_tiered_jit_threads(true);
     }
 
     void clear_custom_lowering_passes() {
@@ -143,6 +283,17 @@ vector<Func> Pipeline::outputs() {
     return funcs;
 }
 
+string Pipeline::auto_schedule(const Target &target) {
+    user_assert(defined()) << "Can't auto schedule undefined Pipeline.\n";
+    invalidate_cache();
+    return generate_schedules(contents.ptr->outputs, target);
+}
+
+CostReport Pipeline::analyze(const vector<int32_t> &sizes, const Target &target) {
+    user_assert(defined()) << "Can't analyze undefined Pipeline.\n";
+    return analyze_costs(contents.ptr->outputs, sizes, target);
+}
+
 void Pipeline::compile_to(const Outputs &output_files,
                           const vector<Argument> &args,
                           const string &fn_name,
@@ -159,18 +310,26 @@ void Pipeline::compile_to(const Outputs &output_files,
     llvm::LLVMContext context;
     std::unique_ptr<llvm::Module> llvm_module(compile_module_to_llvm_module(m, context));
 
-    if (!output_files.object_name.empty()) {
-        if (target.arch == Target::PNaCl) {
-            compile_llvm_module_to_llvm_bitcode(*llvm_module, output_files.object_name);
-        } else {
-            compile_llvm_module_to_object(*llvm_module, output_files.object_name);
+    if (!output_files.object_name.empty() &&
+        !output_files.assembly_name.empty() &&
+        target.arch != Target::PNaCl) {
+        // Generate both at once.
+        compile_llvm_module_to_native(*llvm_module, output_files.object_name,
+                                      output_files.assembly_name);
+    } else {
+        if (!output_files.object_name.empty()) {
+            if (target.arch == Target::PNaCl) {
+                compile_llvm_module_to_llvm_bitcode(*llvm_module, output_files.object_name);
+            } else {
+                compile_llvm_module_to_object(*llvm_module, output_files.object_name);
+            }
         }
-    }
-    if (!output_files.assembly_name.empty()) {
-        if (target.arch == Target::PNaCl) {
-            compile_llvm_module_to_llvm_assembly(*llvm_module, output_files.assembly_name);
-        } else {
-            compile_llvm_module_to_assembly(*llvm_module, output_files.assembly_name);
+        if (!output_files.assembly_name.empty()) {
+            if (target.arch == Target::PNaCl) {
+                compile_llvm_module_to_llvm_assembly(*llvm_module, output_files.assembly_name);
+            } else {
+                compile_llvm_module_to_assembly(*llvm_module, output_files.assembly_name);
+            }
         }
     }
     if (!output_files.bitcode_name.empty()) {
@@ -232,6 +391,14 @@ void Pipeline::compile_to_lowered_stmt(const string &filename,
     }
 }
 
+void Pipeline::compile_to_lowered_stmt(const string &filename,
+                                       const vector<Argument> &args,
+                                       const StmtProfile &profile,
+                                       const Target &target) {
+    Module m = compile_to_module(args, "", target);
+    compile_module_to_html(m, profile, filename);
+}
+
 void Pipeline::compile_to_file(const string &filename_prefix,
                                const vector<Argument> &args,
                                const Target &target) {
@@ -580,12 +747,18 @@ std::string Pipeline::generate_function_name() {
 void *Pipeline::compile_jit(const Target &target_arg) {
     user_assert(defined()) << "Pipeline is undefined\n";
 
+    std::lock_guard<std::recursive_mutex> lock(contents.ptr->jit_mutex);
+
     Target target(target_arg);
     target.set_feature(Target::JIT);
     target.set_feature(Target::UserContext);
 
     debug(2) << "jit-compiling for: " << target_arg.to_string() << "\n";
 
+    // If an optimized module is waiting from an earlier tiered
+    // compile, this is a safe point to start using it.
+    contents.ptr->swap_in_tiered_jit();
+
     // If we're re-jitting for the same target, we can just keep the
     // old jit module.
     if (contents.ptr->jit_target == target &&
@@ -594,6 +767,10 @@ void *Pipeline::compile_jit(const Target &target_arg) {
         return contents.ptr->jit_module.main_function();
     }
 
+    // Anything still compiling in the background was for a different
+    // target.
+    contents.ptr->cancel_tiered_jit();
+
     contents.ptr->jit_target = target;
 
     // Infer an arguments vector
@@ -614,20 +791,72 @@ void *Pipeline::compile_jit(const Target &target_arg) {
     internal_assert(module.buffers.empty());
 
     std::map<std::string, JITExtern> lowered_externs = contents.ptr->jit_externs;
-    // Compile to jit module
-    JITModule jit_module(module, module.functions.back(),
-                         make_externs_jit_module(target_arg, lowered_externs));
+    vector<JITModule> externs = make_externs_jit_module(target_arg, lowered_externs);
 
     if (debug::debug_level >= 3) {
         compile_module_to_native(module, name + ".bc", name + ".s");
         compile_module_to_text(module, name + ".stmt");
     }
 
+    if (!target.has_feature(Target::TieredJIT) || target.opt_level() == 0) {
+        // Compile to jit module
+        JITModule jit_module(module, module.functions.back(), externs);
+        contents.ptr->jit_module = jit_module;
+        return jit_module.main_function();
+    }
+
+    // Tiered compilation. Most of the time in a JIT compile is LLVM's
+    // optimization and codegen, so codegen the lowered module once
+    // with no optimization for immediate use, and again at the
+    // target's optimization level on another thread. Lowering isn't
+    // repeated; only the module's target differs.
+    Module fast_module(module.name(), target.with_feature(Target::OptLevel0));
+    for (const LoweredFunc &f : module.functions) {
+        fast_module.append(f);
+    }
+    JITModule jit_module(fast_module, fast_module.functions.back(), externs);
     contents.ptr->jit_module = jit_module;
 
+    // The thread only touches its own TieredJITCompile, so the
+    // Pipeline can drop the compile (e.g. when it is rescheduled)
+    // without waiting for it. Threads are joined once they're done,
+    // here or when the Pipeline is destroyed.
+    contents.ptr->join_tiered_jit_threads(false);
+    IntrusivePtr<TieredJITCompile> tiered(new TieredJITCompile);
+    contents.ptr->tiered_jit = tiered;
+    std::thread thread([tiered, module, externs]() {
+        TieredJITCompile *t = tiered.ptr;
+        if (!t->cancelled) {
+            debug(2) << "Compiling optimized jit module in the background\n";
+            #ifdef WITH_EXCEPTIONS
+            try {
+            #endif
+                JITModule optimized(module, module.functions.back(), externs);
+                if (!t->cancelled) {
+                    t->module = optimized;
+                    t->ready = true;
+                }
+            #ifdef WITH_EXCEPTIONS
+            } catch (const Error &e) {
+                // The unoptimized module compiled, so keep using it.
+                debug(1) << "Background compilation of optimized jit module failed: " << e.what() << "\n";
+            }
+            #endif
+        }
+        t->finish();
+    });
+    contents.ptr->tiered_jit_threads.push_back({tiered, std::move(thread)});
+
     return jit_module.main_function();
 }
 
+void Pipeline::wait_for_tiered_jit() {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    std::lock_guard<std::recursive_mutex> lock(contents.ptr->jit_mutex);
+    contents.ptr->wait_for_tiered_jit();
+    contents.ptr->swap_in_tiered_jit();
+}
+
 
 void Pipeline::set_error_handler(void (*handler)(void *, const char *)) {
     user_assert(defined()) << "Pipeline is undefined\n";
@@ -751,16 +980,25 @@ struct ErrorBuffer {
             len++;
         }
 
-        // Atomically claim some space in the buffer
+        // Atomically claim some space in the buffer. The buffer may be
+        // reused across calls (see BoundRealization), so never let end
+        // run past the end of it.
+        int old_end;
+        while (true) {
+            old_end = end;
+            if (old_end + len >= MaxBufSize - 1) {
+                // Out of space
+                return;
+            }
 #ifdef _MSC_VER
-        int old_end = _InterlockedExchangeAdd((volatile long *)(&end), len);
+            if (_InterlockedCompareExchange((volatile long *)(&end), (long)(old_end + len), old_end) == old_end) {
+                break;
+            }
 #else
-        int old_end = __sync_fetch_and_add(&end, len);
+            if (__sync_bool_compare_and_swap(&end, old_end, (int)(old_end + len))) {
+                break;
+            }
 #endif
-
-        if (old_end + len >= MaxBufSize - 1) {
-            // Out of space
-            return;
         }
 
         for (size_t i = 0; i < len - 1; i++) {
@@ -775,6 +1013,10 @@ struct ErrorBuffer {
         return std::string(buf, end);
     }
 
+    void clear() {
+        end = 0;
+    }
+
     static void handler(void *ctx, const char *message) {
         if (ctx) {
             JITUserContext *ctx1 = (JITUserContext *)ctx;
@@ -787,10 +1029,12 @@ struct ErrorBuffer {
 struct JITFuncCallContext {
     ErrorBuffer error_buffer;
     JITUserContext jit_context;
-    Parameter &user_context_param;
+    Parameter *user_context_param;
     bool custom_error_handler;
 
-    JITFuncCallContext(const JITHandlers &handlers, Parameter &user_context_param)
+    // If user_context_param is NULL, the caller is responsible for
+    // passing a pointer to jit_context as the user context argument.
+    JITFuncCallContext(const JITHandlers &handlers, Parameter *user_context_param)
         : user_context_param(user_context_param) {
         void *user_context = NULL;
         JITHandlers local_handlers = handlers;
@@ -802,7 +1046,9 @@ struct JITFuncCallContext {
             custom_error_handler = true;
         }
         JITSharedRuntime::init_jit_user_context(jit_context, user_context, local_handlers);
-        user_context_param.set_scalar(&jit_context);
+        if (user_context_param) {
+            user_context_param->set_scalar(&jit_context);
+        }
 
         debug(2) << "custom_print: " << (void *)jit_context.handlers.custom_print << '\n'
                  << "custom_malloc: " << (void *)jit_context.handlers.custom_malloc << '\n'
@@ -814,6 +1060,16 @@ struct JITFuncCallContext {
     }
 
     void report_if_error(int exit_status) {
+        // Empty the buffer on the way out, even if reporting the error
+        // throws, so that the next call through a reused context
+        // starts afresh.
+        struct ClearOnExit {
+            ErrorBuffer &buffer;
+            ~ClearOnExit() {
+                buffer.clear();
+            }
+        } clear_on_exit = {error_buffer};
+
         // Only report the errors if no custom error handler was installed
         if (exit_status && !custom_error_handler) {
             std::string output = error_buffer.str();
@@ -823,27 +1079,140 @@ struct JITFuncCallContext {
                           " but halide_error was never called.\n");
             }
             halide_runtime_error << output;
-            error_buffer.end = 0;
         }
     }
 
     void finalize(int exit_status) {
         report_if_error(exit_status);
-        user_context_param.set_scalar((void *)NULL); // Don't leave param hanging with pointer to stack.
+        if (user_context_param) {
+            user_context_param->set_scalar((void *)NULL); // Don't leave param hanging with pointer to stack.
+        }
     }
 };
 }
 
-// Make a vector of void *'s to pass to the jit call using the
-// currently bound value for all of the params and image
-// params. Unbound image params produce null values.
-vector<const void *> Pipeline::prepare_jit_call_arguments(Realization dst, const Target &target) {
-    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+struct BoundRealizationContents {
+    mutable RefCount ref_count;
 
-    compile_jit(target);
+    // The compiled code. Holding a reference here keeps it alive even
+    // if the Pipeline is subsequently rescheduled and recompiled.
+    JITModule jit_module;
+    JITModule::argv_wrapper argv_function;
+
+    // The argument vector passed to argv_function on every call.
+    vector<const void *> args;
+
+    // The Buffers and Params the args vector points into.
+    vector<Buffer> buffers;
+    vector<Parameter> params;
+    vector<Buffer> outputs;
+
+    // The user context argument. Points at jit_context.jit_context.
+    void *user_context;
+    JITFuncCallContext jit_context;
+
+    // Profiler entry points, if the target has the profile feature.
+    void (*profiler_report)(void *);
+    void (*profiler_reset)();
+
+    BoundRealizationContents(const JITHandlers &handlers) :
+        argv_function(NULL), user_context(NULL),
+        jit_context(handlers, NULL),
+        profiler_report(NULL), profiler_reset(NULL) {
+    }
+};
 
-    JITModule &compiled_module = contents.ptr->jit_module;
-    internal_assert(compiled_module.argv_function());
+namespace Internal {
+template<>
+EXPORT RefCount &ref_count<BoundRealizationContents>(const BoundRealizationContents *p) {
+    return p->ref_count;
+}
+
+template<>
+EXPORT void destroy<BoundRealizationContents>(const BoundRealizationContents *p) {
+    delete p;
+}
+}
+
+BoundRealization::BoundRealization() : contents(NULL) {
+}
+
+bool BoundRealization::defined() const {
+    return contents.defined();
+}
+
+Realization BoundRealization::outputs() const {
+    user_assert(defined()) << "BoundRealization is undefined\n";
+    return Realization(contents.ptr->outputs);
+}
+
+void BoundRealization::realize() {
+    user_assert(defined()) << "Can't realize an undefined BoundRealization\n";
+    BoundRealizationContents *c = contents.ptr;
+
+    // Everything was validated when the realization was bound, so
+    // go straight into the jitted code. See Pipeline::realize for
+    // how the handlers in the user context get used.
+    int exit_status = c->argv_function(&(c->args[0]));
+
+    if (c->profiler_report) {
+        c->profiler_report(c->user_context);
+        c->profiler_reset();
+    }
+
+    c->jit_context.report_if_error(exit_status);
+}
+
+ParamMap::ParamMapping &ParamMap::get_mapping(const Parameter &p) {
+    for (ParamMapping &m : mappings) {
+        if (m.param.same_as(p)) {
+            return m;
+        }
+    }
+    ParamMapping m = {p, Buffer(), 0};
+    mappings.push_back(m);
+    return mappings.back();
+}
+
+void ParamMap::set_scalar(const Parameter &p, Type t, const void *value) {
+    user_assert(!p.is_buffer())
+        << "Can't set ImageParam " << p.name() << " to a scalar value in a ParamMap\n";
+    user_assert(p.type() == t)
+        << "Can't set Param<" << p.type() << "> " << p.name()
+        << " to a value of type " << t << " in a ParamMap\n";
+    internal_assert(t.bytes() <= (int)sizeof(uint64_t));
+    ParamMapping &m = get_mapping(p);
+    memcpy(&m.scalar, value, t.bytes());
+}
+
+void ParamMap::set(const ImageParam &p, Buffer buf) {
+    user_assert(buf.defined())
+        << "Can't set ImageParam " << p.name() << " to an undefined Buffer in a ParamMap\n";
+    get_mapping(p.parameter()).buffer = buf;
+}
+
+const void *ParamMap::find(const Parameter &p) const {
+    for (const ParamMapping &m : mappings) {
+        if (m.param.same_as(p)) {
+            if (p.is_buffer()) {
+                return m.buffer.raw_buffer();
+            } else {
+                return &m.scalar;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Make a vector of void *'s to pass to the jit call using the values
+// in the ParamMap, or failing that the currently bound value, for all
+// of the params and image params. Unbound image params produce null
+// values.
+vector<const void *> Pipeline::prepare_jit_call_arguments(Realization dst, const ParamMap &params,
+                                                          const JITSnapshot &jit) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+
+    internal_assert(jit.module.argv_function());
 
     struct OutputBufferType {
         Function func;
@@ -885,12 +1254,16 @@ vector<const void *> Pipeline::prepare_jit_call_arguments(Realization dst, const
     }
 
     // Come up with the void * arguments to pass to the argv function
-    const vector<InferredArgument> &input_args = contents.ptr->inferred_args;
+    const vector<InferredArgument> &input_args = jit.args;
     vector<const void *> arg_values;
 
     // First the inputs
-    for (InferredArgument arg : input_args) {
-        if (arg.param.defined() && arg.param.is_buffer()) {
+    for (const InferredArgument &arg : input_args) {
+        const void *mapped = arg.param.defined() ? params.find(arg.param) : NULL;
+        if (mapped) {
+            arg_values.push_back(mapped);
+            debug(1) << "JIT input argument from ParamMap ";
+        } else if (arg.param.defined() && arg.param.is_buffer()) {
             // ImageParam arg
             Buffer buf = arg.param.get_buffer();
             if (buf.defined()) {
@@ -913,7 +1286,7 @@ vector<const void *> Pipeline::prepare_jit_call_arguments(Realization dst, const
     }
 
     // Then the outputs
-    for (Buffer buf : dst.as_vector()) {
+    for (const Buffer &buf : dst.as_vector()) {
         internal_assert(buf.defined()) << "Can't realize into an undefined Buffer\n";
         arg_values.push_back(buf.raw_buffer());
         const void *ptr = arg_values.back();
@@ -973,27 +1346,32 @@ Pipeline::make_externs_jit_module(const Target &target,
     return result;
 }
 
-void Pipeline::realize(Realization dst, const Target &t) {
-    Target target = t;
-    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
-
-    debug(2) << "Realizing Pipeline for " << target.to_string() << "\n";
-
+Target Pipeline::realization_target(const Target &t) {
     // If target is unspecified...
-    if (target.os == Target::OSUnknown) {
+    if (t.os == Target::OSUnknown) {
         // If we've already jit-compiled for a specific target, use that.
         if (contents.ptr->jit_module.compiled()) {
-            target = contents.ptr->jit_target;
+            return contents.ptr->jit_target;
         } else {
             // Otherwise get the target from the environment
-            target = get_jit_target_from_environment();
+            return get_jit_target_from_environment();
         }
     }
+    return t;
+}
 
-    vector<const void *> args = prepare_jit_call_arguments(dst, target);
+JITSnapshot Pipeline::jit_snapshot(const Target &t) {
+    std::lock_guard<std::recursive_mutex> lock(contents.ptr->jit_mutex);
+    Target target = realization_target(t);
+    debug(2) << "Realizing Pipeline for " << target.to_string() << "\n";
+    compile_jit(target);
+    JITSnapshot jit = {contents.ptr->jit_module, contents.ptr->jit_target, contents.ptr->inferred_args};
+    return jit;
+}
 
-    for (size_t i = 0; i < contents.ptr->inferred_args.size(); i++) {
-        const InferredArgument &arg = contents.ptr->inferred_args[i];
+void Pipeline::check_inputs_bound(const vector<const void *> &args, const JITSnapshot &jit) {
+    for (size_t i = 0; i < jit.args.size(); i++) {
+        const InferredArgument &arg = jit.args[i];
         const void *arg_value = args[i];
         if (arg.param.defined()) {
             user_assert(arg_value != NULL)
@@ -1001,6 +1379,16 @@ void Pipeline::realize(Realization dst, const Target &t) {
                 << arg.param.name() << " is not bound to a Buffer\n";
         }
     }
+}
+
+void Pipeline::realize(Realization dst, const Target &t) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+
+    JITSnapshot jit = jit_snapshot(t);
+
+    vector<const void *> args = prepare_jit_call_arguments(dst, ParamMap(), jit);
+
+    check_inputs_bound(args, jit);
 
     // We need to make a context for calling the jitted function to
     // carry the the set of custom handlers. Here's how handlers get
@@ -1024,7 +1412,7 @@ void Pipeline::realize(Realization dst, const Target &t) {
     // user_context is just a pointer to a JITUserContext, which is a
     // member of the JITFuncCallContext which we will declare now:
 
-    JITFuncCallContext jit_context(jit_handlers(), contents.ptr->user_context_arg.param);
+    JITFuncCallContext jit_context(jit_handlers(), &contents.ptr->user_context_arg.param);
 
     // The handlers in the jit_context default to the default handlers
     // in the runtime of the shared module (e.g. halide_print_impl,
@@ -1064,17 +1452,17 @@ void Pipeline::realize(Realization dst, const Target &t) {
     // exception.
 
     debug(2) << "Calling jitted function\n";
-    int exit_status = contents.ptr->jit_module.argv_function()(&(args[0]));
+    int exit_status = jit.module.argv_function()(&(args[0]));
     debug(2) << "Back from jitted function. Exit status was " << exit_status << "\n";
 
     // If we're profiling, report runtimes and reset profiler stats.
-    if (target.has_feature(Target::Profile)) {
+    if (jit.target.has_feature(Target::Profile)) {
         JITModule::Symbol report_sym =
-            contents.ptr->jit_module.find_symbol_by_name("halide_profiler_report");
+            jit.module.find_symbol_by_name("halide_profiler_report");
         JITModule::Symbol reset_sym =
-            contents.ptr->jit_module.find_symbol_by_name("halide_profiler_reset");
+            jit.module.find_symbol_by_name("halide_profiler_reset");
         if (report_sym.address && reset_sym.address) {
-            void *uc = jit_context.user_context_param.get_scalar<void *>();
+            void *uc = &jit_context.jit_context;
             void (*report_fn_ptr)(void *) = (void (*)(void *))(report_sym.address);
             report_fn_ptr(uc);
 
@@ -1086,11 +1474,104 @@ void Pipeline::realize(Realization dst, const Target &t) {
     jit_context.finalize(exit_status);
 }
 
+void Pipeline::realize(Realization dst, const ParamMap &params, const Target &t) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+
+    // Compile (or find the already-compiled module) under the lock,
+    // and hold our own references to the module and its arguments,
+    // so that nothing below touches state shared with other threads.
+    JITSnapshot jit = jit_snapshot(t);
+
+    vector<const void *> args = prepare_jit_call_arguments(dst, params, jit);
+
+    check_inputs_bound(args, jit);
+
+    // Pass a pointer to a context on this thread's stack as the user
+    // context, instead of setting the Pipeline's user context
+    // Param. See Pipeline::realize above for how it gets used.
+    JITFuncCallContext jit_context(jit_handlers(), NULL);
+    void *user_context = &jit_context.jit_context;
+    for (size_t i = 0; i < jit.args.size(); i++) {
+        if (jit.args[i].param.same_as(contents.ptr->user_context_arg.param)) {
+            args[i] = &user_context;
+        }
+    }
+
+    debug(2) << "Calling jitted function\n";
+    int exit_status = jit.module.argv_function()(&(args[0]));
+    debug(2) << "Back from jitted function. Exit status was " << exit_status << "\n";
+
+    jit_context.finalize(exit_status);
+}
+
+void Pipeline::realize(Buffer b, const ParamMap &params, const Target &target) {
+    realize(Realization({b}), params, target);
+}
+
+BoundRealization Pipeline::bind_realization(Realization dst, const Target &t) {
+    user_assert(defined()) << "Can't bind a realization of an undefined Pipeline\n";
+
+    JITSnapshot jit = jit_snapshot(t);
+
+    vector<const void *> args = prepare_jit_call_arguments(dst, ParamMap(), jit);
+
+    check_inputs_bound(args, jit);
+
+    BoundRealization result;
+    result.contents = new BoundRealizationContents(jit_handlers());
+    BoundRealizationContents *c = result.contents.ptr;
+
+    c->jit_module = jit.module;
+    c->argv_function = c->jit_module.argv_function();
+    c->args = args;
+    c->outputs = dst.as_vector();
+
+    // Hang on to everything the argument vector points into. Scalar
+    // Params are read through their address on every call, but the
+    // Buffers bound to ImageParams are captured now.
+    for (size_t i = 0; i < jit.args.size(); i++) {
+        const InferredArgument &arg = jit.args[i];
+        if (arg.param.same_as(contents.ptr->user_context_arg.param)) {
+            // Rather than going through the Pipeline's user context
+            // Param, pass a pointer to this realization's own
+            // context.
+            c->user_context = &c->jit_context.jit_context;
+            c->args[i] = &c->user_context;
+        } else if (arg.param.defined() && arg.param.is_buffer()) {
+            c->buffers.push_back(arg.param.get_buffer());
+        } else if (arg.param.defined()) {
+            c->params.push_back(arg.param);
+        } else {
+            c->buffers.push_back(arg.buffer);
+        }
+    }
+    internal_assert(c->user_context) << "No user context argument in jitted pipeline\n";
+
+    if (jit.target.has_feature(Target::Profile)) {
+        JITModule::Symbol report_sym =
+            c->jit_module.find_symbol_by_name("halide_profiler_report");
+        JITModule::Symbol reset_sym =
+            c->jit_module.find_symbol_by_name("halide_profiler_reset");
+        if (report_sym.address && reset_sym.address) {
+            c->profiler_report = (void (*)(void *))(report_sym.address);
+            c->profiler_reset = (void (*)())(reset_sym.address);
+        }
+    }
+
+    return result;
+}
+
+BoundRealization Pipeline::bind_realization(Buffer dst, const Target &target) {
+    return bind_realization(Realization({dst}), target);
+}
+
 void Pipeline::infer_input_bounds(Realization dst) {
 
-    Target target = get_jit_target_from_environment();
+    user_assert(defined()) << "Can't infer input bounds on an undefined Pipeline.\n";
+
+    JITSnapshot jit = jit_snapshot(get_jit_target_from_environment());
 
-    vector<const void *> args = prepare_jit_call_arguments(dst, target);
+    vector<const void *> args = prepare_jit_call_arguments(dst, ParamMap(), jit);
 
     struct TrackedBuffer {
         // The query buffer.
@@ -1115,7 +1596,7 @@ void Pipeline::infer_input_bounds(Realization dst) {
         return;
     }
 
-    JITFuncCallContext jit_context(jit_handlers(), contents.ptr->user_context_arg.param);
+    JITFuncCallContext jit_context(jit_handlers(), &contents.ptr->user_context_arg.param);
 
     int iter = 0;
     const int max_iters = 16;
@@ -1126,7 +1607,7 @@ void Pipeline::infer_input_bounds(Realization dst) {
         }
 
         Internal::debug(2) << "Calling jitted function\n";
-        int exit_status = contents.ptr->jit_module.argv_function()(&(args[0]));
+        int exit_status = jit.module.argv_function()(&(args[0]));
         jit_context.report_if_error(exit_status);
         Internal::debug(2) << "Back from jitted function\n";
         bool changed = false;
@@ -1153,7 +1634,7 @@ void Pipeline::infer_input_bounds(Realization dst) {
 
     // Now allocate the resulting buffers
     for (size_t i : query_indices) {
-        InferredArgument ia = contents.ptr->inferred_args[i];
+        InferredArgument ia = jit.args[i];
         internal_assert(!ia.param.get_buffer().defined());
         buffer_t buf = tracked_buffers[i].query;
 
@@ -1215,6 +1696,7 @@ void Pipeline::infer_input_bounds(Buffer dst) {
 
 void Pipeline::invalidate_cache() {
     if (defined()) {
+        std::lock_guard<std::recursive_mutex> lock(contents.ptr->jit_mutex);
         contents.ptr->invalidate_cache();
     }
 }
@@ -10,10 +10,12 @@
 #include <vector>
 
 #include "Buffer.h"
+#include "CostReport.h"
 #include "IntrusivePtr.h"
 #include "Image.h"
 #include "JITModule.h"
 #include "Module.h"
+#include "Param.h"
 #include "Tuple.h"
 #include "Target.h"
 
@@ -22,6 +24,7 @@ namespace Halide {
 struct Argument;
 class Func;
 struct PipelineContents;
+struct JITSnapshot;
 
 namespace Internal {
 class IRMutator;
@@ -91,6 +94,75 @@ struct Outputs {
 };
 
 struct JITExtern;
+struct BoundRealizationContents;
+
+/** A set of values for the Params and ImageParams used by a
+ * Pipeline, to be used for a single realization instead of the
+ * values bound to the Params themselves. Params not in the map use
+ * their currently bound values. Giving each thread its own ParamMap
+ * lets many threads realize the same compiled Pipeline at once. See
+ * the overloads of Pipeline::realize that take one. */
+class ParamMap {
+    struct ParamMapping {
+        Internal::Parameter param;
+        Buffer buffer;
+        uint64_t scalar;
+    };
+    std::vector<ParamMapping> mappings;
+
+    EXPORT ParamMapping &get_mapping(const Internal::Parameter &p);
+    EXPORT void set_scalar(const Internal::Parameter &p, Type t, const void *value);
+
+public:
+    /** Set the value of a scalar Param in this map. */
+    template<typename T>
+    void set(const Param<T> &p, T value) {
+        set_scalar(p.parameter(), type_of<T>(), &value);
+    }
+
+    /** Set the Buffer bound to an ImageParam in this map. */
+    EXPORT void set(const ImageParam &p, Buffer buf);
+
+    /** Get the address of the value this map holds for a Param, or
+     * the raw buffer it holds for an ImageParam. Returns NULL if the
+     * parameter is not in this map. */
+    EXPORT const void *find(const Internal::Parameter &p) const;
+};
+
+/** A realization of a Pipeline into a fixed set of output buffers,
+ * with compilation and argument validation all done up front. Make
+ * one using Pipeline::bind_realization or Func::bind_realization.
+ * Calling realize on it jumps straight into the jit-compiled code,
+ * which makes it much cheaper than Pipeline::realize when computing
+ * small outputs many times. */
+class BoundRealization {
+    Internal::IntrusivePtr<BoundRealizationContents> contents;
+
+    friend class Pipeline;
+public:
+    /** Make an undefined BoundRealization. */
+    EXPORT BoundRealization();
+
+    /** Check if this object refers to a bound realization. */
+    EXPORT bool defined() const;
+
+    /** Run the pipeline into the bound output buffers. The values of
+     * scalar Params are read on each call, so they may change
+     * between calls. The Buffers bound to ImageParams, the output
+     * Buffers, the custom handlers, and the compiled code are all
+     * fixed at the time the realization was bound. If you
+     * reschedule the Funcs, set custom handlers, or bind an
+     * ImageParam to a different Buffer, bind a new realization.
+     *
+     * A BoundRealization may not be run from more than one thread at
+     * once. As with realizing into an Image, if the pipeline runs on
+     * a GPU you are responsible for copying the outputs back to the
+     * host. */
+    EXPORT void realize();
+
+    /** The output Buffers this realization computes into. */
+    EXPORT Realization outputs() const;
+};
 
 /** A class representing a Halide pipeline. Constructed from the Func
  * or Funcs that it outputs. */
@@ -98,7 +170,11 @@ class Pipeline {
     Internal::IntrusivePtr<PipelineContents> contents;
 
     std::vector<Buffer> validate_arguments(const std::vector<Argument> &args);
-    std::vector<const void *> prepare_jit_call_arguments(Realization dst, const Target &target);
+    JITSnapshot jit_snapshot(const Target &target);
+    std::vector<const void *> prepare_jit_call_arguments(Realization dst, const ParamMap &params,
+                                                         const JITSnapshot &jit);
+    Target realization_target(const Target &target);
+    void check_inputs_bound(const std::vector<const void *> &args, const JITSnapshot &jit);
 
     static std::vector<Internal::JITModule> make_externs_jit_module(const Target &target,
                                                                     std::map<std::string, JITExtern> &externs_in_out);
@@ -118,6 +194,26 @@ public:
     /** Get the Funcs this pipeline outputs. */
     EXPORT std::vector<Func> outputs();
 
+    /** Pick a schedule for every Func in this pipeline that hasn't
+     * been scheduled by hand, for the given target. Uses estimates of
+     * the size of each output (see \ref Func::estimate) and a cost
+     * model of arithmetic and memory traffic to decide which Funcs to
+     * inline, compute at root, or compute within the tiles of their
+     * consumer, then tiles, vectorizes and parallelizes each loop
+     * nest. Returns the chosen schedule as C++ source. Call this
+     * before compiling the pipeline. */
+    EXPORT std::string auto_schedule(const Target &target = get_target_from_environment());
+
+    /** Count the work each Func in this pipeline does to compute an
+     * output of the given size with the current schedules, without
+     * running it. The counts come from bounds inference, so they
+     * include any redundant recompute from overlapping compute_at
+     * regions. Scalar parameters take their current values, and
+     * image parameters the size of the buffers bound to them. Useful
+     * for comparing schedules without benchmarking. */
+    EXPORT CostReport analyze(const std::vector<int32_t> &sizes,
+                              const Target &target = get_target_from_environment());
+
     /** Compile and generate multiple target files with single call.
      * Deduces target files based on filenames specified in
      * output_files struct.
@@ -184,6 +280,16 @@ public:
                                         StmtOutputFormat fmt = Text,
                                         const Target &target = get_target_from_environment());
 
+    /** Write out an HTML representation of lowered code, with each
+     * loop, allocation and production annotated with its share of
+     * the time, trip count, bytes allocated and vector width, taken
+     * from the results of the profiler (see Target::Profile) or a
+     * static cost report (see \ref Pipeline::analyze). */
+    EXPORT void compile_to_lowered_stmt(const std::string &filename,
+                                        const std::vector<Argument> &args,
+                                        const StmtProfile &profile,
+                                        const Target &target = get_target_from_environment());
+
     /** Write out the loop nests specified by the schedule for this
      * Pipeline's Funcs. Helpful for understanding what a schedule is
      * doing. */
@@ -212,6 +318,18 @@ public:
      */
      EXPORT void *compile_jit(const Target &target = get_jit_target_from_environment());
 
+    /** If the pipeline was jit-compiled for a Target with the
+     * TieredJIT feature, it first runs code compiled without LLVM
+     * optimizations while the optimized code is compiled on a
+     * background thread. The pipeline switches to the optimized code
+     * at the first realize (or compile_jit) after it is ready, after
+     * which function pointers returned by earlier calls to
+     * compile_jit are no longer valid. This call waits for the
+     * optimized code and switches to it immediately. It does nothing
+     * if no background compilation is in progress. BoundRealizations
+     * keep using the code they were bound to. */
+    EXPORT void wait_for_tiered_jit();
+
     /** Set the error handler function that be called in the case of
      * runtime errors during halide pipelines. If you are compiling
      * statically, you can also just define your own function with
@@ -381,6 +499,40 @@ public:
     }
     // @}
 
+    /** Evaluate this pipeline into an existing allocated buffer or
+     * buffers, using the values in the given ParamMap for any Params
+     * and ImageParams it contains. Unlike the other forms of
+     * realize, these may be called on the same Pipeline from many
+     * threads at once: the arguments and the user context are passed
+     * per call rather than through shared state, and the pipeline is
+     * only compiled once. Each thread should use its own ParamMap and
+     * output buffers, and the Pipeline must not be rescheduled or
+     * have its handlers changed while calls are in flight. Call
+     * these on a Pipeline object shared between the threads, rather
+     * than on a Func. */
+    // @{
+    EXPORT void realize(Realization dst, const ParamMap &params, const Target &target = Target());
+    EXPORT void realize(Buffer dst, const ParamMap &params, const Target &target = Target());
+
+    template<typename T>
+    NO_INLINE void realize(Image<T> dst, const ParamMap &params, const Target &target = Target()) {
+        // Images are expected to exist on-host.
+        realize(Buffer(dst), params, target);
+        dst.copy_to_host();
+    }
+    // @}
+
+    /** Compile the pipeline, validate the given output buffers and
+     * the currently bound inputs against it, and return an object
+     * that can run it repeatedly with no further checks. Useful when
+     * realizing small outputs in a tight loop, where the cost of the
+     * checks done by realize would dominate. See \ref
+     * BoundRealization for which state is captured. */
+    // @{
+    EXPORT BoundRealization bind_realization(Realization dst, const Target &target = Target());
+    EXPORT BoundRealization bind_realization(Buffer dst, const Target &target = Target());
+    // @}
+
     /** For a given size of output, or a given set of output buffers,
      * determine the bounds required of all unbound ImageParams
      * referenced. Communicates the result by allocating new buffers
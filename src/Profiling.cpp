@@ -1,11 +1,14 @@
 #include <algorithm>
 #include <map>
+#include <set>
 #include <string>
 #include <limits>
 
 #include "Profiling.h"
 #include "IRMutator.h"
 #include "IROperator.h"
+#include "Simplify.h"
+#include "Util.h"
 
 namespace Halide {
 namespace Internal {
@@ -74,6 +77,62 @@ private:
     }
 };
 
+class InjectTelemetry : public IRMutator {
+    Expr call;
+
+    using IRMutator::visit;
+
+    void visit(const Allocate *op) {
+        IRMutator::visit(op);
+
+        // Custom allocations aren't made by the pipeline.
+        if (op->new_expr.defined()) return;
+
+        Expr size = make_const(UInt(64), op->type.bytes());
+        for (Expr e : op->extents) {
+            size = size * cast(UInt(64), e);
+        }
+        if (!is_one(op->condition)) {
+            size = select(op->condition, size, make_zero(UInt(64)));
+        }
+        Expr add_bytes = Call::make(Int(32), "halide_telemetry_add_bytes",
+                                    {call, simplify(size)}, Call::Extern);
+        stmt = Block::make(Evaluate::make(add_bytes), stmt);
+    }
+
+    void visit(const For *op) {
+        // Device allocations are made by the device API, not the
+        // pipeline, and we can't call into the runtime from GPU loops.
+        if (op->device_api == DeviceAPI::Parent ||
+            op->device_api == DeviceAPI::Host) {
+            IRMutator::visit(op);
+        } else {
+            stmt = op;
+        }
+    }
+
+public:
+    InjectTelemetry(Expr c) : call(c) {}
+};
+
+// Find the conditions under which the pipeline is being called as a
+// bounds query, i.e. those that guard its early return.
+class FindBoundsQueries : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Variable *op) {
+        if (ends_with(op->name, ".host_and_dev_are_null") &&
+            names.insert(op->name).second) {
+            condition = condition.defined() ? (condition || op) : Expr(op);
+        }
+    }
+
+    std::set<string> names;
+
+public:
+    Expr condition;
+};
+
 Stmt inject_profiling(Stmt s, string pipeline_name) {
     InjectProfiling profiling;
     s = profiling.mutate(s);
@@ -111,5 +170,41 @@ Stmt inject_profiling(Stmt s, string pipeline_name) {
     return s;
 }
 
+Stmt inject_telemetry(Stmt s, string pipeline_name) {
+    // The state of this call lives in a small stack allocation. It's
+    // read by the destructor, which runs on every exit path,
+    // including errors.
+    const string name = "telemetry_call";
+    Expr call = Load::make(UInt(64), name, 0, Buffer(), Parameter());
+    call = Call::make(Handle(), Call::address_of, {call}, Call::Intrinsic);
+
+    FindBoundsQueries queries;
+    s.accept(&queries);
+
+    s = InjectTelemetry(call).mutate(s);
+
+    Stmt start = Evaluate::make(Call::make(Int(32), "halide_telemetry_pipeline_start",
+                                           {pipeline_name, call}, Call::Extern));
+    // Bounds queries return early without doing any work, so they
+    // would be recorded as very fast calls. Don't start timing them;
+    // the destructor ignores calls with no statistics.
+    if (queries.condition.defined()) {
+        start = IfThenElse::make(!queries.condition, start);
+    }
+    Stmt no_stats = Store::make(name, make_zero(UInt(64)), 0);
+    Expr end = Call::make(Int(32), Call::register_destructor,
+                          {Expr("halide_telemetry_pipeline_end"), call}, Call::Intrinsic);
+    // Only reached if nothing failed.
+    Stmt succeeded = Store::make(name, make_one(UInt(64)), 3);
+
+    s = Block::make(s, Block::make(succeeded, Free::make(name)));
+    s = Block::make(Evaluate::make(end), s);
+    s = Block::make(start, s);
+    s = Block::make(no_stats, s);
+    s = Allocate::make(name, UInt(64), {4}, const_true(), s);
+
+    return s;
+}
+
 }
 }
@@ -2,7 +2,8 @@
 #define HALIDE_PROFILING_H
 
 /** \file
- * Defines the lowering pass that injects print statements when profiling is turned on
+ * Defines the lowering passes that inject calls to the profiler and to
+ * the telemetry runtime when they are turned on
  */
 
 #include "IR.h"
@@ -19,6 +20,14 @@ namespace Internal {
  */
 Stmt inject_profiling(Stmt, std::string);
 
+/** Take a fully lowered statement representing a halide pipeline, and
+ * bracket it with calls that record how long it takes, whether it
+ * succeeds, and how many bytes it allocates, in the statistics kept
+ * for the pipeline with the given name. Calls that are bounds queries
+ * aren't recorded. Should be done after storage flattening and early
+ * frees. */
+Stmt inject_telemetry(Stmt, std::string);
+
 }
 }
 
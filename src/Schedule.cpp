@@ -11,18 +11,21 @@ namespace Internal {
 struct ScheduleContents {
     mutable RefCount ref_count;
 
-    LoopLevel store_level, compute_level;
+    LoopLevel store_level, compute_level, compute_with;
     std::vector<Split> splits;
     std::vector<Dim> dims;
     std::vector<std::string> storage_dims;
-    std::vector<Bound> bounds;
+    std::vector<Bound> bounds, estimates;
     std::vector<Specialization> specializations;
     ReductionDomain reduction_domain;
+    Expr slide_strip_size;
     bool memoized;
+    bool memoize_hash_buffers;
+    bool async;
     bool touched;
     bool allow_race_conditions;
 
-    ScheduleContents() : memoized(false), touched(false), allow_race_conditions(false) {};
+    ScheduleContents() : memoized(false), memoize_hash_buffers(false), async(false), touched(false), allow_race_conditions(false) {};
 };
 
 
@@ -46,6 +49,22 @@ bool Schedule::memoized() const {
     return contents.ptr->memoized;
 }
 
+bool &Schedule::memoize_hash_buffers() {
+    return contents.ptr->memoize_hash_buffers;
+}
+
+bool Schedule::memoize_hash_buffers() const {
+    return contents.ptr->memoize_hash_buffers;
+}
+
+bool &Schedule::async() {
+    return contents.ptr->async;
+}
+
+bool Schedule::async() const {
+    return contents.ptr->async;
+}
+
 bool &Schedule::touched() {
     return contents.ptr->touched;
 }
@@ -86,6 +105,14 @@ const std::vector<Bound> &Schedule::bounds() const {
     return contents.ptr->bounds;
 }
 
+std::vector<Bound> &Schedule::estimates() {
+    return contents.ptr->estimates;
+}
+
+const std::vector<Bound> &Schedule::estimates() const {
+    return contents.ptr->estimates;
+}
+
 const std::vector<Specialization> &Schedule::specializations() const {
     return contents.ptr->specializations;
 }
@@ -118,6 +145,14 @@ const LoopLevel &Schedule::compute_level() const {
     return contents.ptr->compute_level;
 }
 
+LoopLevel &Schedule::compute_with() {
+    return contents.ptr->compute_with;
+}
+
+const LoopLevel &Schedule::compute_with() const {
+    return contents.ptr->compute_with;
+}
+
 
 const ReductionDomain &Schedule::reduction_domain() const {
     return contents.ptr->reduction_domain;
@@ -127,6 +162,14 @@ void Schedule::set_reduction_domain(const ReductionDomain &d) {
     contents.ptr->reduction_domain = d;
 }
 
+Expr &Schedule::slide_strip_size() {
+    return contents.ptr->slide_strip_size;
+}
+
+Expr Schedule::slide_strip_size() const {
+    return contents.ptr->slide_strip_size;
+}
+
 bool &Schedule::allow_race_conditions() {
     return contents.ptr->allow_race_conditions;
 }
@@ -149,6 +192,9 @@ void Schedule::accept(IRVisitor *visitor) const {
             b.extent.accept(visitor);
         }
     }
+    if (slide_strip_size().defined()) {
+        slide_strip_size().accept(visitor);
+    }
     for (const Specialization &s : specializations()) {
         s.condition.accept(visitor);
     }
@@ -120,6 +120,21 @@ public:
     bool memoized() const;
     // @}
 
+    /** This flag is set to true if a memoized function should hash
+     * the contents of the input buffers it depends on into its cache
+     * key. See \ref Func::memoize_by_content */
+    // @{
+    bool &memoize_hash_buffers();
+    bool memoize_hash_buffers() const;
+    // @}
+
+    /** This flag is set to true if the function should be computed
+     * asynchronously with respect to its consumer. See \ref Func::async */
+    // @{
+    bool &async();
+    bool async() const;
+    // @}
+
     /** This flag is set to true if the dims list has been manipulated
      * by the user (or if a ScheduleHandle was created that could have
      * been used to manipulate it). It controls the warning that
@@ -171,6 +186,14 @@ public:
     std::vector<Bound> &bounds();
     // @}
 
+    /** Estimates of the range over which a function will be
+     * evaluated. These don't affect the generated code, but are used
+     * by the auto scheduler. See \ref Func::estimate */
+    // @{
+    const std::vector<Bound> &estimates() const;
+    std::vector<Bound> &estimates();
+    // @}
+
     /** You may create several specialized versions of a func with
      * different schedules. They trigger when the condition is
      * true. See \ref Func::specialize */
@@ -192,6 +215,25 @@ public:
     LoopLevel &compute_level();
     // @}
 
+    /** If not inline, this function's loop nest is fused with that of
+     * another function, from the outermost loop down to and
+     * including the loop over the given var. See \ref
+     * Func::compute_with */
+    // @{
+    const LoopLevel &compute_with() const;
+    LoopLevel &compute_with();
+    // @}
+
+    /** If defined, the loop at the compute level of this function is
+     * parallel, and the storage level is outside of it, then that
+     * loop is strip-mined into parallel strips of this size. Each
+     * strip gets its own storage for this function and slides
+     * serially within the strip. See \ref Func::slide_in_strips */
+    // @{
+    Expr slide_strip_size() const;
+    Expr &slide_strip_size();
+    // @}
+
     /** Are race conditions permitted? */
     // @{
     bool allow_race_conditions() const;
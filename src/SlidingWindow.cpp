@@ -337,6 +337,77 @@ public:
     SlidingWindowOnFunction(Function f) : func(f) {}
 };
 
+// Does a statement refer to a function outside of any loop with the given name?
+class UsesFuncOutsideLoop : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const For *op) {
+        if (op->name != loop) {
+            IRVisitor::visit(op);
+        }
+    }
+
+    void visit(const Call *op) {
+        IRVisitor::visit(op);
+        if (op->name == func) result = true;
+    }
+
+    void visit(const Provide *op) {
+        IRVisitor::visit(op);
+        if (op->name == func) result = true;
+    }
+
+public:
+    bool result;
+    string func, loop;
+
+    UsesFuncOutsideLoop(string f, string l) : result(false), func(f), loop(l) {}
+};
+
+// Cut the parallel loop at a function's compute level into parallel
+// strips. Each strip gets its own realization of the function, and
+// the original loop runs serially within it, so that the function
+// can slide over it.
+class StripMineParallelLoop : public IRMutator {
+    const Realize *realize;
+    LoopLevel compute_level;
+    Expr strip_size;
+
+    using IRMutator::visit;
+
+    void visit(const For *op) {
+        if (op->for_type != ForType::Parallel ||
+            !compute_level.match(op->name)) {
+            IRMutator::visit(op);
+            return;
+        }
+
+        debug(3) << "Strip-mining parallel loop " << op->name
+                 << " into strips of size " << strip_size
+                 << " so that " << realize->name << " can slide within each strip\n";
+
+        string strip_name = op->name + ".strip";
+        Expr strip = Variable::make(Int(32), strip_name);
+        Expr strip_min = op->min + strip * strip_size;
+        Expr strip_extent = min(strip_size, op->extent - strip * strip_size);
+        Expr num_strips = (op->extent + strip_size - 1) / strip_size;
+
+        Stmt body = For::make(op->name, strip_min, strip_extent,
+                              ForType::Serial, op->device_api, op->body);
+        body = Realize::make(realize->name, realize->types, realize->bounds,
+                             realize->condition, body);
+        stmt = For::make(strip_name, 0, num_strips,
+                         ForType::Parallel, op->device_api, body);
+        loop_name = op->name;
+    }
+
+public:
+    string loop_name;
+
+    StripMineParallelLoop(const Realize *r, LoopLevel l, Expr s) :
+        realize(r), compute_level(l), strip_size(max(s, 1)) {}
+};
+
 // Perform sliding window optimization for all functions
 class SlidingWindow : public IRMutator {
     const map<string, Function> &env;
@@ -362,6 +433,28 @@ class SlidingWindow : public IRMutator {
             return;
         }
 
+        // If requested, move the realization inside strips of the
+        // parallel loop it's computed at, and slide within those.
+        if (sched.slide_strip_size().defined()) {
+            StripMineParallelLoop strip_miner(op, sched.compute_level(),
+                                              sched.slide_strip_size());
+            Stmt stripped = strip_miner.mutate(op->body);
+
+            // The realization is about to move inside the strips, so
+            // nothing outside of them may refer to it.
+            UsesFuncOutsideLoop uses(op->name, strip_miner.loop_name);
+            op->body.accept(&uses);
+
+            if (!strip_miner.loop_name.empty() && !uses.result) {
+                stmt = mutate(stripped);
+                return;
+            } else {
+                debug(3) << "Not sliding " << op->name << " in parallel strips because "
+                         << "it is not computed at a parallel loop inside its realization, "
+                         << "or it is used outside of that loop\n";
+            }
+        }
+
         Stmt new_body = op->body;
 
         debug(3) << "Doing sliding window analysis on realization of " << op->name << "\n";
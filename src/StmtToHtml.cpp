@@ -4,8 +4,10 @@
 #include "Scope.h"
 
 #include <iterator>
+#include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <set>
 #include <sstream>
 #include <stdio.h>
 
@@ -22,10 +24,83 @@ std::string to_string(T value) {
     return os.str() ;
 }
 
+// Find the Funcs computed within each loop, allocation and
+// production, so that they can be annotated with their share of the
+// time.
+class FindFuncsWithin : public IRVisitor {
+    using IRVisitor::visit;
+
+    std::vector<const IRNode *> enclosing;
+
+    template<typename T>
+    void visit_node(const T *op) {
+        enclosing.push_back(op);
+        IRVisitor::visit(op);
+        enclosing.pop_back();
+    }
+
+    void visit(const For *op) { visit_node(op); }
+    void visit(const Allocate *op) { visit_node(op); }
+    void visit(const Realize *op) { visit_node(op); }
+
+    void visit(const ProducerConsumer *op) {
+        // The consumer isn't part of the time spent on this Func.
+        enclosing.push_back(op);
+        for (const IRNode *n : enclosing) {
+            funcs[n].insert(op->name);
+        }
+        op->produce.accept(this);
+        if (op->update.defined()) {
+            op->update.accept(this);
+        }
+        enclosing.pop_back();
+        op->consume.accept(this);
+    }
+
+public:
+    std::map<const IRNode *, std::set<string>> funcs;
+};
+
+// Find the widest vector used in a statement.
+class MaxLanes : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Ramp *op) {
+        IRVisitor::visit(op);
+        result = std::max(result, op->lanes);
+    }
+
+    void visit(const Broadcast *op) {
+        IRVisitor::visit(op);
+        result = std::max(result, op->lanes);
+    }
+
+    void visit(const For *op) {
+        IRVisitor::visit(op);
+        const int64_t *extent = as_const_int(op->extent);
+        if (op->for_type == ForType::Vectorized && extent) {
+            result = std::max(result, (int)*extent);
+        }
+    }
+
+public:
+    int result;
+    MaxLanes() : result(1) {}
+};
+
 class StmtToHtml : public IRVisitor {
 
     static const std::string css, js;
 
+    // Performance data to annotate the code with, or NULL.
+    const StmtProfile *profile;
+
+    // The share of the time (or the work, if there are no times)
+    // spent computing each Func, and the Funcs computed within each
+    // node.
+    std::map<string, double> func_share;
+    FindFuncsWithin funcs_within;
+
     // This allows easier access to individual elements.
     int id_count;
 
@@ -137,6 +212,124 @@ private:
         return "</a>";
     }
 
+    const FuncCost *func_cost(const string &name) {
+        for (const FuncCost &f : profile->costs.funcs) {
+            if (f.name == name) return &f;
+        }
+        // Tuple-valued Funcs are allocated as one buffer per element.
+        size_t dot = name.rfind('.');
+        if (dot != string::npos) {
+            string base = name.substr(0, dot);
+            for (const FuncCost &f : profile->costs.funcs) {
+                if (f.name == base) return &f;
+            }
+        }
+        return NULL;
+    }
+
+    double heat(const IRNode *op) {
+        double h = 0;
+        std::map<const IRNode *, std::set<string>>::const_iterator iter = funcs_within.funcs.find(op);
+        if (iter == funcs_within.funcs.end()) return h;
+        for (const string &f : iter->second) {
+            std::map<string, double>::const_iterator share = func_share.find(f);
+            if (share != func_share.end()) {
+                h += share->second;
+            }
+        }
+        return std::min(h, 1.0);
+    }
+
+    // Print a list of notes about a node, shaded by the share of the
+    // time spent within it.
+    string annotation(const IRNode *op, std::vector<string> notes) {
+        if (!profile) return "";
+        double h = heat(op);
+        if (h > 0) {
+            std::ostringstream s;
+            s << std::fixed << std::setprecision(1) << h * 100 << "% of "
+              << (profile->func_time.empty() ? "work" : "time");
+            notes.insert(notes.begin(), s.str());
+        }
+        if (notes.empty()) return "";
+        std::ostringstream s;
+        s << " <span class='Annotation' style='background-color: rgba(255, 64, 0, "
+          << std::setprecision(2) << h * 0.8 << ");'>// ";
+        for (size_t i = 0; i < notes.size(); i++) {
+            if (i > 0) s << ", ";
+            s << notes[i];
+        }
+        s << "</span>";
+        return s.str();
+    }
+
+    string loop_annotation(const For *op) {
+        if (!profile) return "";
+        std::vector<string> notes;
+        std::map<string, int64_t>::const_iterator iter = profile->costs.loop_iterations.find(op->name);
+        if (iter != profile->costs.loop_iterations.end()) {
+            notes.push_back(to_string(iter->second) + " iterations");
+        } else if (const int64_t *extent = as_const_int(op->extent)) {
+            notes.push_back(to_string(*extent) + " iterations per entry");
+        }
+        MaxLanes lanes;
+        op->body.accept(&lanes);
+        if (lanes.result > 1) {
+            notes.push_back("vector width " + to_string(lanes.result));
+        }
+        return annotation(op, notes);
+    }
+
+    string allocation_annotation(const IRNode *op, const string &name, Type t,
+                                 const std::vector<Expr> &extents) {
+        if (!profile) return "";
+        std::vector<string> notes;
+        int64_t bytes = t.bytes();
+        for (Expr e : extents) {
+            const int64_t *extent = as_const_int(e);
+            if (!extent) {
+                bytes = -1;
+                break;
+            }
+            bytes *= *extent;
+        }
+        const FuncCost *cost = func_cost(name);
+        if (bytes < 0 && cost && !cost->allocations.empty()) {
+            bytes = 0;
+            for (const FuncCost::Allocation &a : cost->allocations) {
+                bytes = std::max(bytes, a.bytes);
+            }
+        }
+        if (bytes >= 0) {
+            notes.push_back(to_string(bytes) + " bytes");
+        }
+        if (cost) {
+            int64_t count = 0;
+            for (const FuncCost::Allocation &a : cost->allocations) {
+                count += a.count;
+            }
+            if (count > 1) {
+                notes.push_back("allocated " + to_string(count) + " times");
+            }
+        }
+        return annotation(op, notes);
+    }
+
+    string produce_annotation(const ProducerConsumer *op) {
+        if (!profile) return "";
+        std::vector<string> notes;
+        if (const FuncCost *cost = func_cost(op->name)) {
+            notes.push_back(to_string(cost->total_ops()) + " ops");
+            notes.push_back(to_string(cost->stores) + " stores");
+            if (cost->points_required) {
+                std::ostringstream s;
+                s << "recompute factor " << std::setprecision(3) << cost->recompute_factor();
+                notes.push_back(s.str());
+            }
+        }
+        return annotation(op, notes);
+    }
+
     void visit(const IntImm *op){
         stream << open_span("IntImm Imm");
         stream << Expr(op);
@@ -357,6 +550,7 @@ private:
         stream << var(op->name);
         stream << close_expand_button() << " {";
         stream << close_span();;
+        stream << produce_annotation(op);
         stream << open_div("ProduceBody Indent", produce_id);
         print(op->produce);
         stream << close_div();
@@ -405,6 +599,7 @@ private:
         stream << matched(")");
         stream << close_expand_button();
         stream << " " << matched("{");
+        stream << loop_annotation(op);
         stream << open_div("ForBody Indent", id);
         print(op->body);
         stream << close_div();
@@ -473,6 +668,7 @@ private:
             stream << keyword("custom_delete") << "{ " << op->free_function << "(); ";
             stream << matched("}");
         }
+        stream << allocation_annotation(op, op->name, op->type, op->extents);
 
         stream << open_div("AllocateBody");
         print(op->body);
@@ -507,6 +703,15 @@ private:
         stream << close_expand_button();
 
         stream << " " << matched("{");
+        if (profile) {
+            std::vector<Expr> extents;
+            for (const Range &r : op->bounds) {
+                extents.push_back(r.extent);
+            }
+            for (Type t : op->types) {
+                stream << allocation_annotation(op, op->name, t, extents);
+            }
+        }
         stream << open_div("RealizeBody Indent", id);
         print(op->body);
         stream << close_div();
@@ -625,7 +830,37 @@ public:
         stream << close_div();
     }
 
-    StmtToHtml(string filename) : id_count(0), context_stack(1, 0) {
+    // Find the Funcs computed within each node of a statement, before
+    // printing it with a profile.
+    void prepare(Stmt s) {
+        if (profile) {
+            s.accept(&funcs_within);
+        }
+    }
+
+    StmtToHtml(string filename, const StmtProfile *p = NULL) :
+        profile(p), id_count(0), context_stack(1, 0) {
+        if (profile) {
+            // Normalize the times (or work) to shares of the total.
+            double total = 0;
+            if (!profile->func_time.empty()) {
+                func_share = profile->func_time;
+            } else {
+                for (const FuncCost &f : profile->costs.funcs) {
+                    int64_t work = f.total_ops() + f.stores;
+                    for (const auto &l : f.loads) {
+                        work += l.second;
+                    }
+                    func_share[f.name] = work;
+                }
+            }
+            for (const auto &i : func_share) {
+                total += i.second;
+            }
+            for (auto &i : func_share) {
+                i.second = total > 0 ? i.second / total : 0;
+            }
+        }
         stream.open(filename.c_str());
         stream << "<head>";
         stream << "<style type='text/css'>" << css << "</style>\n";
@@ -664,6 +899,7 @@ span.Type { color: #445588; font-weight: bold; }\n \
 span.StringImm { color: #d14; }\n \
 span.IntImm { color: #099; }\n \
 span.FloatImm { color: #099; }\n \
+span.Annotation { color: #666; font-style: italic; padding: 0px 4px; }\n \
 b.Highlight { font-weight: bold; background-color: #DDD; }\n \
 span.Highlight { font-weight: bold; background-color: #FF0; }\n \
 ";
@@ -701,5 +937,24 @@ void print_to_html(string filename, const Module &m) {
     }
 }
 
+void print_to_html(string filename, Stmt s, const StmtProfile &profile) {
+    StmtToHtml sth(filename, &profile);
+    sth.prepare(s);
+    sth.print(s);
+}
+
+void print_to_html(string filename, const Module &m, const StmtProfile &profile) {
+    StmtToHtml sth(filename, &profile);
+    for (size_t i = 0; i < m.functions.size(); i++) {
+        sth.prepare(m.functions[i].body);
+    }
+    for (size_t i = 0; i < m.buffers.size(); i++) {
+        sth.print(m.buffers[i]);
+    }
+    for (size_t i = 0; i < m.functions.size(); i++) {
+        sth.print(m.functions[i]);
+    }
+}
+
 }
 }
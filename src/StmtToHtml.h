@@ -5,6 +5,7 @@
  * Defines a function to dump an HTML-formatted stmt to a file.
  */
 
+#include "CostReport.h"
 #include "Module.h"
 
 namespace Halide {
@@ -18,6 +19,15 @@ EXPORT void print_to_html(std::string filename, Stmt s);
 /** Dump an HTML-formatted print of a Module to filename. */
 EXPORT void print_to_html(std::string filename, const Module &m);
 
+/** Dump an HTML-formatted print of a Stmt or Module to filename, with
+ * loops, allocations and productions annotated using the given
+ * performance data, and shaded by the share of the time spent in
+ * them. */
+// @{
+EXPORT void print_to_html(std::string filename, Stmt s, const StmtProfile &profile);
+EXPORT void print_to_html(std::string filename, const Module &m, const StmtProfile &profile);
+// @}
+
 }}
 
 #endif
@@ -51,9 +51,112 @@ public:
         func(f), dim(d), factor(e) {}
 };
 
+bool is_async_loop_var(const string &name) {
+    return ends_with(name, ".__async");
+}
+
+namespace {
+
+// The number of 64-bit words in a halide_semaphore_t in the runtime.
+const int semaphore_words = 16;
+
+// How many iterations of the folded loop an async producer may be
+// working on ahead of the iteration its consumer is working on.
+const int async_run_ahead = 1;
+
+// Split the body of the loop that an async function has been folded
+// over into the parts run by the producer and by the consumer. We
+// only handle the case where the body is some lets wrapping the
+// function's ProducerConsumer node.
+bool split_async_loop_body(Stmt s, const string &func, Stmt *producer, Stmt *consumer) {
+    if (const LetStmt *let = s.as<LetStmt>()) {
+        Stmt p, c;
+        if (!split_async_loop_body(let->body, func, &p, &c)) {
+            return false;
+        }
+        *producer = LetStmt::make(let->name, let->value, p);
+        *consumer = LetStmt::make(let->name, let->value, c);
+        return true;
+    } else if (const ProducerConsumer *pipe = s.as<ProducerConsumer>()) {
+        if (pipe->name != func) {
+            return false;
+        }
+        Stmt no_op = Evaluate::make(0);
+        *producer = ProducerConsumer::make(func, pipe->produce, pipe->update, no_op);
+        *consumer = ProducerConsumer::make(func, no_op, Stmt(), pipe->consume);
+        return true;
+    } else {
+        return false;
+    }
+}
+
+Expr semaphore_address(const string &func, int idx) {
+    Expr sem = Load::make(UInt(64), func + ".folding_semaphores",
+                          idx * semaphore_words, Buffer(), Parameter());
+    return Call::make(Handle(), Call::address_of, {sem}, Call::Intrinsic);
+}
+
+Stmt acquire_semaphore(const string &func, int idx) {
+    // If the other side of the pipeline failed, the acquire fails too,
+    // and we bail out with its error code.
+    string result_name = func + ".semaphore_result";
+    Expr result = Variable::make(Int(32), result_name);
+    Expr acquire = Call::make(Int(32), "halide_semaphore_acquire",
+                              {semaphore_address(func, idx), 1}, Call::Extern);
+    return LetStmt::make(result_name, acquire, AssertStmt::make(result == 0, result));
+}
+
+Stmt release_semaphore(const string &func, int idx) {
+    Expr release = Call::make(Int(32), "halide_semaphore_release",
+                              {semaphore_address(func, idx), 1}, Call::Extern);
+    return Evaluate::make(release);
+}
+
+// Run the producer of a folded function on its own thread. The first
+// semaphore counts the free slots in the circular buffer, and the
+// second counts the iterations the producer has completed.
+Stmt make_async_loop(const For *loop, const string &func, Stmt producer, Stmt consumer) {
+    const int free_slots = 0, produced = 1;
+
+    producer = Block::make(acquire_semaphore(func, free_slots),
+                           Block::make(producer, release_semaphore(func, produced)));
+    producer = For::make(loop->name, loop->min, loop->extent,
+                         loop->for_type, loop->device_api, producer);
+
+    consumer = Block::make(acquire_semaphore(func, produced),
+                           Block::make(consumer, release_semaphore(func, free_slots)));
+    consumer = For::make(loop->name, loop->min, loop->extent,
+                         loop->for_type, loop->device_api, consumer);
+
+    // Whichever side exits first, successfully or not, wakes up the
+    // other side if it's waiting for something that will never come.
+    Stmt body = IfThenElse::make(Variable::make(Int(32), func + ".__async") == 0, producer, consumer);
+    for (int i = 0; i < 2; i++) {
+        Expr cancel = Call::make(Int(32), Call::register_destructor,
+                                 {Expr("halide_semaphore_cancel"), semaphore_address(func, i)},
+                                 Call::Intrinsic);
+        body = Block::make(Evaluate::make(cancel), body);
+    }
+    Stmt s = For::make(func + ".__async", 0, 2, ForType::Parallel, loop->device_api, body);
+
+    Expr init_free = Call::make(Int(32), "halide_semaphore_init",
+                                {semaphore_address(func, free_slots), async_run_ahead + 1},
+                                Call::Extern);
+    Expr init_produced = Call::make(Int(32), "halide_semaphore_init",
+                                    {semaphore_address(func, produced), 0},
+                                    Call::Extern);
+    s = Block::make(Evaluate::make(init_free), Block::make(Evaluate::make(init_produced), s));
+
+    return Allocate::make(func + ".folding_semaphores", UInt(64), {2 * semaphore_words},
+                          const_true(), s);
+}
+
+}
+
 // Attempt to fold the storage of a particular function in a statement
 class AttemptStorageFoldingOfFunction : public IRMutator {
     string func;
+    bool async;
 
     using IRMutator::visit;
 
@@ -110,6 +213,30 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
                 if (max_extent_int) {
                     int extent = max_extent_int->value;
 
+                    // If the function is async, the producer may be
+                    // ahead of the consumer by a few iterations, so
+                    // the circular buffer needs to cover that many
+                    // more steps along the loop.
+                    Stmt producer, consumer;
+                    bool make_async = false;
+                    if (async) {
+                        Expr step = (is_monotonic(min, op->name) == MonotonicIncreasing) ?
+                            finite_difference(min, op->name) :
+                            (0 - finite_difference(max, op->name));
+                        step = simplify(step);
+                        const IntImm *step_int = step.as<IntImm>();
+                        if (step_int &&
+                            split_async_loop_body(op->body, func, &producer, &consumer)) {
+                            make_async = true;
+                            extent += async_run_ahead * step_int->value;
+                        } else {
+                            user_warning << "Computing " << func << " synchronously, because "
+                                         << "it must be computed directly inside the loop over "
+                                         << op->name << ", and must move along it by a constant "
+                                         << "step each iteration, to be computed asynchronously.\n";
+                        }
+                    }
+
                     int factor = 1;
                     while (factor <= extent) factor *= 2;
 
@@ -119,6 +246,16 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
                     dims_folded.push_back(fold);
                     result = FoldStorageOfFunction(func, (int)i - 1, factor).mutate(result);
 
+                    if (make_async) {
+                        debug(3) << "Computing " << func << " asynchronously over loop "
+                                 << op->name << "\n";
+                        FoldStorageOfFunction fold_body(func, (int)i - 1, factor);
+                        stmt = make_async_loop(op, func,
+                                               fold_body.mutate(producer),
+                                               fold_body.mutate(consumer));
+                        return;
+                    }
+
                     Expr step = finite_difference(min, op->name);
 
                     if (is_one(simplify(extent < step))) {
@@ -164,7 +301,7 @@ public:
     };
     vector<Fold> dims_folded;
 
-    AttemptStorageFoldingOfFunction(string f) : func(f) {}
+    AttemptStorageFoldingOfFunction(string f, bool a) : func(f), async(a) {}
 };
 
 /** Check if a buffer's allocated is referred to directly via an
@@ -190,12 +327,17 @@ private:
 
 // Look for opportunities for storage folding in a statement
 class StorageFolding : public IRMutator {
+    const map<string, Function> &env;
+
     using IRMutator::visit;
 
     void visit(const Realize *op) {
         Stmt body = mutate(op->body);
 
-        AttemptStorageFoldingOfFunction folder(op->name);
+        map<string, Function>::const_iterator iter = env.find(op->name);
+        bool async = (iter != env.end() && iter->second.schedule().async());
+
+        AttemptStorageFoldingOfFunction folder(op->name, async);
         IsBufferSpecial special(op->name);
         op->accept(&special);
 
@@ -230,6 +372,9 @@ class StorageFolding : public IRMutator {
             }
         }
     }
+
+public:
+    StorageFolding(const map<string, Function> &e) : env(e) {}
 };
 
 // Because storage folding runs before simplification, it's useful to
@@ -266,9 +411,9 @@ class SubstituteInConstants : public IRMutator {
     }
 };
 
-Stmt storage_folding(Stmt s) {
+Stmt storage_folding(Stmt s, const map<string, Function> &env) {
     s = SubstituteInConstants().mutate(s);
-    s = StorageFolding().mutate(s);
+    s = StorageFolding(env).mutate(s);
     return s;
 }
 
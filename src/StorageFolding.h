@@ -6,6 +6,8 @@
  * down to smaller circular buffers when possible
  */
 
+#include <map>
+
 #include "IR.h"
 
 namespace Halide {
@@ -23,8 +25,17 @@ namespace Internal {
  *
  * We can store f as a circular buffer of size two, instead of
  * allocating space for all of it.
+ *
+ * Functions scheduled as async that get folded are additionally split
+ * off onto their own thread, with a larger circular buffer so that
+ * they can run ahead of their consumer. See \ref Func::async
  */
-Stmt storage_folding(Stmt s);
+Stmt storage_folding(Stmt s, const std::map<std::string, Function> &env);
+
+/** Check if a loop variable is the one introduced by storage folding
+ * to run an async producer concurrently with its consumer. Such loops
+ * are parallel, but each iteration must get its own thread. */
+bool is_async_loop_var(const std::string &name);
 
 }
 }
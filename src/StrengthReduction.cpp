@@ -0,0 +1,344 @@
+#include <iostream>
+#include <stdlib.h>
+
+#include "StrengthReduction.h"
+#include "CodeGen_GPU_Dev.h"
+#include "Debug.h"
+#include "ExprUsesVar.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRPrinter.h"
+#include "Scope.h"
+#include "Simplify.h"
+#include "Substitute.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// Is an expression plain arithmetic, with no loads or calls?
+class IsArithmetic : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Load *) {
+        result = false;
+    }
+
+    void visit(const Call *) {
+        result = false;
+    }
+
+public:
+    bool result;
+    IsArithmetic() : result(true) {}
+};
+
+bool is_arithmetic(Expr e) {
+    IsArithmetic check;
+    e.accept(&check);
+    return check.result;
+}
+
+// Rewrite the affine indices in the body of a single loop in terms of
+// induction variables.
+class ReduceIndices : public IRMutator {
+    using IRMutator::visit;
+
+    const string &loop_var;
+    Expr loop_min;
+
+    // Everything bound inside the loop body.
+    Scope<int> defined_in_loop;
+
+    // Rewrite a scalar index in terms of an induction variable, or
+    // return an undefined Expr if it's not worth it.
+    Expr reduce_scalar(Expr index) {
+        if (index.type() != Int(32) ||
+            !expr_uses_var(index, loop_var) ||
+            expr_uses_vars(index, defined_in_loop) ||
+            !is_arithmetic(index)) {
+            return Expr();
+        }
+
+        Expr next = substitute(loop_var, Variable::make(Int(32), loop_var) + 1, index);
+        Expr stride = simplify(next - index);
+        if (expr_uses_var(stride, loop_var)) {
+            // Not affine, or too complex for the simplifier to
+            // prove it is.
+            return Expr();
+        }
+        if (is_one(stride)) {
+            // The loop variable itself is already the induction
+            // variable.
+            return Expr();
+        }
+        Expr init = simplify(substitute(loop_var, loop_min, index));
+
+        for (const InductionVariable &iv : ivs) {
+            if (equal(iv.stride, stride)) {
+                Expr offset = simplify(init - iv.init);
+                if (is_const(offset)) {
+                    return simplify(Variable::make(Int(32), iv.name) + offset);
+                }
+            }
+        }
+
+        InductionVariable iv = {unique_name('t'), init, stride};
+        ivs.push_back(iv);
+        debug(3) << "Strength-reducing " << index << " in loop over " << loop_var
+                 << " with induction variable " << iv.name << "\n";
+        return Variable::make(Int(32), iv.name);
+    }
+
+    Expr reduce(Expr index) {
+        // Vector indices are left alone. Codegen uses the modulus and
+        // remainder of a ramp's base to prove that vector loads and
+        // stores are aligned, and an induction variable hides them.
+        if (index.type().is_vector()) {
+            return Expr();
+        }
+        return reduce_scalar(index);
+    }
+
+    void visit(const Load *op) {
+        Expr index = reduce(op->index);
+        if (!index.defined()) {
+            index = mutate(op->index);
+        }
+        if (index.same_as(op->index)) {
+            expr = op;
+        } else {
+            expr = Load::make(op->type, op->name, index, op->image, op->param);
+        }
+    }
+
+    void visit(const Store *op) {
+        Expr value = mutate(op->value);
+        Expr index = reduce(op->index);
+        if (!index.defined()) {
+            index = mutate(op->index);
+        }
+        if (value.same_as(op->value) && index.same_as(op->index)) {
+            stmt = op;
+        } else {
+            stmt = Store::make(op->name, value, index);
+        }
+    }
+
+    void visit(const Let *op) {
+        Expr value = mutate(op->value);
+        defined_in_loop.push(op->name, 0);
+        Expr body = mutate(op->body);
+        defined_in_loop.pop(op->name);
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            expr = op;
+        } else {
+            expr = Let::make(op->name, value, body);
+        }
+    }
+
+    void visit(const LetStmt *op) {
+        Expr value = mutate(op->value);
+        defined_in_loop.push(op->name, 0);
+        Stmt body = mutate(op->body);
+        defined_in_loop.pop(op->name);
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            stmt = op;
+        } else {
+            stmt = LetStmt::make(op->name, value, body);
+        }
+    }
+
+public:
+    struct InductionVariable {
+        string name;
+        Expr init, stride;
+    };
+    vector<InductionVariable> ivs;
+
+    ReduceIndices(const string &v, Expr m) : loop_var(v), loop_min(m) {}
+};
+
+class ContainsLoop : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const For *) {
+        result = true;
+    }
+
+public:
+    bool result;
+    ContainsLoop() : result(false) {}
+};
+
+class StrengthReduceLoopIndices : public IRMutator {
+    using IRMutator::visit;
+
+    void visit(const For *op) {
+        // Leave device code to the GPU backends.
+        if (CodeGen_GPU_Dev::is_gpu_var(op->name) ||
+            (op->device_api != DeviceAPI::Parent &&
+             op->device_api != DeviceAPI::Host)) {
+            stmt = op;
+            return;
+        }
+
+        ContainsLoop inner;
+        op->body.accept(&inner);
+        if (inner.result) {
+            IRMutator::visit(op);
+            return;
+        }
+
+        // Only serial loops carry state from one iteration to the
+        // next.
+        if (op->for_type != ForType::Serial) {
+            stmt = op;
+            return;
+        }
+
+        ReduceIndices reducer(op->name, op->min);
+        Stmt body = reducer.mutate(op->body);
+        if (reducer.ivs.empty()) {
+            stmt = op;
+            return;
+        }
+
+        // Each iteration reads the induction variables, runs the
+        // original body, and then bumps them by their strides.
+        Expr zero = make_zero(Int(32));
+        for (const ReduceIndices::InductionVariable &iv : reducer.ivs) {
+            Expr v = Variable::make(Int(32), iv.name);
+            body = Block::make(body, Store::make(iv.name + ".iv", v + iv.stride, zero));
+        }
+        for (const ReduceIndices::InductionVariable &iv : reducer.ivs) {
+            Expr value = Load::make(Int(32), iv.name + ".iv", zero, Buffer(), Parameter());
+            body = LetStmt::make(iv.name, value, body);
+        }
+        stmt = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+
+        for (const ReduceIndices::InductionVariable &iv : reducer.ivs) {
+            stmt = Block::make(Store::make(iv.name + ".iv", iv.init, zero), stmt);
+        }
+        for (const ReduceIndices::InductionVariable &iv : reducer.ivs) {
+            stmt = Allocate::make(iv.name + ".iv", Int(32), {1}, const_true(), stmt);
+        }
+    }
+};
+
+}  // namespace
+
+Stmt strength_reduce_loop_indices(Stmt s) {
+    // Setting HL_DISABLE_STRENGTH_REDUCTION to 1 turns this pass off,
+    // for measuring what it buys.
+    char *disable = getenv("HL_DISABLE_STRENGTH_REDUCTION");
+    if (disable && atoi(disable)) {
+        return s;
+    }
+    return StrengthReduceLoopIndices().mutate(s);
+}
+
+namespace {
+
+// Count the number of times a buffer is stored to.
+class CountStores : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Store *op) {
+        if (op->name == name) {
+            count++;
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    const string &name;
+    int count;
+    CountStores(const string &n) : name(n), count(0) {}
+};
+
+class FindAllocations : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Allocate *op) {
+        names.push_back(op->name);
+        IRVisitor::visit(op);
+    }
+
+public:
+    vector<string> names;
+};
+
+void check(Stmt s, int expected_ivs) {
+    Stmt result = strength_reduce_loop_indices(s);
+    FindAllocations allocs;
+    result.accept(&allocs);
+    if ((int)allocs.names.size() != expected_ivs) {
+        internal_error
+            << "Expected " << expected_ivs << " induction variables in:\n" << result
+            << "From:\n" << s << "\n";
+    }
+    for (const string &n : allocs.names) {
+        // Once before the loop, and once per iteration.
+        CountStores stores(n);
+        result.accept(&stores);
+        internal_assert(stores.count == 2)
+            << "Expected two stores to " << n << " in:\n" << result << "\n";
+    }
+}
+
+}  // namespace
+
+void strength_reduction_test() {
+    Expr x = Variable::make(Int(32), "x");
+    Expr y = Variable::make(Int(32), "y");
+    Expr stride = Variable::make(Int(32), "stride");
+
+    // A walk down a column gets an induction variable.
+    Stmt s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                       Store::make("buf", x, y + x * stride));
+    check(s, 1);
+
+    // Unit stride doesn't need one.
+    s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                  Store::make("buf", x, x + y * stride));
+    check(s, 0);
+
+    // Neither do parallel loops.
+    s = For::make("x", 0, 10, ForType::Parallel, DeviceAPI::Host,
+                  Store::make("buf", x, y + x * stride));
+    check(s, 0);
+
+    // Indices that differ by a constant share one.
+    Expr load = Load::make(Int(32), "in", x * stride + y + 1, Buffer(), Parameter());
+    s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                  Store::make("buf", load, x * stride + y + 3));
+    check(s, 1);
+
+    // Non-affine indices are left alone.
+    s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                  Store::make("buf", x, (x / 2) * stride));
+    check(s, 0);
+
+    // Vector indices are left alone, so that codegen can still see
+    // the alignment of the base of a ramp.
+    s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                  Store::make("buf", Broadcast::make(x, 4), Ramp::make(x * 4 * stride, 1, 4)));
+    check(s, 0);
+
+    // Scalar indices in the same loop still get one.
+    s = For::make("x", 0, 10, ForType::Serial, DeviceAPI::Host,
+                  Block::make(Store::make("buf", Broadcast::make(x, 4), Ramp::make(x * 4 * stride, 1, 4)),
+                              Store::make("buf2", x, y + x * stride)));
+    check(s, 1);
+
+    std::cout << "Strength reduction test passed" << std::endl;
+}
+
+}
+}
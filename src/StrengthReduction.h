@@ -0,0 +1,33 @@
+#ifndef HALIDE_STRENGTH_REDUCTION_H
+#define HALIDE_STRENGTH_REDUCTION_H
+
+/** \file
+ * Defines the lowering pass that strength-reduces the flattened
+ * indices of loads and stores in serial inner loops.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** In each innermost serial loop, find the scalar load and store
+ * indices that are affine in the loop variable with a stride other
+ * than one (e.g. walking down a column), and compute them with an
+ * induction variable that is bumped by the stride every iteration,
+ * instead of with a multiply. The induction variables live in
+ * single-element stack allocations, which LLVM promotes to
+ * registers. Indices that differ by a constant share an induction
+ * variable. Vector indices are left alone, as codegen needs to see
+ * the alignment of their base. Done after vectorization and loop
+ * partitioning, so that it applies to the final loops. Setting the
+ * environment variable HL_DISABLE_STRENGTH_REDUCTION to 1 turns the
+ * pass off. */
+Stmt strength_reduce_loop_indices(Stmt s);
+
+EXPORT void strength_reduction_test();
+
+}
+}
+
+#endif
@@ -231,6 +231,12 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"no_runtime", Target::NoRuntime},
     {"metal", Target::Metal},
     {"mingw", Target::MinGW},
+    {"opt_level_0", Target::OptLevel0},
+    {"opt_level_1", Target::OptLevel1},
+    {"opt_level_2", Target::OptLevel2},
+    {"tiered_jit", Target::TieredJIT},
+    {"memoize_stable_keys", Target::MemoizeStableKeys},
+    {"telemetry", Target::Telemetry},
 };
 
 bool lookup_feature(const std::string &tok, Target::Feature &result) {
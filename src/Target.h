@@ -79,6 +79,12 @@ struct Target {
 
         Metal, ///< Enable the (Apple) Metal runtime.
         MinGW, ///< For Windows compile to MinGW toolset rather then Visual Studio
+        OptLevel0, ///< Run no LLVM optimizations, for the fastest compiles. Useful when JIT-compiling on demand.
+        OptLevel1, ///< Run LLVM's O1 optimizations. Usually most of the speed of O3, for much less compile time.
+        OptLevel2, ///< Run LLVM's O2 optimizations. The default (with none of these features) is O3.
+        TieredJIT, ///< When JIT-compiling, first compile with no LLVM optimizations so the pipeline can run right away, then recompile with full optimization on a background thread and switch to that once it is ready.
+        MemoizeStableKeys, ///< Identify memoized Funcs in cache keys by a hash of their definitions, rather than by addresses and counters that vary from process to process. Required to share results through halide_shared_memoization_cache.
+        Telemetry, ///< Record the latency of every call to the pipeline in a histogram, along with counts of calls, errors, and bytes allocated. See halide_telemetry_get_pipelines. Much cheaper than Profile.
         FeatureEnd ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
     };
 
@@ -126,6 +132,15 @@ struct Target {
         return true;
     }
 
+    /** The LLVM optimization level to compile at: the lowest of the
+     * OptLevel features set, or 3 if none are. */
+    int opt_level() const {
+        if (has_feature(OptLevel0)) return 0;
+        if (has_feature(OptLevel1)) return 1;
+        if (has_feature(OptLevel2)) return 2;
+        return 3;
+    }
+
     /** Return a copy of the target with the given feature set.
      * This is convenient when enabling certain features (e.g. NoBoundsQuery)
      * in an initialization list, where the target to be mutated may be
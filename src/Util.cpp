@@ -4,6 +4,7 @@
 #include "Error.h"
 #include <sstream>
 #include <map>
+#include <mutex>
 
 namespace Halide {
 namespace Internal {
@@ -13,9 +14,16 @@ using std::vector;
 using std::ostringstream;
 using std::map;
 
+namespace {
+// Names may be generated from several threads at once, e.g. when
+// compiling independent pipelines in parallel.
+std::mutex unique_name_mutex;
+}
+
 string unique_name(char prefix) {
     // arrays with static storage duration should be initialized to zero automatically
     static int instances[256];
+    std::lock_guard<std::mutex> lock(unique_name_mutex);
     ostringstream str;
     str << prefix << instances[(unsigned char)prefix]++;
     return str.str();
@@ -67,6 +75,7 @@ string unique_name(const string &name, bool user) {
         }
     }
 
+    std::lock_guard<std::mutex> lock(unique_name_mutex);
     int &count = known_names[name];
     count++;
     if (count == 1) {
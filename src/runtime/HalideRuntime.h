@@ -113,6 +113,39 @@ extern int (*halide_set_custom_do_task(int (*f)(void *, halide_task_t, int, uint
 /** Spawn a thread, independent of halide's thread pool. */
 extern void halide_spawn_thread(void *user_context, void (*f)(void *), void *closure);
 
+/** Run each task on its own thread, concurrently with all the other
+ * tasks, and wait for them all to finish. The last task runs on the
+ * calling thread. Unlike halide_do_par_for, the tasks may wait on each
+ * other (e.g. using the semaphores below), so this doesn't use the
+ * thread pool. Used to run async producers concurrently with their
+ * consumers (see Func::async). Returns zero if all the tasks return
+ * zero, or the return value of one of the failing tasks otherwise. If
+ * a thread can't be created, none of the tasks run, and it returns
+ * halide_error_code_generic_error.
+ */
+extern int halide_do_async(void *user_context, halide_task_t task,
+                           int min, int size, uint8_t *closure);
+
+/** A counting semaphore, used to hand work back and forth between
+ * async producers and their consumers. Must be initialized with
+ * halide_semaphore_init before use. */
+struct halide_semaphore_t {
+    uint64_t _private[16];
+};
+
+/** Functions to manipulate semaphores. halide_semaphore_acquire blocks
+ * until the count is at least n, and then decrements it by n. Once a
+ * semaphore has been cancelled, acquires that can't be satisfied right
+ * away fail instead of blocking, and return a non-zero error
+ * code. halide_semaphore_cancel has the signature of a destructor, so
+ * that it can be called when a task exits for any reason. */
+//@{
+extern int halide_semaphore_init(struct halide_semaphore_t *sem, int count);
+extern int halide_semaphore_release(struct halide_semaphore_t *sem, int n);
+extern int halide_semaphore_acquire(struct halide_semaphore_t *sem, int n);
+extern void halide_semaphore_cancel(void *user_context, void *sem);
+//@}
+
 /** Set the number of threads used by Halide's thread pool. No effect
  * on OS X or iOS. If changed after the first use of a parallel Halide
  * routine, shuts down and then reinitializes the thread pool. */
@@ -148,6 +181,24 @@ extern int32_t halide_debug_to_file(void *user_context, const char *filename,
                                     int32_t s3, int32_t type_code,
                                     int32_t bytes_per_element);
 
+/** Make halide_debug_to_file copy the data and return, and write the
+ * file on a background thread. Files are written in the order they
+ * were dumped. Writes that fail are reported through halide_print and
+ * by the next call to halide_debug_to_file_flush. Setting the
+ * environment variable HL_DEBUG_TO_FILE_ASYNC=1 does the same. */
+extern void halide_debug_to_file_set_async(bool async);
+
+/** Compress TIFF files written by halide_debug_to_file with LZW, after
+ * a predictor that takes the difference between adjacent samples. Most
+ * TIFF readers support this. Setting the environment variable
+ * HL_DEBUG_TO_FILE_COMPRESS=1 does the same. */
+extern void halide_debug_to_file_set_compression(bool compress);
+
+/** Wait for any asynchronous writes by halide_debug_to_file to
+ * finish. Returns halide_error_code_debug_to_file_failed if any of
+ * them failed since the last flush. Also happens at process exit. */
+extern int halide_debug_to_file_flush(void *user_context);
+
 
 enum halide_trace_event_code {halide_trace_load = 0,
                               halide_trace_store = 1,
@@ -344,6 +395,67 @@ extern void halide_memoization_cache_release(void *user_context, void *host);
  */
 extern void halide_memoization_cache_cleanup();
 
+/** The implementation of a memoization cache. The memoization
+ * functions above forward to the active one, which is an in-process
+ * cache unless replaced with
+ * halide_set_custom_memoization_cache. Each field has the semantics of
+ * the halide_memoization_cache_ function of the same name.
+ */
+struct halide_memoization_cache_t {
+    int (*lookup)(void *user_context, const uint8_t *cache_key, int32_t size,
+                  buffer_t *computed_bounds, int32_t tuple_count, buffer_t **tuple_buffers);
+    void (*store)(void *user_context, const uint8_t *cache_key, int32_t size,
+                  buffer_t *computed_bounds, int32_t tuple_count, buffer_t **tuple_buffers);
+    void (*release)(void *user_context, void *host);
+    void (*set_size)(int64_t size);
+    void (*cleanup)();
+};
+
+/** Replace the memoization cache implementation. Pass NULL to return
+ * to the default in-process cache. Returns the previous
+ * implementation. Must only be called when no pipelines are running,
+ * as buffers returned by one implementation must be released by the
+ * same one. Call the previous implementation's cleanup function if
+ * you are done with it; for the shared cache, that unmaps and closes
+ * its file.
+ */
+extern const struct halide_memoization_cache_t *
+halide_set_custom_memoization_cache(const struct halide_memoization_cache_t *cache);
+
+/** Get a memoization cache implementation that keeps its entries in
+ * a file mapped into memory, so that processes on the same host that
+ * open the same file share results. The file is created at the given
+ * size if it does not exist. Its size bounds the size of the cache, so
+ * halide_memoization_cache_set_size has no effect. Use it with
+ * halide_set_custom_memoization_cache. Returns NULL on failure. Only
+ * available on Linux, OS X, Android and iOS.
+ *
+ * Access is serialized across processes with flock. Entries in use
+ * by any process are reference counted and are not evicted. A
+ * process that exits without releasing its buffers pins the entries
+ * it was using until the file is removed.
+ *
+ * Cache keys normally contain addresses that are only meaningful in
+ * the process that made them. Pipelines that use this cache must be
+ * compiled with the memoize_stable_keys target feature.
+ */
+extern const struct halide_memoization_cache_t *
+halide_shared_memoization_cache(void *user_context, const char *path, int64_t size);
+
+/** Compute a 64-bit hash of the contents of a buffer, for use in the
+ * cache keys of Funcs scheduled with memoize_by_content. The shape of
+ * the buffer (its mins and extents) is included in the hash. Returns
+ * zero for a buffer with no host allocation (i.e. a bounds query).
+ */
+extern uint64_t halide_memoization_hash_buffer(void *user_context, buffer_t *buf);
+
+/** Like halide_memoization_hash_buffer, but only hashes the part of
+ * the buffer inside the box given by the mins and extents of
+ * region. Used to key the memoized realizations of a Func computed
+ * inside a loop on just the inputs each one reads.
+ */
+extern uint64_t halide_memoization_hash_buffer_region(void *user_context, buffer_t *buf, buffer_t *region);
+
 /** The error codes that may be returned by a Halide pipeline. */
 enum halide_error_code_t {
     /** There was no error. This is the value returned by Halide on success. */
@@ -724,6 +836,19 @@ extern int halide_enumerate_registered_filters(void *user_context, void* enumera
  * the -profile target flag, which runs a sampling profiler thread
  * alongside the pipeline. */
 
+/** The hardware events counted by the sampling profiler when
+ * halide_profiler_state::use_counters is set. */
+enum halide_profiler_counter {
+    halide_profiler_cycles = 0,
+    halide_profiler_instructions,
+    /// Loads that miss the level 1 data cache.
+    halide_profiler_l1d_misses,
+    /// Accesses that miss the last level cache.
+    halide_profiler_llc_misses,
+    halide_profiler_branch_misses,
+    halide_profiler_num_counters
+};
+
 /** Per-Func state tracked by the sampling profiler. */
 struct halide_profiler_func_stats {
     /** Total time taken evaluating this Func (in nanoseconds). */
@@ -731,6 +856,10 @@ struct halide_profiler_func_stats {
 
     /** The name of this Func. A global constant string. */
     const char *name;
+
+    /** Hardware events while evaluating this Func, indexed by
+     * halide_profiler_counter. Zero unless counters are in use. */
+    uint64_t counters[halide_profiler_num_counters];
 };
 
 /** Per-pipeline state tracked by the sampling profiler. These exist
@@ -785,6 +914,16 @@ struct halide_profiler_state {
 
     /** Is the profiler thread running. */
     bool started;
+
+    /** Set to true before running a profiled pipeline to also count
+     * hardware events per Func, alongside time. Setting the
+     * environment variable HL_PROFILER_COUNTERS=1 does the same. Only
+     * supported on x86 Linux, using perf_event_open. Events are
+     * counted in the thread that starts the profiler and any threads
+     * it creates afterwards, so a thread pool that is already running
+     * is not counted. Takes effect the next time the profiler thread
+     * starts. */
+    bool use_counters;
 };
 
 /** Profiler func ids with special meanings. */
@@ -805,9 +944,74 @@ extern halide_profiler_state *halide_profiler_get_state();
 extern void halide_profiler_reset();
 
 /** Print out timing statistics for everything run since the last
- * reset. Also happens at process exit. */
+ * reset. Also happens at process exit. If hardware events were
+ * counted, this includes the instructions per cycle, and cache and
+ * branch misses per thousand instructions, of each Func. */
 extern void halide_profiler_report(void *user_context);
 
+/** The functions below here are relevant for pipelines compiled with
+ * the -telemetry target flag, which records how long each call to the
+ * pipeline takes. It is cheap enough to leave on in production: there
+ * is no extra thread, nothing takes a lock, and only the call as a
+ * whole is timed, not each Func. */
+
+/** The number of buckets in a telemetry latency histogram. Latencies
+ * below 16ns get a bucket each. Above that each power of two is split
+ * into eight equal buckets, so a bucket's width is at most 1/8 of its
+ * lower bound. See halide_telemetry_bucket_min. */
+enum {
+    halide_telemetry_num_buckets = 496
+};
+
+/** Statistics on every call to one pipeline. These exist in a linked
+ * list, which is only ever added to. The fields are updated
+ * atomically as calls finish, and may be read at any time. */
+struct halide_telemetry_pipeline_stats {
+    /** The name of this pipeline. A copy owned by the runtime, which
+     * lives as long as the entry. */
+    const char *name;
+
+    /** The next pipeline_stats pointer. It's a void * because types
+     * in the Halide runtime may not currently be recursive. */
+    void *next;
+
+    /** The number of calls to the pipeline, including those that
+     * failed. Bounds queries aren't counted. */
+    uint64_t invocations;
+
+    /** The number of calls that returned an error. */
+    uint64_t errors;
+
+    /** The total size of the buffers allocated inside the pipeline,
+     * in bytes. This counts allocations made on the stack, and excludes
+     * buffers allocated inside GPU kernels. */
+    uint64_t bytes_allocated;
+
+    /** The total and largest time taken by a call (in nanoseconds). */
+    uint64_t total_time, max_time;
+
+    /** A histogram of the time taken by each call. */
+    uint64_t latency[halide_telemetry_num_buckets];
+};
+
+/** Get the first entry in the list of pipeline statistics, or NULL if
+ * no pipeline with telemetry has been called yet. Entries are never
+ * freed. */
+extern halide_telemetry_pipeline_stats *halide_telemetry_get_pipelines();
+
+/** Get the smallest time (in nanoseconds) counted in the given bucket
+ * of a latency histogram. */
+extern uint64_t halide_telemetry_bucket_min(int bucket);
+
+/** Estimate the given quantile (e.g. 0.99) of the time taken by calls
+ * to a pipeline, in nanoseconds, from its latency histogram. Accurate
+ * to within the width of a bucket. */
+extern uint64_t halide_telemetry_latency_quantile(const halide_telemetry_pipeline_stats *stats, double q);
+
+/** Zero the statistics of every pipeline. Calls in flight may still
+ * be counted afterwards. */
+extern void halide_telemetry_reset();
+
 /// \name "Float16" functions
 /// These functions operate of bits (``uint16_t``) representing a half
 /// precision floating point number (IEEE-754 2008 binary16).
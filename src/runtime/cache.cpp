@@ -289,11 +289,134 @@ WEAK void prune_cache() {
 #endif
 }
 
+WEAK uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+WEAK uint64_t fmix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Mix a run of bytes into a 64-bit hash. The bulk of the data is
+// consumed 32 bytes at a time by four independent lanes, so the
+// multiplies aren't serialized on one another and the loop can be
+// vectorized on targets with 64-bit vector multiplies.
+WEAK uint64_t hash_bytes(uint64_t h, const uint8_t *data, size_t size) {
+    const uint64_t k1 = 0x87c37b91114253d5ULL;
+    const uint64_t k2 = 0x4cf5ad432745937fULL;
+    uint64_t lane[4] = {h, h ^ k1, h ^ k2, h + k1};
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        uint64_t w[4];
+        memcpy(w, data + i, sizeof(w));
+        for (int j = 0; j < 4; j++) {
+            lane[j] = rotl64(lane[j] ^ (w[j] * k1), 31) * k2;
+        }
+    }
+    h = lane[0];
+    for (int j = 1; j < 4; j++) {
+        h = (h ^ fmix64(lane[j])) * k1;
+    }
+    for (; i < size; i++) {
+        h = (h ^ data[i]) * 0x100000001b3ULL;
+    }
+    return fmix64(h ^ size);
+}
+
+// Hash the elements of buf starting at ptr, over the given extents.
+WEAK uint64_t hash_buffer_dim(uint64_t h, const buffer_t *buf, const uint8_t *ptr,
+                              const int32_t *extent, int d) {
+    if (d < 0) {
+        return hash_bytes(h, ptr, buf->elem_size);
+    }
+    if (d == 0 && buf->stride[0] == 1) {
+        // Hash the innermost dimension as one contiguous run.
+        return hash_bytes(h, ptr, (size_t)extent[0] * buf->elem_size);
+    }
+    for (int32_t i = 0; i < extent[d]; i++) {
+        h = hash_buffer_dim(h, buf, ptr + (int64_t)i * buf->stride[d] * buf->elem_size, extent, d - 1);
+    }
+    return h;
+}
+
+// Hash the part of buf within the box given by min and extent. The
+// box is clipped to the buffer, and its shape is part of the hash.
+WEAK uint64_t hash_buffer_region(void *user_context, buffer_t *buf,
+                                 const int32_t *region_min, const int32_t *region_extent) {
+    if (buf == NULL || buf->host == NULL) {
+        // A bounds query. There's nothing to hash yet.
+        return 0;
+    }
+    if (buf->dev_dirty) {
+        halide_copy_to_host(user_context, buf);
+    }
+
+    int dims = 0;
+    while (dims < 4 && buf->extent[dims] != 0) {
+        dims++;
+    }
+
+    int32_t min[4], extent[4];
+    int64_t offset = 0;
+    for (int i = 0; i < dims; i++) {
+        int32_t lo = region_min[i], hi = region_min[i] + region_extent[i];
+        if (lo < buf->min[i]) lo = buf->min[i];
+        if (hi > buf->min[i] + buf->extent[i]) hi = buf->min[i] + buf->extent[i];
+        if (hi <= lo) {
+            // Nothing of the buffer is in the box.
+            return 0;
+        }
+        min[i] = lo;
+        extent[i] = hi - lo;
+        offset += (int64_t)(lo - buf->min[i]) * buf->stride[i];
+    }
+
+    uint64_t h = hash_bytes(0, (const uint8_t *)&buf->elem_size, sizeof(buf->elem_size));
+    h = hash_bytes(h, (const uint8_t *)min, dims * sizeof(min[0]));
+    h = hash_bytes(h, (const uint8_t *)extent, dims * sizeof(extent[0]));
+
+    return hash_buffer_dim(h, buf, buf->host + offset * buf->elem_size, extent, dims - 1);
+}
+
+// The hash table index of a cache entry. Funcs memoized inside a loop
+// have one entry per realization under the same key, so mix in the
+// computed bounds to spread those across the table.
+WEAK uint32_t entry_hash(const uint8_t *cache_key, int32_t size, const buffer_t &computed_bounds) {
+    uint32_t h = djb_hash(cache_key, size);
+    for (int i = 0; i < 4; i++) {
+        h = (h << 5) + h + (uint32_t)computed_bounds.min[i];
+        h = (h << 5) + h + (uint32_t)computed_bounds.extent[i];
+    }
+    return h;
+}
+
 }}} // namespace Halide::Runtime::Internal
 
 extern "C" {
 
-WEAK void halide_memoization_cache_set_size(int64_t size) {
+WEAK uint64_t halide_memoization_hash_buffer(void *user_context, buffer_t *buf) {
+    if (buf == NULL) {
+        return 0;
+    }
+    return hash_buffer_region(user_context, buf, buf->min, buf->extent);
+}
+
+WEAK uint64_t halide_memoization_hash_buffer_region(void *user_context, buffer_t *buf, buffer_t *region) {
+    return hash_buffer_region(user_context, buf, region->min, region->extent);
+}
+
+}
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// The default, in-process cache.
+
+WEAK void default_cache_set_size(int64_t size) {
     if (size == 0) {
         size = kDefaultCacheSize;
     }
@@ -304,9 +427,9 @@ WEAK void halide_memoization_cache_set_size(int64_t size) {
     prune_cache();
 }
 
-WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cache_key, int32_t size,
-                                         buffer_t *computed_bounds, int32_t tuple_count, buffer_t **tuple_buffers) {
-    uint32_t h = djb_hash(cache_key, size);
+WEAK int default_cache_lookup(void *user_context, const uint8_t *cache_key, int32_t size,
+                              buffer_t *computed_bounds, int32_t tuple_count, buffer_t **tuple_buffers) {
+    uint32_t h = entry_hash(cache_key, size, *computed_bounds);
     uint32_t index = h % kHashTableSize;
 
     ScopedMutexLock lock(&memoization_lock);
@@ -397,8 +520,8 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
     return 1;
 }
 
-WEAK void halide_memoization_cache_store(void *user_context, const uint8_t *cache_key, int32_t size,
-                                        buffer_t *computed_bounds, int32_t tuple_count, buffer_t **tuple_buffers) {
+WEAK void default_cache_store(void *user_context, const uint8_t *cache_key, int32_t size,
+                              buffer_t *computed_bounds, int32_t tuple_count, buffer_t **tuple_buffers) {
     debug(user_context) << "halide_memoization_cache_store\n";
 
     uint32_t h = *(uint32_t *)(tuple_buffers[0]->host - extra_bytes_host_bytes);
@@ -510,7 +633,7 @@ WEAK void halide_memoization_cache_store(void *user_context, const uint8_t *cach
     debug(user_context) << "Exiting halide_memoization_cache_store\n";
 }
 
-WEAK void halide_memoization_cache_release(void *user_context, void *host) {
+WEAK void default_cache_release(void *user_context, void *host) {
     uint8_t *base = (uint8_t *)host - extra_bytes_host_bytes;
     debug(user_context) << "halide_memoization_cache_release\n";
     CacheEntry *entry = *(CacheEntry **)(base);
@@ -530,7 +653,7 @@ WEAK void halide_memoization_cache_release(void *user_context, void *host) {
     debug(user_context) << "Exited halide_memoization_cache_release.\n";
 }
 
-WEAK void halide_memoization_cache_cleanup() {
+WEAK void default_cache_cleanup() {
     debug(NULL) << "halide_memoization_cache_cleanup\n";
     for (size_t i = 0; i < kHashTableSize; i++) {
         CacheEntry *entry = cache_entries[i];
@@ -546,6 +669,48 @@ WEAK void halide_memoization_cache_cleanup() {
     halide_mutex_cleanup(&memoization_lock);
 }
 
+WEAK halide_memoization_cache_t default_cache = {
+    default_cache_lookup,
+    default_cache_store,
+    default_cache_release,
+    default_cache_set_size,
+    default_cache_cleanup
+};
+
+WEAK const halide_memoization_cache_t *active_cache = &default_cache;
+
+}}} // namespace Halide::Runtime::Internal
+
+extern "C" {
+
+WEAK const halide_memoization_cache_t *halide_set_custom_memoization_cache(const halide_memoization_cache_t *cache) {
+    const halide_memoization_cache_t *result = active_cache;
+    active_cache = cache ? cache : &default_cache;
+    return result;
+}
+
+WEAK void halide_memoization_cache_set_size(int64_t size) {
+    active_cache->set_size(size);
+}
+
+WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cache_key, int32_t size,
+                                         buffer_t *computed_bounds, int32_t tuple_count, buffer_t **tuple_buffers) {
+    return active_cache->lookup(user_context, cache_key, size, computed_bounds, tuple_count, tuple_buffers);
+}
+
+WEAK void halide_memoization_cache_store(void *user_context, const uint8_t *cache_key, int32_t size,
+                                        buffer_t *computed_bounds, int32_t tuple_count, buffer_t **tuple_buffers) {
+    active_cache->store(user_context, cache_key, size, computed_bounds, tuple_count, tuple_buffers);
+}
+
+WEAK void halide_memoization_cache_release(void *user_context, void *host) {
+    active_cache->release(user_context, host);
+}
+
+WEAK void halide_memoization_cache_cleanup() {
+    active_cache->cleanup();
+}
+
 namespace {
 
 __attribute__((destructor))
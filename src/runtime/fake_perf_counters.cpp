@@ -0,0 +1,18 @@
+#include "runtime_internal.h"
+
+// Hardware event counting for the profiler is only supported on
+// Linux. Elsewhere there are no counters.
+
+extern "C" {
+
+WEAK int halide_perf_counters_open() {
+    return 0;
+}
+
+WEAK void halide_perf_counters_read(uint64_t *values) {
+}
+
+WEAK void halide_perf_counters_close() {
+}
+
+}
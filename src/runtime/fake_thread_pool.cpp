@@ -39,6 +39,42 @@ WEAK void halide_spawn_thread(void *user_context, void (*f)(void *), void *closu
     halide_error(user_context, "halide_spawn_thread not implemented on this platform.");
 }
 
+WEAK int halide_do_async(void *user_context, halide_task f,
+                         int min, int size, uint8_t *closure) {
+    // Async tasks wait on each other, so running them one after the
+    // other would deadlock. Emit an error.
+    halide_error(user_context, "halide_do_async not implemented on this platform.");
+    return halide_error_code_generic_error;
+}
+
+// Without threads, nothing can ever release a semaphore while
+// someone waits on it, so acquires that would block fail instead.
+struct fake_semaphore {
+    int count;
+};
+
+WEAK int halide_semaphore_init(halide_semaphore_t *sem, int count) {
+    ((fake_semaphore *)sem)->count = count;
+    return 0;
+}
+
+WEAK int halide_semaphore_release(halide_semaphore_t *sem, int n) {
+    ((fake_semaphore *)sem)->count += n;
+    return 0;
+}
+
+WEAK int halide_semaphore_acquire(halide_semaphore_t *sem_arg, int n) {
+    fake_semaphore *sem = (fake_semaphore *)sem_arg;
+    if (sem->count < n) {
+        return halide_error_code_generic_error;
+    }
+    sem->count -= n;
+    return 0;
+}
+
+WEAK void halide_semaphore_cancel(void *user_context, void *sem) {
+}
+
 WEAK void halide_mutex_cleanup(halide_mutex *mutex_arg) {
 }
 
@@ -0,0 +1,131 @@
+#include "runtime_internal.h"
+#include "HalideRuntime.h"
+
+// Hardware event counting for the profiler, using perf_event_open.
+
+extern "C" {
+
+// The syscall number for perf_event_open varies across platforms:
+// -- i386 is 336
+// -- x64 is 298
+
+#ifndef SYS_PERF_EVENT_OPEN
+
+#ifdef BITS_64
+#define SYS_PERF_EVENT_OPEN 298
+#endif
+
+#ifdef BITS_32
+#define SYS_PERF_EVENT_OPEN 336
+#endif
+
+#endif
+
+extern int syscall(int num, ...);
+extern ssize_t read(int fd, void *buf, size_t count);
+
+}
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// The first version of struct perf_event_attr from linux/perf_event.h.
+struct perf_event_attr {
+    uint32_t type;
+    uint32_t size;
+    uint64_t config;
+    uint64_t sample_period;
+    uint64_t sample_type;
+    uint64_t read_format;
+    uint64_t flags;
+    uint32_t wakeup_events;
+    uint32_t bp_type;
+    uint64_t config1;
+};
+
+#define PERF_TYPE_HARDWARE 0
+#define PERF_TYPE_HW_CACHE 3
+
+#define PERF_COUNT_HW_CPU_CYCLES 0
+#define PERF_COUNT_HW_INSTRUCTIONS 1
+#define PERF_COUNT_HW_CACHE_MISSES 3
+#define PERF_COUNT_HW_BRANCH_MISSES 5
+// Level 1 data cache, read accesses, misses.
+#define PERF_COUNT_HW_CACHE_L1D_READ_MISS (0 | (0 << 8) | (1 << 16))
+
+#define PERF_FORMAT_TOTAL_TIME_ENABLED 1
+#define PERF_FORMAT_TOTAL_TIME_RUNNING 2
+
+#define PERF_ATTR_FLAG_INHERIT (1 << 1)
+#define PERF_ATTR_FLAG_EXCLUDE_KERNEL (1 << 5)
+#define PERF_ATTR_FLAG_EXCLUDE_HV (1 << 6)
+
+// Indexed by halide_profiler_counter.
+WEAK int perf_counter_fds[halide_profiler_num_counters] = {-1, -1, -1, -1, -1};
+
+WEAK int open_perf_counter(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = type;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    // Scale the counts up if the kernel has to multiplex more
+    // counters than the hardware has.
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // Count in user code only, which doesn't need any privileges, in
+    // this thread and any threads it creates later.
+    attr.flags = PERF_ATTR_FLAG_INHERIT | PERF_ATTR_FLAG_EXCLUDE_KERNEL | PERF_ATTR_FLAG_EXCLUDE_HV;
+    // pid = 0, cpu = -1: this thread, on any cpu.
+    int fd = syscall(SYS_PERF_EVENT_OPEN, &attr, 0, -1, -1, 0);
+    return fd < 0 ? -1 : fd;
+}
+
+}}}
+
+extern "C" {
+
+WEAK int halide_perf_counters_open() {
+    halide_perf_counters_close();
+    perf_counter_fds[halide_profiler_cycles] =
+        open_perf_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    perf_counter_fds[halide_profiler_instructions] =
+        open_perf_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    perf_counter_fds[halide_profiler_l1d_misses] =
+        open_perf_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D_READ_MISS);
+    perf_counter_fds[halide_profiler_llc_misses] =
+        open_perf_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    perf_counter_fds[halide_profiler_branch_misses] =
+        open_perf_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+
+    int count = 0;
+    for (int i = 0; i < halide_profiler_num_counters; i++) {
+        if (perf_counter_fds[i] >= 0) count++;
+    }
+    return count;
+}
+
+WEAK void halide_perf_counters_read(uint64_t *values) {
+    for (int i = 0; i < halide_profiler_num_counters; i++) {
+        values[i] = 0;
+        if (perf_counter_fds[i] < 0) continue;
+        // The value, then the time enabled and running.
+        uint64_t buf[3];
+        if (read(perf_counter_fds[i], buf, sizeof(buf)) != (ssize_t)sizeof(buf)) continue;
+        if (buf[2] == 0) continue;
+        if (buf[2] < buf[1]) {
+            values[i] = (uint64_t)((double)buf[0] * buf[1] / buf[2]);
+        } else {
+            values[i] = buf[0];
+        }
+    }
+}
+
+WEAK void halide_perf_counters_close() {
+    for (int i = 0; i < halide_profiler_num_counters; i++) {
+        if (perf_counter_fds[i] >= 0) {
+            close(perf_counter_fds[i]);
+            perf_counter_fds[i] = -1;
+        }
+    }
+}
+
+}
@@ -0,0 +1,188 @@
+#include "runtime_internal.h"
+
+#include "HalideRuntime.h"
+
+// Async tasks and semaphores (see Func::async), shared by the posix
+// and GCD thread pools. They use pthreads directly rather than the
+// thread pool, because tasks blocked on a semaphore shouldn't tie up a
+// pool worker.
+
+extern "C" {
+
+typedef long pthread_t;
+typedef struct {
+    // 48 bytes is enough for a cond on 64-bit and 32-bit systems
+    uint64_t _private[6];
+} pthread_cond_t;
+typedef struct {
+    // 64 bytes is enough for a mutex on 64-bit and 32-bit systems
+    uint64_t _private[8];
+} pthread_mutex_t;
+extern int pthread_create(pthread_t *thread, void const *attr,
+                          void *(*start_routine)(void *), void *arg);
+extern int pthread_join(pthread_t thread, void **retval);
+extern int pthread_cond_init(pthread_cond_t *cond, const void *attr);
+extern int pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex);
+extern int pthread_cond_broadcast(pthread_cond_t *cond);
+extern int pthread_mutex_init(pthread_mutex_t *mutex, const void *attr);
+extern int pthread_mutex_lock(pthread_mutex_t *mutex);
+extern int pthread_mutex_unlock(pthread_mutex_t *mutex);
+
+WEAK int halide_do_task(void *user_context, halide_task_t f, int idx,
+                        uint8_t *closure);
+
+} // extern "C"
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+// The layout of a halide_semaphore_t. Initializing the mutex and
+// condition variable doesn't acquire any resources, so there's no
+// cleanup function.
+struct posix_semaphore {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int count;
+    bool cancelled;
+};
+
+// The tasks of a halide_do_async wait on this before they start, so
+// that if a thread can't be created, none of them run (the others
+// could wait forever on the missing one).
+struct async_start_gate {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    // Zero while the threads are being created, then positive if they
+    // all were, or negative if one couldn't be.
+    int state;
+};
+
+struct async_task {
+    pthread_t thread;
+    async_start_gate *gate;
+    halide_task_t f;
+    void *user_context;
+    int idx;
+    uint8_t *closure;
+    int exit_status;
+};
+WEAK void *halide_async_task_helper(void *arg) {
+    async_task *t = (async_task *)arg;
+    async_start_gate *gate = t->gate;
+    pthread_mutex_lock(&gate->mutex);
+    while (gate->state == 0) {
+        pthread_cond_wait(&gate->cond, &gate->mutex);
+    }
+    bool start = gate->state > 0;
+    pthread_mutex_unlock(&gate->mutex);
+    if (start) {
+        t->exit_status = halide_do_task(t->user_context, t->f, t->idx, t->closure);
+    }
+    return NULL;
+}
+
+}}} // namespace Halide::Runtime::Internal
+
+extern "C" {
+
+WEAK int halide_do_async(void *user_context, halide_task_t f,
+                         int min, int size, uint8_t *closure) {
+    if (size <= 0) {
+        return 0;
+    }
+
+    // The tasks may block waiting on each other, so they can't share
+    // the thread pool. Every task but the last gets a new thread.
+    async_task *tasks = (async_task *)malloc(sizeof(async_task) * (size - 1));
+    if (size > 1 && !tasks) {
+        return halide_error_out_of_memory(user_context);
+    }
+    async_start_gate gate;
+    pthread_mutex_init(&gate.mutex, NULL);
+    pthread_cond_init(&gate.cond, NULL);
+    gate.state = 0;
+    int threads = 0;
+    for (int i = 0; i < size - 1; i++) {
+        tasks[i].gate = &gate;
+        tasks[i].f = f;
+        tasks[i].user_context = user_context;
+        tasks[i].idx = min + i;
+        tasks[i].closure = closure;
+        tasks[i].exit_status = 0;
+        if (pthread_create(&tasks[i].thread, NULL, halide_async_task_helper, tasks + i) != 0) {
+            break;
+        }
+        threads++;
+    }
+
+    pthread_mutex_lock(&gate.mutex);
+    gate.state = (threads == size - 1) ? 1 : -1;
+    pthread_mutex_unlock(&gate.mutex);
+    pthread_cond_broadcast(&gate.cond);
+
+    int result;
+    if (gate.state > 0) {
+        result = halide_do_task(user_context, f, min + size - 1, closure);
+    } else {
+        halide_error(user_context, "halide_do_async couldn't create a thread\n");
+        result = halide_error_code_generic_error;
+    }
+
+    for (int i = 0; i < threads; i++) {
+        void *retval;
+        pthread_join(tasks[i].thread, &retval);
+        // A task that fails causes the others to fail with a generic
+        // error when they next acquire a semaphore. Report the
+        // original error in preference.
+        int status = tasks[i].exit_status;
+        if (status && (result == 0 || result == halide_error_code_generic_error)) {
+            result = status;
+        }
+    }
+    free(tasks);
+
+    return result;
+}
+
+WEAK int halide_semaphore_init(halide_semaphore_t *sem_arg, int count) {
+    posix_semaphore *sem = (posix_semaphore *)sem_arg;
+    pthread_mutex_init(&sem->mutex, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->count = count;
+    sem->cancelled = false;
+    return 0;
+}
+
+WEAK int halide_semaphore_release(halide_semaphore_t *sem_arg, int n) {
+    posix_semaphore *sem = (posix_semaphore *)sem_arg;
+    pthread_mutex_lock(&sem->mutex);
+    sem->count += n;
+    pthread_mutex_unlock(&sem->mutex);
+    pthread_cond_broadcast(&sem->cond);
+    return 0;
+}
+
+WEAK int halide_semaphore_acquire(halide_semaphore_t *sem_arg, int n) {
+    posix_semaphore *sem = (posix_semaphore *)sem_arg;
+    int result = 0;
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count < n && !sem->cancelled) {
+        pthread_cond_wait(&sem->cond, &sem->mutex);
+    }
+    if (sem->count >= n) {
+        sem->count -= n;
+    } else {
+        result = halide_error_code_generic_error;
+    }
+    pthread_mutex_unlock(&sem->mutex);
+    return result;
+}
+
+WEAK void halide_semaphore_cancel(void *user_context, void *sem_arg) {
+    posix_semaphore *sem = (posix_semaphore *)sem_arg;
+    pthread_mutex_lock(&sem->mutex);
+    sem->cancelled = true;
+    pthread_mutex_unlock(&sem->mutex);
+    pthread_cond_broadcast(&sem->cond);
+}
+
+} // extern "C"
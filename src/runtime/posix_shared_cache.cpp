@@ -0,0 +1,544 @@
+#include "runtime_internal.h"
+#include "HalideRuntime.h"
+#include "printer.h"
+#include "scoped_mutex_lock.h"
+
+// A memoization cache that keeps its entries in a file mapped into
+// memory, so that processes on the same host can share results. The
+// file holds a header with a hash table, followed by a heap of
+// blocks. All links in the file are offsets from its start, as it is
+// mapped at a different address in each process. Buffers computed on
+// a cache miss are allocated in the file to begin with, so storing
+// them doesn't copy anything.
+
+extern "C" {
+
+// These values are the same on Linux, OS X, Android and iOS.
+#define O_RDWR 2
+#define PROT_READ 1
+#define PROT_WRITE 2
+#define MAP_SHARED 1
+#define MAP_FAILED ((void *)-1)
+#define LOCK_EX 2
+#define LOCK_UN 8
+
+extern void *mmap(void *addr, size_t length, int prot, int flags, int fd, long offset);
+extern int munmap(void *addr, size_t length);
+extern int ftruncate(int fd, long length);
+extern int flock(int fd, int operation);
+extern int creat(const char *path, int mode);
+extern int link(const char *existing, const char *new_path);
+extern int unlink(const char *path);
+extern int getpid();
+
+}
+
+namespace Halide { namespace Runtime { namespace Internal { namespace SharedCache {
+
+const uint32_t kMagic = 0x484d4331;  // "HMC1"
+const uint32_t kTableSize = 1024;
+const uint64_t kAlignment = 32;
+
+struct Header {
+    uint32_t magic;
+    uint32_t table_size;
+    uint64_t file_size;
+    uint64_t heap_begin;
+    uint64_t heap_end;
+    // Bumped on every use of an entry, to find the least recently used.
+    uint64_t clock;
+    // The offset of the first entry block in each bucket, or zero.
+    uint64_t table[kTableSize];
+};
+
+enum BlockState {
+    Free,
+    // Storage handed out on a cache miss, not yet stored.
+    Pending,
+    // Storage that belongs to an entry.
+    Data,
+    Entry
+};
+
+// The heap is a sequence of blocks, each starting with one of these.
+// Its size keeps the contents of blocks aligned for vector loads.
+struct Block {
+    uint64_t size;  // Including this header
+    uint32_t state;
+    uint32_t unused;
+    uint64_t owner;  // For Data blocks, the offset of the Entry block
+    uint64_t unused2;
+};
+
+// The parts of a buffer_t that identify its bounds. (buffer_t itself
+// contains pointers, and processes may differ in their pointer size.)
+struct Shape {
+    int32_t elem_size;
+    int32_t min[4], extent[4], stride[4];
+    int32_t unused;
+    uint64_t data;  // The offset of the Data block
+};
+
+struct CacheEntry {
+    uint64_t next;
+    uint64_t last_used;
+    uint32_t hash;
+    int32_t in_use_count;  // Across all processes
+    int32_t key_size;
+    int32_t tuple_count;
+    Shape computed_bounds;
+    // Followed by tuple_count Shapes, and then the key.
+
+    Shape *shapes() {
+        return (Shape *)(this + 1);
+    }
+    uint8_t *key() {
+        return (uint8_t *)(shapes() + tuple_count);
+    }
+};
+
+WEAK halide_mutex cache_lock;
+WEAK int cache_fd = -1;
+WEAK uint8_t *cache_base = NULL;
+WEAK uint64_t cache_size = 0;
+WEAK char cache_path[1024];
+
+// flock serializes processes, but not threads that share the file
+// descriptor, so this is always taken inside cache_lock.
+struct ScopedFileLock {
+    ScopedFileLock() {
+        flock(cache_fd, LOCK_EX);
+    }
+    ~ScopedFileLock() {
+        flock(cache_fd, LOCK_UN);
+    }
+};
+
+WEAK uint64_t round_up(uint64_t x) {
+    return (x + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+WEAK Header *header() {
+    return (Header *)cache_base;
+}
+
+WEAK Block *block_at(uint64_t offset) {
+    return (Block *)(cache_base + offset);
+}
+
+WEAK uint64_t offset_of(const void *p) {
+    return (const uint8_t *)p - cache_base;
+}
+
+WEAK CacheEntry *entry_at(uint64_t offset) {
+    return (CacheEntry *)(block_at(offset) + 1);
+}
+
+WEAK bool in_cache(const void *p) {
+    return cache_base != NULL &&
+        (const uint8_t *)p >= cache_base &&
+        (const uint8_t *)p < cache_base + cache_size;
+}
+
+WEAK uint32_t key_hash(const uint8_t *key, int32_t key_size, const buffer_t &computed_bounds) {
+    uint32_t h = 5381;
+    for (int32_t i = 0; i < key_size; i++) {
+        h = (h << 5) + h + key[i];
+    }
+    for (int i = 0; i < 4; i++) {
+        h = (h << 5) + h + (uint32_t)computed_bounds.min[i];
+        h = (h << 5) + h + (uint32_t)computed_bounds.extent[i];
+    }
+    return h;
+}
+
+WEAK uint64_t buffer_bytes(const buffer_t &buf) {
+    uint64_t result = 1;
+    for (int i = 0; i < 4; i++) {
+        int32_t stride = buf.stride[i] < 0 ? -buf.stride[i] : buf.stride[i];
+        uint64_t size = (uint64_t)buf.extent[i] * stride;
+        if (size > result) {
+            result = size;
+        }
+    }
+    return result * buf.elem_size;
+}
+
+WEAK void set_shape(Shape &s, const buffer_t &buf, uint64_t data) {
+    s.elem_size = buf.elem_size;
+    for (int i = 0; i < 4; i++) {
+        s.min[i] = buf.min[i];
+        s.extent[i] = buf.extent[i];
+        s.stride[i] = buf.stride[i];
+    }
+    s.unused = 0;
+    s.data = data;
+}
+
+WEAK bool shape_matches(const Shape &s, const buffer_t &buf) {
+    if (s.elem_size != buf.elem_size) {
+        return false;
+    }
+    for (int i = 0; i < 4; i++) {
+        if (s.min[i] != buf.min[i] ||
+            s.extent[i] != buf.extent[i] ||
+            s.stride[i] != buf.stride[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+WEAK bool entry_matches(CacheEntry *entry, uint32_t h, const uint8_t *cache_key, int32_t size,
+                        const buffer_t &computed_bounds, int32_t tuple_count, buffer_t **tuple_buffers) {
+    if (entry->hash != h ||
+        entry->key_size != size ||
+        entry->tuple_count != tuple_count ||
+        memcmp(entry->key(), cache_key, size) != 0 ||
+        !shape_matches(entry->computed_bounds, computed_bounds)) {
+        return false;
+    }
+    for (int32_t i = 0; i < tuple_count; i++) {
+        if (!shape_matches(entry->shapes()[i], *tuple_buffers[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Remove the least recently used entry that isn't in use by any
+// process, and free its blocks. Returns false if there isn't one.
+WEAK bool evict_one() {
+    Header *hdr = header();
+    Block *victim = NULL;
+    for (uint64_t b = hdr->heap_begin; b < hdr->heap_end; b += block_at(b)->size) {
+        Block *block = block_at(b);
+        if (block->state == Entry) {
+            CacheEntry *entry = (CacheEntry *)(block + 1);
+            if (entry->in_use_count == 0 &&
+                (victim == NULL || entry->last_used < ((CacheEntry *)(victim + 1))->last_used)) {
+                victim = block;
+            }
+        }
+    }
+    if (victim == NULL) {
+        return false;
+    }
+
+    CacheEntry *entry = (CacheEntry *)(victim + 1);
+    uint64_t *link = &hdr->table[entry->hash % kTableSize];
+    while (*link != offset_of(victim)) {
+        halide_assert(NULL, *link != 0);
+        link = &entry_at(*link)->next;
+    }
+    *link = entry->next;
+
+    for (int32_t i = 0; i < entry->tuple_count; i++) {
+        block_at(entry->shapes()[i].data)->state = Free;
+    }
+    victim->state = Free;
+    return true;
+}
+
+// First-fit allocation from the heap, merging runs of free blocks as
+// they are found, and evicting entries when nothing fits.
+WEAK Block *allocate(uint64_t bytes, BlockState state) {
+    Header *hdr = header();
+    uint64_t needed = round_up(sizeof(Block) + bytes);
+    while (true) {
+        for (uint64_t b = hdr->heap_begin; b < hdr->heap_end; b += block_at(b)->size) {
+            Block *block = block_at(b);
+            if (block->state != Free) {
+                continue;
+            }
+            while (b + block->size < hdr->heap_end &&
+                   block_at(b + block->size)->state == Free) {
+                block->size += block_at(b + block->size)->size;
+            }
+            if (block->size >= needed) {
+                if (block->size - needed >= round_up(sizeof(Block) + 1)) {
+                    Block *rest = block_at(b + needed);
+                    rest->size = block->size - needed;
+                    rest->state = Free;
+                    rest->owner = 0;
+                    block->size = needed;
+                }
+                block->state = state;
+                block->owner = 0;
+                return block;
+            }
+        }
+        if (!evict_one()) {
+            return NULL;
+        }
+    }
+}
+
+WEAK int shared_cache_lookup(void *user_context, const uint8_t *cache_key, int32_t size,
+                             buffer_t *computed_bounds, int32_t tuple_count, buffer_t **tuple_buffers) {
+    uint32_t h = key_hash(cache_key, size, *computed_bounds);
+
+    {
+        ScopedMutexLock lock(&cache_lock);
+        ScopedFileLock file_lock;
+
+        Header *hdr = header();
+        for (uint64_t e = hdr->table[h % kTableSize]; e != 0; e = entry_at(e)->next) {
+            CacheEntry *entry = entry_at(e);
+            if (entry_matches(entry, h, cache_key, size, *computed_bounds, tuple_count, tuple_buffers)) {
+                entry->last_used = ++hdr->clock;
+                entry->in_use_count += tuple_count;
+                for (int32_t i = 0; i < tuple_count; i++) {
+                    tuple_buffers[i]->host = (uint8_t *)(block_at(entry->shapes()[i].data) + 1);
+                }
+                return 0;
+            }
+        }
+
+        // A miss. Allocate the storage to compute into in the file.
+        int32_t allocated = 0;
+        while (allocated < tuple_count) {
+            Block *block = allocate(buffer_bytes(*tuple_buffers[allocated]), Pending);
+            if (block == NULL) {
+                break;
+            }
+            tuple_buffers[allocated]->host = (uint8_t *)(block + 1);
+            allocated++;
+        }
+        if (allocated == tuple_count) {
+            return 1;
+        }
+        for (int32_t i = 0; i < allocated; i++) {
+            ((Block *)tuple_buffers[i]->host - 1)->state = Free;
+            tuple_buffers[i]->host = NULL;
+        }
+    }
+
+    // The file is full of entries in use. Compute into the heap, and
+    // don't store the result.
+    for (int32_t i = 0; i < tuple_count; i++) {
+        tuple_buffers[i]->host = (uint8_t *)halide_malloc(user_context, buffer_bytes(*tuple_buffers[i]));
+        if (tuple_buffers[i]->host == NULL) {
+            for (int32_t j = i; j > 0; j--) {
+                halide_free(user_context, tuple_buffers[j - 1]->host);
+                tuple_buffers[j - 1]->host = NULL;
+            }
+            return -1;
+        }
+    }
+    return 1;
+}
+
+WEAK void shared_cache_store(void *user_context, const uint8_t *cache_key, int32_t size,
+                             buffer_t *computed_bounds, int32_t tuple_count, buffer_t **tuple_buffers) {
+    for (int32_t i = 0; i < tuple_count; i++) {
+        if (!in_cache(tuple_buffers[i]->host)) {
+            return;
+        }
+    }
+
+    uint32_t h = key_hash(cache_key, size, *computed_bounds);
+
+    ScopedMutexLock lock(&cache_lock);
+    ScopedFileLock file_lock;
+
+    Header *hdr = header();
+    uint64_t *bucket = &hdr->table[h % kTableSize];
+    for (uint64_t e = *bucket; e != 0; e = entry_at(e)->next) {
+        if (entry_matches(entry_at(e), h, cache_key, size, *computed_bounds, tuple_count, tuple_buffers)) {
+            // Another process got there first. Our storage stays
+            // pending, and is freed on release.
+            return;
+        }
+    }
+
+    Block *block = allocate(sizeof(CacheEntry) + tuple_count * sizeof(Shape) + size, Entry);
+    if (block == NULL) {
+        return;
+    }
+    CacheEntry *entry = (CacheEntry *)(block + 1);
+    entry->next = *bucket;
+    entry->last_used = ++hdr->clock;
+    entry->hash = h;
+    entry->in_use_count = tuple_count;
+    entry->key_size = size;
+    entry->tuple_count = tuple_count;
+    set_shape(entry->computed_bounds, *computed_bounds, 0);
+    for (int32_t i = 0; i < tuple_count; i++) {
+        Block *data = (Block *)tuple_buffers[i]->host - 1;
+        data->state = Data;
+        data->owner = offset_of(block);
+        set_shape(entry->shapes()[i], *tuple_buffers[i], offset_of(data));
+    }
+    memcpy(entry->key(), cache_key, size);
+    *bucket = offset_of(block);
+}
+
+WEAK void shared_cache_release(void *user_context, void *host) {
+    if (!in_cache(host)) {
+        halide_free(user_context, host);
+        return;
+    }
+
+    ScopedMutexLock lock(&cache_lock);
+    ScopedFileLock file_lock;
+
+    Block *data = (Block *)host - 1;
+    if (data->state == Pending) {
+        data->state = Free;
+    } else {
+        halide_assert(user_context, data->state == Data);
+        CacheEntry *entry = entry_at(data->owner);
+        halide_assert(user_context, entry->in_use_count > 0);
+        entry->in_use_count--;
+    }
+}
+
+WEAK void shared_cache_set_size(int64_t) {
+    // The size of the file is the size of the cache.
+}
+
+WEAK void shared_cache_cleanup();
+
+WEAK halide_memoization_cache_t shared_cache = {
+    shared_cache_lookup,
+    shared_cache_store,
+    shared_cache_release,
+    shared_cache_set_size,
+    shared_cache_cleanup
+};
+
+WEAK void shared_cache_cleanup() {
+    // The entries stay in the file for other processes. Just unmap it.
+    ScopedMutexLock lock(&cache_lock);
+    if (cache_base != NULL) {
+        munmap(cache_base, cache_size);
+        close(cache_fd);
+        cache_base = NULL;
+        cache_size = 0;
+        cache_fd = -1;
+        halide_set_custom_memoization_cache(NULL);
+    }
+}
+
+// Create and initialize a cache file. It's built under a temporary
+// name and then linked into place, so no process ever sees a
+// partially initialized one.
+WEAK bool create_cache_file(void *user_context, const char *path, int64_t size) {
+    char tmp_path[1024 + 32];
+    char *dst = tmp_path, *end = tmp_path + sizeof(tmp_path);
+    dst = halide_string_to_string(dst, end, path);
+    dst = halide_string_to_string(dst, end, ".");
+    dst = halide_int64_to_string(dst, end, getpid(), 1);
+    dst = halide_string_to_string(dst, end, ".tmp");
+
+    uint64_t heap_begin = round_up(sizeof(Header));
+    uint64_t file_size = round_up(size);
+    if (file_size < heap_begin + 64 * kAlignment) {
+        file_size = heap_begin + 64 * kAlignment;
+    }
+
+    int fd = creat(tmp_path, 0666);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    fd = open(tmp_path, O_RDWR, 0);
+    if (fd < 0 || ftruncate(fd, (long)file_size) != 0) {
+        if (fd >= 0) close(fd);
+        unlink(tmp_path);
+        return false;
+    }
+    void *p = mmap(NULL, heap_begin + sizeof(Block), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        close(fd);
+        unlink(tmp_path);
+        return false;
+    }
+
+    // ftruncate zero-fills, so the hash table starts out empty.
+    Header *hdr = (Header *)p;
+    hdr->magic = kMagic;
+    hdr->table_size = kTableSize;
+    hdr->file_size = file_size;
+    hdr->heap_begin = heap_begin;
+    hdr->heap_end = file_size;
+    hdr->clock = 0;
+    Block *heap = (Block *)((uint8_t *)p + heap_begin);
+    heap->size = file_size - heap_begin;
+    heap->state = Free;
+
+    munmap(p, heap_begin + sizeof(Block));
+    close(fd);
+
+    // If another process created the file first, this fails, and we
+    // use theirs.
+    link(tmp_path, path);
+    unlink(tmp_path);
+    return true;
+}
+
+}}}} // namespace Halide::Runtime::Internal::SharedCache
+
+using namespace Halide::Runtime::Internal::SharedCache;
+
+extern "C" {
+
+WEAK const halide_memoization_cache_t *halide_shared_memoization_cache(void *user_context, const char *path, int64_t size) {
+    ScopedMutexLock lock(&cache_lock);
+
+    if (cache_base != NULL) {
+        if (strcmp(path, cache_path) == 0) {
+            return &shared_cache;
+        }
+        error(user_context) << "halide_shared_memoization_cache: can't open " << path
+                            << " while " << cache_path << " is open\n";
+        return NULL;
+    }
+
+    if (strlen(path) >= sizeof(cache_path)) {
+        error(user_context) << "halide_shared_memoization_cache: path too long: " << path << "\n";
+        return NULL;
+    }
+
+    int fd = open(path, O_RDWR, 0);
+    if (fd < 0 && create_cache_file(user_context, path, size)) {
+        fd = open(path, O_RDWR, 0);
+    }
+    if (fd < 0) {
+        error(user_context) << "halide_shared_memoization_cache: can't open or create " << path << "\n";
+        return NULL;
+    }
+
+    // Check the header, and find out how big the file is.
+    Header *hdr = (Header *)mmap(NULL, sizeof(Header), PROT_READ, MAP_SHARED, fd, 0);
+    if (hdr == MAP_FAILED) {
+        close(fd);
+        error(user_context) << "halide_shared_memoization_cache: can't map " << path << "\n";
+        return NULL;
+    }
+    bool valid = hdr->magic == kMagic && hdr->table_size == kTableSize;
+    uint64_t file_size = hdr->file_size;
+    munmap(hdr, sizeof(Header));
+    if (!valid) {
+        close(fd);
+        error(user_context) << "halide_shared_memoization_cache: " << path
+                            << " is not a memoization cache file\n";
+        return NULL;
+    }
+
+    void *p = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        close(fd);
+        error(user_context) << "halide_shared_memoization_cache: can't map " << path << "\n";
+        return NULL;
+    }
+
+    cache_fd = fd;
+    cache_base = (uint8_t *)p;
+    cache_size = file_size;
+    strncpy(cache_path, path, sizeof(cache_path));
+    return &shared_cache;
+}
+
+}
@@ -10,13 +10,17 @@
 extern "C" {
 // Returns the address of the global halide_profiler state
 WEAK halide_profiler_state *halide_profiler_get_state() {
-    static halide_profiler_state s = {{{0}}, NULL, 1, 0, 0, false};
+    static halide_profiler_state s = {{{0}}, NULL, 1, 0, 0, false, false};
     return &s;
 }
 }
 
 namespace Halide { namespace Runtime { namespace Internal {
 
+// Whether hardware event counters are open while the profiler thread
+// runs. Guarded by the profiler state lock.
+WEAK bool profiler_counting = false;
+
 WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipeline_name, int num_funcs, const uint64_t *func_names) {
     halide_profiler_state *s = halide_profiler_get_state();
 
@@ -48,13 +52,16 @@ WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipelin
     for (int i = 0; i < num_funcs; i++) {
         p->funcs[i].time = 0;
         p->funcs[i].name = (const char *)(func_names[i]);
+        for (int j = 0; j < halide_profiler_num_counters; j++) {
+            p->funcs[i].counters[j] = 0;
+        }
     }
     s->first_free_id += num_funcs;
     s->pipelines = p;
     return p;
 }
 
-WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time) {
+WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time, const uint64_t *counters) {
     halide_profiler_pipeline_stats *p_prev = NULL;
     for (halide_profiler_pipeline_stats *p = s->pipelines; p;
          p = (halide_profiler_pipeline_stats *)(p->next)) {
@@ -65,7 +72,13 @@ WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time) {
                 p->next = s->pipelines;
                 s->pipelines = p;
             }
-            p->funcs[func_id - p->first_func_id].time += time;
+            halide_profiler_func_stats *fs = p->funcs + (func_id - p->first_func_id);
+            fs->time += time;
+            if (counters) {
+                for (int i = 0; i < halide_profiler_num_counters; i++) {
+                    fs->counters[i] += counters[i];
+                }
+            }
             p->time += time;
             p->samples++;
             return;
@@ -78,6 +91,11 @@ WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time) {
 WEAK void sampling_profiler_thread(void *) {
     halide_profiler_state *s = halide_profiler_get_state();
 
+    // The running totals of the hardware event counters, and their
+    // change since the last sample.
+    uint64_t counters[halide_profiler_num_counters];
+    uint64_t delta[halide_profiler_num_counters];
+
     // grab the lock
     halide_mutex_lock(&s->lock);
 
@@ -85,15 +103,26 @@ WEAK void sampling_profiler_thread(void *) {
 
         uint64_t t1 = halide_current_time_ns(NULL);
         uint64_t t = t1;
+        if (profiler_counting) {
+            halide_perf_counters_read(counters);
+        }
         while (1) {
             uint64_t t_now = halide_current_time_ns(NULL);
+            if (profiler_counting) {
+                halide_perf_counters_read(delta);
+                for (int i = 0; i < halide_profiler_num_counters; i++) {
+                    uint64_t total = delta[i];
+                    delta[i] = total - counters[i];
+                    counters[i] = total;
+                }
+            }
             int func = s->current_func;
             if (func == halide_profiler_please_stop) {
                 break;
             } else if (func >= 0) {
-                // Assume all time since I was last awake is due to
-                // the currently running func.
-                bill_func(s, func, t_now - t);
+                // Assume all time and events since I was last awake
+                // are due to the currently running func.
+                bill_func(s, func, t_now - t, profiler_counting ? delta : NULL);
             }
             t = t_now;
 
@@ -105,6 +134,11 @@ WEAK void sampling_profiler_thread(void *) {
         }
     }
 
+    if (profiler_counting) {
+        halide_perf_counters_close();
+        profiler_counting = false;
+    }
+
     s->started = false;
 
     halide_mutex_unlock(&s->lock);
@@ -125,6 +159,17 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
 
     if (!s->started) {
         halide_start_clock(user_context);
+        if (!s->use_counters) {
+            const char *counters_env = getenv("HL_PROFILER_COUNTERS");
+            s->use_counters = counters_env && atoi(counters_env);
+        }
+        // Counters follow the thread that opens them into the threads
+        // it creates, so open them here rather than in the profiler
+        // thread. The profiler thread itself is then counted too, but
+        // it does little more than sleep.
+        if (s->use_counters) {
+            profiler_counting = halide_perf_counters_open() > 0;
+        }
         halide_spawn_thread(user_context, sampling_profiler_thread, NULL);
         s->started = true;
     }
@@ -142,7 +187,7 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
 
 WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_state *s) {
 
-    char line_buf[160];
+    char line_buf[256];
     Printer<StringStreamPrinter, sizeof(line_buf)> sstr(user_context, line_buf);
 
     for (halide_profiler_pipeline_stats *p = s->pipelines; p;
@@ -173,7 +218,19 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
                 while (sstr.size() < 40) sstr << " ";
 
                 int percent = fs->time / (p->time / 100);
-                sstr << "(" << percent << "%)\n";
+                sstr << "(" << percent << "%)";
+
+                uint64_t cycles = fs->counters[halide_profiler_cycles];
+                uint64_t instructions = fs->counters[halide_profiler_instructions];
+                if (cycles && instructions) {
+                    while (sstr.size() < 48) sstr << " ";
+                    float kilo_instructions = instructions / 1000.0f;
+                    sstr << "ipc: " << (float)instructions / cycles
+                         << "  l1d mpki: " << fs->counters[halide_profiler_l1d_misses] / kilo_instructions
+                         << "  llc mpki: " << fs->counters[halide_profiler_llc_misses] / kilo_instructions
+                         << "  branch mpki: " << fs->counters[halide_profiler_branch_misses] / kilo_instructions;
+                }
+                sstr << "\n";
 
                 halide_print(user_context, sstr.str());
             }
@@ -26,11 +26,15 @@ __attribute__((used)) void *runtime_api_functions[] = {
     (void *)&halide_cuda_wrap_device_ptr,
     (void *)&halide_current_time_ns,
     (void *)&halide_debug_to_file,
+    (void *)&halide_debug_to_file_flush,
+    (void *)&halide_debug_to_file_set_async,
+    (void *)&halide_debug_to_file_set_compression,
     (void *)&halide_device_free,
     (void *)&halide_device_free_as_destructor,
     (void *)&halide_device_malloc,
     (void *)&halide_device_release,
     (void *)&halide_device_sync,
+    (void *)&halide_do_async,
     (void *)&halide_do_par_for,
     (void *)&halide_double_to_string,
     (void *)&halide_enumerate_registered_filters,
@@ -69,6 +73,8 @@ __attribute__((used)) void *runtime_api_functions[] = {
     (void *)&halide_memoization_cache_release,
     (void *)&halide_memoization_cache_set_size,
     (void *)&halide_memoization_cache_store,
+    (void *)&halide_memoization_hash_buffer,
+    (void *)&halide_memoization_hash_buffer_region,
     (void *)&halide_metal_acquire_context,
     (void *)&halide_metal_detach_buffer,
     (void *)&halide_metal_device_interface,
@@ -114,6 +120,10 @@ __attribute__((used)) void *runtime_api_functions[] = {
     (void *)&halide_renderscript_initialize_kernels,
     (void *)&halide_renderscript_run,
     (void *)&halide_runtime_internal_register_metadata,
+    (void *)&halide_semaphore_acquire,
+    (void *)&halide_semaphore_cancel,
+    (void *)&halide_semaphore_init,
+    (void *)&halide_semaphore_release,
     (void *)&halide_set_gpu_device,
     (void *)&halide_set_num_threads,
     (void *)&halide_set_trace_file,
@@ -123,6 +133,13 @@ __attribute__((used)) void *runtime_api_functions[] = {
     (void *)&halide_spawn_thread,
     (void *)&halide_start_clock,
     (void *)&halide_string_to_string,
+    (void *)&halide_telemetry_add_bytes,
+    (void *)&halide_telemetry_bucket_min,
+    (void *)&halide_telemetry_get_pipelines,
+    (void *)&halide_telemetry_latency_quantile,
+    (void *)&halide_telemetry_pipeline_end,
+    (void *)&halide_telemetry_pipeline_start,
+    (void *)&halide_telemetry_reset,
     (void *)&halide_trace,
     (void *)&halide_uint64_to_string,
     (void *)&halide_use_jit_module,
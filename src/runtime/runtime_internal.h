@@ -103,11 +103,27 @@ WEAK int64_t halide_current_time_ns(void *user_context);
 WEAK void halide_sleep_ms(void *user_context, int ms);
 WEAK void halide_device_free_as_destructor(void *user_context, void *obj);
 
+// Hardware event counters used by the profiler. Open starts counting
+// in the calling thread and any threads it creates afterwards, and
+// returns the number of counters available. Read writes the running
+// totals, indexed by halide_profiler_counter, with zero for counters
+// that are not available.
+WEAK int halide_perf_counters_open();
+WEAK void halide_perf_counters_read(uint64_t *values);
+WEAK void halide_perf_counters_close();
+
 WEAK int halide_profiler_pipeline_start(void *user_context,
                                         const char *pipeline_name,
                                         int num_funcs,
                                         const uint64_t *func_names);
 
+// Called by pipelines compiled with the telemetry target flag. Start
+// and end bracket a call to the pipeline. The call argument points to
+// space for four uint64_t on the pipeline's stack.
+WEAK int halide_telemetry_pipeline_start(void *user_context, const char *pipeline_name, void *call);
+WEAK int halide_telemetry_add_bytes(void *call, uint64_t bytes);
+WEAK void halide_telemetry_pipeline_end(void *user_context, void *call);
+
 struct halide_filter_metadata_t;
 struct _halide_runtime_internal_registered_filter_t {
     // This is a _halide_runtime_internal_registered_filter_t, but
@@ -0,0 +1,183 @@
+#include "runtime_internal.h"
+#include "HalideRuntime.h"
+
+// Telemetry is meant to be left on in production, so nothing here
+// takes a lock. Pipeline stats are only ever added to the list, never
+// removed, and all counters are updated atomically.
+
+namespace Halide { namespace Runtime { namespace Internal {
+
+WEAK halide_telemetry_pipeline_stats *telemetry_pipelines = NULL;
+
+// The state of one call to a pipeline. Lives on the pipeline's stack,
+// which reserves four uint64_t for it.
+struct telemetry_call {
+    halide_telemetry_pipeline_stats *stats;
+    uint64_t start;
+    uint64_t bytes_allocated;
+    uint64_t succeeded;
+};
+
+// Latencies below this many nanoseconds get a bucket each. Above it,
+// each power of two is split into telemetry_sub_buckets buckets.
+#define telemetry_sub_bucket_bits 3
+#define telemetry_sub_buckets (1 << telemetry_sub_bucket_bits)
+#define telemetry_exact_buckets (2 * telemetry_sub_buckets)
+
+WEAK int telemetry_bucket(uint64_t t) {
+    if (t < telemetry_exact_buckets) {
+        return (int)t;
+    }
+    int e = 63 - __builtin_clzll(t);
+    int sub = (int)(t >> (e - telemetry_sub_bucket_bits)) - telemetry_sub_buckets;
+    return telemetry_exact_buckets + (e - telemetry_sub_bucket_bits - 1) * telemetry_sub_buckets + sub;
+}
+
+// Search the list from the given entry up to (but not including) the
+// given end for a pipeline with the given name.
+WEAK halide_telemetry_pipeline_stats *find_telemetry_pipeline(halide_telemetry_pipeline_stats *p,
+                                                              halide_telemetry_pipeline_stats *end,
+                                                              const char *pipeline_name) {
+    for (; p != end; p = (halide_telemetry_pipeline_stats *)(p->next)) {
+        // Compare the contents, so that recompiling a pipeline
+        // doesn't start a new entry.
+        if (strcmp(p->name, pipeline_name) == 0) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+WEAK halide_telemetry_pipeline_stats *find_or_create_telemetry_pipeline(const char *pipeline_name) {
+    halide_telemetry_pipeline_stats *head = telemetry_pipelines;
+    halide_telemetry_pipeline_stats *p = find_telemetry_pipeline(head, NULL, pipeline_name);
+    if (p) return p;
+
+    // The name belongs to the pipeline's code, which may be unloaded
+    // (e.g. when a jitted pipeline is recompiled) while the entry
+    // lives on, so keep a copy of it after the stats.
+    size_t name_len = strlen(pipeline_name) + 1;
+    p = (halide_telemetry_pipeline_stats *)malloc(sizeof(halide_telemetry_pipeline_stats) + name_len);
+    if (!p) return NULL;
+    memset(p, 0, sizeof(halide_telemetry_pipeline_stats));
+    char *name = (char *)(p + 1);
+    memcpy(name, pipeline_name, name_len);
+    p->name = name;
+
+    while (1) {
+        p->next = head;
+        if (__sync_bool_compare_and_swap(&telemetry_pipelines, head, p)) {
+            return p;
+        }
+        // Someone else added a pipeline first. It might be this one.
+        halide_telemetry_pipeline_stats *new_head = telemetry_pipelines;
+        halide_telemetry_pipeline_stats *other = find_telemetry_pipeline(new_head, head, pipeline_name);
+        if (other) {
+            free(p);
+            return other;
+        }
+        head = new_head;
+    }
+}
+
+}}}
+
+extern "C" {
+
+WEAK int halide_telemetry_pipeline_start(void *user_context, const char *pipeline_name, void *c) {
+    telemetry_call *call = (telemetry_call *)c;
+    call->stats = find_or_create_telemetry_pipeline(pipeline_name);
+    call->bytes_allocated = 0;
+    call->succeeded = 0;
+    halide_start_clock(user_context);
+    call->start = halide_current_time_ns(user_context);
+    return 0;
+}
+
+WEAK int halide_telemetry_add_bytes(void *c, uint64_t bytes) {
+    telemetry_call *call = (telemetry_call *)c;
+    // Allocations may happen inside parallel loops.
+    __sync_fetch_and_add(&call->bytes_allocated, bytes);
+    return 0;
+}
+
+WEAK void halide_telemetry_pipeline_end(void *user_context, void *c) {
+    telemetry_call *call = (telemetry_call *)c;
+    int64_t t = halide_current_time_ns(user_context) - call->start;
+    uint64_t time = t > 0 ? (uint64_t)t : 0;
+
+    halide_telemetry_pipeline_stats *p = call->stats;
+    if (!p) {
+        // Allocating space to track the statistics failed.
+        return;
+    }
+    __sync_fetch_and_add(&p->invocations, 1);
+    if (!call->succeeded) {
+        __sync_fetch_and_add(&p->errors, 1);
+    }
+    __sync_fetch_and_add(&p->bytes_allocated, call->bytes_allocated);
+    __sync_fetch_and_add(&p->total_time, time);
+    __sync_fetch_and_add(&p->latency[telemetry_bucket(time)], 1);
+    uint64_t max_time = p->max_time;
+    while (time > max_time &&
+           !__sync_bool_compare_and_swap(&p->max_time, max_time, time)) {
+        max_time = p->max_time;
+    }
+}
+
+WEAK halide_telemetry_pipeline_stats *halide_telemetry_get_pipelines() {
+    return telemetry_pipelines;
+}
+
+WEAK uint64_t halide_telemetry_bucket_min(int bucket) {
+    if (bucket < telemetry_exact_buckets) {
+        return bucket;
+    }
+    int i = bucket - telemetry_exact_buckets;
+    int e = i / telemetry_sub_buckets + telemetry_sub_bucket_bits + 1;
+    uint64_t sub = i % telemetry_sub_buckets;
+    return (telemetry_sub_buckets + sub) << (e - telemetry_sub_bucket_bits);
+}
+
+WEAK uint64_t halide_telemetry_latency_quantile(const halide_telemetry_pipeline_stats *p, double q) {
+    // Take a snapshot, as calls may be finishing concurrently.
+    uint64_t counts[halide_telemetry_num_buckets];
+    uint64_t total = 0;
+    for (int i = 0; i < halide_telemetry_num_buckets; i++) {
+        counts[i] = p->latency[i];
+        total += counts[i];
+    }
+    if (total == 0) return 0;
+
+    if (q < 0) q = 0;
+    if (q > 1) q = 1;
+    uint64_t rank = (uint64_t)(q * (total - 1));
+    uint64_t seen = 0;
+    for (int i = 0; i < halide_telemetry_num_buckets; i++) {
+        seen += counts[i];
+        if (seen > rank) {
+            // Report the middle of the bucket.
+            uint64_t lo = halide_telemetry_bucket_min(i);
+            if (i + 1 == halide_telemetry_num_buckets) return lo;
+            uint64_t hi = halide_telemetry_bucket_min(i + 1);
+            return lo + (hi - lo - 1) / 2;
+        }
+    }
+    return 0;
+}
+
+WEAK void halide_telemetry_reset() {
+    for (halide_telemetry_pipeline_stats *p = telemetry_pipelines; p;
+         p = (halide_telemetry_pipeline_stats *)(p->next)) {
+        p->invocations = 0;
+        p->errors = 0;
+        p->bytes_allocated = 0;
+        p->total_time = 0;
+        p->max_time = 0;
+        for (int i = 0; i < halide_telemetry_num_buckets; i++) {
+            p->latency[i] = 0;
+        }
+    }
+}
+
+}
@@ -35,6 +35,14 @@ extern WIN32API void EnterCriticalSection(CriticalSection *);
 extern WIN32API void LeaveCriticalSection(CriticalSection *);
 extern WIN32API int32_t WaitForSingleObject(Thread, int32_t timeout);
 extern WIN32API bool InitOnceExecuteOnce(InitOnce *, bool WIN32API (*f)(InitOnce *, void *, void **), void *, void **);
+extern WIN32API bool CloseHandle(Thread);
+
+// Slim reader/writer locks need no cleanup, unlike critical sections.
+typedef void * SRWLock;
+extern WIN32API void InitializeSRWLock(SRWLock *);
+extern WIN32API void AcquireSRWLockExclusive(SRWLock *);
+extern WIN32API void ReleaseSRWLockExclusive(SRWLock *);
+extern WIN32API bool SleepConditionVariableSRW(ConditionVariable *, SRWLock *, int32_t, uint32_t);
 
 WEAK int halide_do_task(void *user_context, halide_task_t f, int idx,
                         uint8_t *closure);
@@ -311,6 +319,49 @@ WEAK void *halide_spawn_thread_helper(void *arg) {
     return NULL;
 }
 
+// The layout of a halide_semaphore_t.
+struct windows_semaphore {
+    SRWLock lock;
+    ConditionVariable cond;
+    int count;
+    bool cancelled;
+};
+
+// The tasks of a halide_do_async wait on this before they start, so
+// that if a thread can't be created, none of them run (the others
+// could wait forever on the missing one).
+struct async_start_gate {
+    SRWLock lock;
+    ConditionVariable cond;
+    // Zero while the threads are being created, then positive if they
+    // all were, or negative if one couldn't be.
+    int state;
+};
+
+struct async_task {
+    Thread thread;
+    async_start_gate *gate;
+    halide_task_t f;
+    void *user_context;
+    int idx;
+    uint8_t *closure;
+    int exit_status;
+};
+WEAK void *halide_async_task_helper(void *arg) {
+    async_task *t = (async_task *)arg;
+    async_start_gate *gate = t->gate;
+    AcquireSRWLockExclusive(&gate->lock);
+    while (gate->state == 0) {
+        SleepConditionVariableSRW(&gate->cond, &gate->lock, -1, 0);
+    }
+    bool start = gate->state > 0;
+    ReleaseSRWLockExclusive(&gate->lock);
+    if (start) {
+        t->exit_status = halide_do_task(t->user_context, t->f, t->idx, t->closure);
+    }
+    return NULL;
+}
+
 }}} // namespace Halide::Runtime::Internal
 
 extern "C" {
@@ -322,6 +373,108 @@ WEAK void halide_spawn_thread(void *user_context, void(*f)(void *), void *closur
         CreateThread(NULL, 0, halide_spawn_thread_helper, t, 0, NULL);
 }
 
+WEAK int halide_do_async(void *user_context, halide_task_t f,
+                         int min, int size, uint8_t *closure) {
+    if (size <= 0) {
+        return 0;
+    }
+
+    // The tasks may block waiting on each other, so they can't share
+    // the thread pool. Every task but the last gets a new thread.
+    async_task *tasks = (async_task *)malloc(sizeof(async_task) * (size - 1));
+    if (size > 1 && !tasks) {
+        return halide_error_out_of_memory(user_context);
+    }
+    async_start_gate gate;
+    InitializeSRWLock(&gate.lock);
+    InitializeConditionVariable(&gate.cond);
+    gate.state = 0;
+    int threads = 0;
+    for (int i = 0; i < size - 1; i++) {
+        tasks[i].gate = &gate;
+        tasks[i].f = f;
+        tasks[i].user_context = user_context;
+        tasks[i].idx = min + i;
+        tasks[i].closure = closure;
+        tasks[i].exit_status = 0;
+        tasks[i].thread = CreateThread(NULL, 0, halide_async_task_helper, tasks + i, 0, NULL);
+        if (!tasks[i].thread) {
+            break;
+        }
+        threads++;
+    }
+
+    AcquireSRWLockExclusive(&gate.lock);
+    gate.state = (threads == size - 1) ? 1 : -1;
+    ReleaseSRWLockExclusive(&gate.lock);
+    WakeAllConditionVariable(&gate.cond);
+
+    int result;
+    if (gate.state > 0) {
+        result = halide_do_task(user_context, f, min + size - 1, closure);
+    } else {
+        halide_error(user_context, "halide_do_async couldn't create a thread\n");
+        result = halide_error_code_generic_error;
+    }
+
+    for (int i = 0; i < threads; i++) {
+        WaitForSingleObject(tasks[i].thread, -1);
+        CloseHandle(tasks[i].thread);
+        // A task that fails causes the others to fail with a generic
+        // error when they next acquire a semaphore. Report the
+        // original error in preference.
+        int status = tasks[i].exit_status;
+        if (status && (result == 0 || result == halide_error_code_generic_error)) {
+            result = status;
+        }
+    }
+    free(tasks);
+
+    return result;
+}
+
+WEAK int halide_semaphore_init(halide_semaphore_t *sem_arg, int count) {
+    windows_semaphore *sem = (windows_semaphore *)sem_arg;
+    InitializeSRWLock(&sem->lock);
+    InitializeConditionVariable(&sem->cond);
+    sem->count = count;
+    sem->cancelled = false;
+    return 0;
+}
+
+WEAK int halide_semaphore_release(halide_semaphore_t *sem_arg, int n) {
+    windows_semaphore *sem = (windows_semaphore *)sem_arg;
+    AcquireSRWLockExclusive(&sem->lock);
+    sem->count += n;
+    ReleaseSRWLockExclusive(&sem->lock);
+    WakeAllConditionVariable(&sem->cond);
+    return 0;
+}
+
+WEAK int halide_semaphore_acquire(halide_semaphore_t *sem_arg, int n) {
+    windows_semaphore *sem = (windows_semaphore *)sem_arg;
+    int result = 0;
+    AcquireSRWLockExclusive(&sem->lock);
+    while (sem->count < n && !sem->cancelled) {
+        SleepConditionVariableSRW(&sem->cond, &sem->lock, -1, 0);
+    }
+    if (sem->count >= n) {
+        sem->count -= n;
+    } else {
+        result = halide_error_code_generic_error;
+    }
+    ReleaseSRWLockExclusive(&sem->lock);
+    return result;
+}
+
+WEAK void halide_semaphore_cancel(void *user_context, void *sem_arg) {
+    windows_semaphore *sem = (windows_semaphore *)sem_arg;
+    AcquireSRWLockExclusive(&sem->lock);
+    sem->cancelled = true;
+    ReleaseSRWLockExclusive(&sem->lock);
+    WakeAllConditionVariable(&sem->cond);
+}
+
 WEAK void halide_mutex_cleanup(halide_mutex *mutex_arg) {
     windows_mutex *mutex = (windows_mutex *)mutex_arg;
     if (mutex->once != 0) {
@@ -1,9 +1,13 @@
 #include "runtime_internal.h"
 #include "HalideRuntime.h"
+#include "printer.h"
 
 extern "C" void *fopen(const char *, const char *);
 extern "C" int fclose(void *);
 extern "C" size_t fwrite(const void *, size_t, size_t, void *);
+extern "C" int fseek(void *, long, int);
+
+#define SEEK_SET 0
 
 // Use TIFF because it meets the following criteria:
 // - Supports uncompressed data
@@ -15,6 +19,12 @@ extern "C" size_t fwrite(const void *, size_t, size_t, void *);
 //
 // It would be nice to use a format that web browsers read and display
 // directly, but those formats don't tend to satisfy the above goals.
+//
+// Dumping large intermediates can be made cheap for the pipeline by
+// writing asynchronously: the data is copied and written by a
+// background thread. TIFF files can also be compressed with LZW,
+// after a predictor (TIFF predictor 2 for integers, 3 for floats) that
+// turns smooth data into repeated small values.
 
 namespace Halide { namespace Runtime { namespace Internal {
 
@@ -68,7 +78,7 @@ struct halide_tiff_header {
     int16_t version;
     int32_t ifd0_offset;
     int16_t entry_count;
-    tiff_tag entries[15];
+    tiff_tag entries[16];
     int32_t ifd0_end;
     int32_t width_resolution[2];
     int32_t height_resolution[2];
@@ -102,33 +112,236 @@ WEAK bool has_tiff_extension(const char *filename) {
     return *f == '\0';
 }
 
-}}} // namespace Halide::Runtime::Internal
+// Replace each sample in a row with its difference from the previous
+// sample (TIFF predictor 2).
+template<typename T>
+__attribute__((always_inline)) void horizontal_difference(T *row, int32_t width) {
+    for (int32_t i = width - 1; i > 0; i--) {
+        row[i] -= row[i - 1];
+    }
+}
+
+// Apply the TIFF predictor for the given type to a row of
+// samples. Floats (predictor 3) are split into byte planes, most
+// significant first, before differencing bytes. Writes the result to
+// dst.
+WEAK void predict_row(const uint8_t *src, uint8_t *dst, int32_t width,
+                      int32_t type_code, int32_t bytes_per_element) {
+    if (type_code <= 1) {
+        int32_t one = 1;
+        bool little_endian = *(const uint8_t *)&one == 1;
+        for (int32_t b = 0; b < bytes_per_element; b++) {
+            int32_t src_byte = little_endian ? bytes_per_element - 1 - b : b;
+            uint8_t *plane = dst + b * width;
+            for (int32_t i = 0; i < width; i++) {
+                plane[i] = src[i * bytes_per_element + src_byte];
+            }
+        }
+        horizontal_difference(dst, width * bytes_per_element);
+        return;
+    }
+
+    memcpy(dst, src, width * bytes_per_element);
+    switch (bytes_per_element) {
+    case 1:
+        horizontal_difference((uint8_t *)dst, width);
+        break;
+    case 2:
+        horizontal_difference((uint16_t *)dst, width);
+        break;
+    case 4:
+        horizontal_difference((uint32_t *)dst, width);
+        break;
+    case 8:
+        horizontal_difference((uint64_t *)dst, width);
+        break;
+    }
+}
+
+// TIFF LZW compression, as described in the TIFF 6.0 spec: variable
+// width codes from 9 to 12 bits, packed most significant bit first,
+// with each strip starting with a clear code.
+#define lzw_clear_code 256
+#define lzw_eoi_code 257
+#define lzw_first_code 258
+#define lzw_max_code 4095
+#define lzw_hash_bits 13
+#define lzw_hash_size (1 << lzw_hash_bits)
+
+struct lzw_writer {
+    void *f;
+    bool failed;
+    // The number of bytes written to the file so far.
+    size_t bytes_written;
+
+    // Bits waiting to be written, right-aligned.
+    uint32_t bits;
+    int num_bits;
+    int code_bits;
+    int next_code;
+    // The code for the string matched so far, or -1 if there is none.
+    int prefix;
+
+    // The string table, as a hash table from (prefix << 8) | byte to
+    // code. Empty slots have key -1.
+    int32_t keys[lzw_hash_size];
+    int16_t codes[lzw_hash_size];
+
+    size_t out_size;
+    uint8_t out[1 << 16];
+};
+
+WEAK void lzw_flush(lzw_writer *w) {
+    if (w->out_size && !w->failed) {
+        if (!fwrite((void *)w->out, w->out_size, 1, w->f)) {
+            w->failed = true;
+        }
+    }
+    w->bytes_written += w->out_size;
+    w->out_size = 0;
+}
+
+WEAK void lzw_put_code(lzw_writer *w, int code) {
+    w->bits = (w->bits << w->code_bits) | code;
+    w->num_bits += w->code_bits;
+    while (w->num_bits >= 8) {
+        w->num_bits -= 8;
+        w->out[w->out_size++] = (uint8_t)(w->bits >> w->num_bits);
+        if (w->out_size == sizeof(w->out)) {
+            lzw_flush(w);
+        }
+    }
+}
+
+WEAK void lzw_reset_table(lzw_writer *w) {
+    memset(w->keys, 0xff, sizeof(w->keys));
+    w->next_code = lzw_first_code;
+    w->code_bits = 9;
+}
 
-WEAK extern "C" int32_t halide_debug_to_file(void *user_context, const char *filename, uint8_t *data,
-                                             int32_t s0, int32_t s1, int32_t s2, int32_t s3,
-                                             int32_t type_code, int32_t bytes_per_element) {
+// Account for a new entry in the string table, which the decoder
+// mirrors. The code width grows once the next code wouldn't fit,
+// and the table restarts before it overflows.
+WEAK void lzw_next_code(lzw_writer *w) {
+    w->next_code++;
+    if (w->next_code == lzw_max_code - 1) {
+        lzw_put_code(w, lzw_clear_code);
+        lzw_reset_table(w);
+    } else if (w->next_code > (1 << w->code_bits) - 1) {
+        w->code_bits++;
+    }
+}
+
+WEAK void lzw_begin_strip(lzw_writer *w) {
+    w->bytes_written = 0;
+    w->bits = 0;
+    w->num_bits = 0;
+    w->code_bits = 9;
+    w->prefix = -1;
+    lzw_put_code(w, lzw_clear_code);
+    lzw_reset_table(w);
+}
+
+WEAK void lzw_compress(lzw_writer *w, const uint8_t *src, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int c = src[i];
+        if (w->prefix < 0) {
+            w->prefix = c;
+            continue;
+        }
+        int32_t key = (w->prefix << 8) | c;
+        uint32_t h = ((uint32_t)key * 2654435761U) >> (32 - lzw_hash_bits);
+        while (w->keys[h] != -1 && w->keys[h] != key) {
+            h = (h + 1) & (lzw_hash_size - 1);
+        }
+        if (w->keys[h] == key) {
+            // Keep extending the match.
+            w->prefix = w->codes[h];
+            continue;
+        }
+        lzw_put_code(w, w->prefix);
+        w->keys[h] = key;
+        w->codes[h] = (int16_t)w->next_code;
+        lzw_next_code(w);
+        w->prefix = c;
+    }
+}
+
+// Finish the strip. Returns the size of the compressed strip.
+WEAK size_t lzw_end_strip(lzw_writer *w) {
+    if (w->prefix >= 0) {
+        lzw_put_code(w, w->prefix);
+        lzw_next_code(w);
+    }
+    lzw_put_code(w, lzw_eoi_code);
+    if (w->num_bits) {
+        w->out[w->out_size++] = (uint8_t)(w->bits << (8 - w->num_bits));
+        w->num_bits = 0;
+    }
+    lzw_flush(w);
+    return w->bytes_written;
+}
+
+WEAK int32_t write_debug_image(const char *filename, const uint8_t *data,
+                               int32_t s0, int32_t s1, int32_t s2, int32_t s3,
+                               int32_t type_code, int32_t bytes_per_element,
+                               bool compress) {
     void *f = fopen(filename, "wb");
     if (!f) return -1;
 
     size_t elts = s0;
     elts *= s1*s2*s3;
 
-    if (has_tiff_extension(filename)) {
-        int32_t channels;
-        int32_t width = s0;
-        int32_t height = s1;
-        int32_t depth;
-
-        if ((s3 == 0 || s3 == 1) && (s2 < 5)) {
-            channels = s2;
-            depth = 1;
-        } else {
-            channels = s3;
-            depth = s2;
+    if (!has_tiff_extension(filename)) {
+        int32_t header[] = {s0, s1, s2, s3, type_code};
+        if (!fwrite((void *)(&header[0]), sizeof(header), 1, f)) {
+            fclose(f);
+            return -2;
+        }
+        if (!fwrite((void *)data, bytes_per_element * elts, 1, f)) {
+            fclose(f);
+            return -1;
         }
+        fclose(f);
+        return 0;
+    }
+
+    int32_t channels;
+    int32_t width = s0;
+    int32_t height = s1;
+    int32_t depth;
+
+    if ((s3 == 0 || s3 == 1) && (s2 < 5)) {
+        channels = s2;
+        depth = 1;
+    } else {
+        channels = s3;
+        depth = s2;
+    }
 
-        struct halide_tiff_header header;
+    // Each channel is stored as one strip of rows.
+    int32_t rows = height * depth;
+    size_t row_bytes = (size_t)width * bytes_per_element;
+    size_t strip_bytes = row_bytes * rows;
 
+    // The offset and size of each strip. Compressed strips are
+    // measured as they are written, and the header rewritten at the
+    // end.
+    int32_t *strip_offsets = (int32_t *)malloc(channels * sizeof(int32_t) * 2);
+    if (!strip_offsets) {
+        fclose(f);
+        return -2;
+    }
+    int32_t *strip_byte_counts = strip_offsets + channels;
+    int32_t data_offset = sizeof(halide_tiff_header) + (channels > 1 ? channels * sizeof(int32_t) * 2 : 0);
+    for (int32_t i = 0; i < channels; i++) {
+        strip_offsets[i] = data_offset + i * strip_bytes;
+        strip_byte_counts[i] = strip_bytes;  // bug if 32-bit truncation
+    }
+
+    struct halide_tiff_header header;
+    int32_t result = 0;
+    for (int pass = 0; pass < 2 && result == 0; pass++) {
         int32_t MMII = 0x4d4d4949;
         // Select the appropriate two bytes signaling byte order automatically
         const char *c = (const char *)&MMII;
@@ -142,22 +355,27 @@ WEAK extern "C" int32_t halide_debug_to_file(void *user_context, const char *fil
         tag++->assign32(256, 1, width);                             // Image width
         tag++->assign32(257, 1, height);                         // Image height
         tag++->assign16(258, 1, int16_t(bytes_per_element * 8)); // Bits per sample
-        tag++->assign16(259, 1, 1);                              // Compression -- none
+        tag++->assign16(259, 1, compress ? 5 : 1);               // Compression -- LZW or none
         tag++->assign16(262, 1, channels >= 3 ? 2 : 1);          // PhotometricInterpretation -- black is zero or RGB
-        tag++->assign32(273, channels, sizeof(header));          // Rows per strip
+        tag++->assign32(273, channels,
+                        (channels == 1) ?
+                            strip_offsets[0] :
+                            sizeof(header));                     // Strip offsets
         tag++->assign16(277, 1, int16_t(channels));              // Samples per pixel
         tag++->assign32(278, 1, s1);                             // Rows per strip
         tag++->assign32(279, channels,
                         (channels == 1) ?
-                            elts * bytes_per_element :
+                            strip_byte_counts[0] :
                             sizeof(header) +
-                                channels * sizeof(int32_t));     // strip byte counts, bug if 32-bit truncation
+                                channels * sizeof(int32_t));     // Strip byte counts
         tag++->assign32(282, 5, 1,
                         __builtin_offsetof(halide_tiff_header, width_resolution));     // Width resolution
         tag++->assign32(283, 5, 1,
                         __builtin_offsetof(halide_tiff_header, height_resolution));    // Height resolution
         tag++->assign16(284, 1, 2);                              // Planar configuration -- planar
         tag++->assign16(296, 1, 1);                              // Resolution Unit -- none
+        tag++->assign16(317, 1,
+                        !compress ? 1 : type_code <= 1 ? 3 : 2); // Predictor -- none, horizontal differencing, or floating point
         tag++->assign16(339, 1,
                         pixel_type_to_tiff_sample_type[type_code]);        // Sample type
         tag++->assign32(32997, 1, depth);                        // Image depth
@@ -168,42 +386,251 @@ WEAK extern "C" int32_t halide_debug_to_file(void *user_context, const char *fil
         header.height_resolution[0] = 1;
         header.height_resolution[1] = 1;
 
+        if (pass == 1 && fseek(f, 0, SEEK_SET)) {
+            result = -2;
+            break;
+        }
+
         if (!fwrite((void *)(&header), sizeof(header), 1, f)) {
-            fclose(f);
-            return -2;
+            result = -2;
+            break;
         }
 
-        if (channels > 1) {
-          int32_t offset = sizeof(header) + channels * sizeof(int32_t) * 2;
-
-          for (int32_t i = 0; i < channels; i++) {
-              if (!fwrite((void*)(&offset), 4, 1, f)) {
-                  fclose(f);
-                  return -2;
-              }
-              offset += s0 * s1 * depth * bytes_per_element;
-          }
-          int32_t count = s0 * s1 * depth;
-          for (int32_t i = 0; i < channels; i++) {
-              if (!fwrite((void*)(&count), 4, 1, f)) {
-                  fclose(f);
-                  return -2;
-              }
-          }
+        if (channels > 1 &&
+            !fwrite((void *)strip_offsets, channels * sizeof(int32_t) * 2, 1, f)) {
+            result = -2;
+            break;
         }
-    } else {
-        int32_t header[] = {s0, s1, s2, s3, type_code};
-        if (!fwrite((void *)(&header[0]), sizeof(header), 1, f)) {
-            fclose(f);
-            return -2;
+
+        if (pass == 1) {
+            break;
         }
+
+        if (!compress) {
+            if (!fwrite((void *)data, strip_bytes * channels, 1, f)) {
+                result = -1;
+            }
+            // The header is already correct.
+            break;
+        }
+
+        lzw_writer *w = (lzw_writer *)malloc(sizeof(lzw_writer) + row_bytes);
+        if (!w) {
+            result = -2;
+            break;
+        }
+        uint8_t *row = (uint8_t *)(w + 1);
+        w->f = f;
+        w->failed = false;
+        w->out_size = 0;
+        int32_t offset = data_offset;
+        for (int32_t i = 0; i < channels; i++) {
+            const uint8_t *src = data + i * strip_bytes;
+            lzw_begin_strip(w);
+            for (int32_t y = 0; y < rows; y++) {
+                predict_row(src + y * row_bytes, row, width, type_code, bytes_per_element);
+                lzw_compress(w, row, row_bytes);
+            }
+            strip_offsets[i] = offset;
+            strip_byte_counts[i] = lzw_end_strip(w);
+            offset += strip_byte_counts[i];
+        }
+        if (w->failed) {
+            result = -1;
+        }
+        free(w);
     }
 
-    if (fwrite((void *)data, bytes_per_element * elts, 1, f)) {
-        fclose(f);
-        return 0;
+    free(strip_offsets);
+    fclose(f);
+    return result;
+}
+
+// A call to halide_debug_to_file waiting to be written by the
+// background thread.
+struct debug_image_job {
+    // A debug_image_job *
+    void *next;
+    char *filename;
+    uint8_t *data;
+    int32_t s0, s1, s2, s3;
+    int32_t type_code, bytes_per_element;
+    bool compress;
+    size_t bytes;
+};
+
+// Whether writes are asynchronous and compressed. -1 means not set
+// yet, in which case the environment is checked.
+WEAK int debug_file_async = -1;
+WEAK int debug_file_compress = -1;
+
+// Asynchronous writes wait for earlier ones to finish rather than
+// hold more than this much data in memory.
+WEAK size_t debug_file_max_pending_bytes = (size_t)1 << 30;
+
+// Guards everything below.
+WEAK halide_mutex debug_file_lock = {{0}};
+WEAK debug_image_job *debug_file_queue_head = NULL;
+WEAK debug_image_job *debug_file_queue_tail = NULL;
+WEAK bool debug_file_writer_running = false;
+WEAK size_t debug_file_pending_bytes = 0;
+WEAK int debug_file_failures = 0;
+
+WEAK bool env_flag_set(const char *name) {
+    const char *value = getenv(name);
+    return value && atoi(value);
+}
+
+// Writes every queued job in order, then exits. Started whenever a
+// job is queued and the writer isn't running.
+WEAK void debug_file_writer(void *) {
+    while (1) {
+        halide_mutex_lock(&debug_file_lock);
+        debug_image_job *job = debug_file_queue_head;
+        if (!job) {
+            debug_file_writer_running = false;
+            halide_mutex_unlock(&debug_file_lock);
+            return;
+        }
+        debug_file_queue_head = (debug_image_job *)(job->next);
+        if (!debug_file_queue_head) {
+            // The job is about to be freed, so jobs queued while it's
+            // being written must start a new list rather than be
+            // appended to it.
+            debug_file_queue_tail = NULL;
+        }
+        halide_mutex_unlock(&debug_file_lock);
+
+        int32_t result = write_debug_image(job->filename, job->data,
+                                           job->s0, job->s1, job->s2, job->s3,
+                                           job->type_code, job->bytes_per_element,
+                                           job->compress);
+        if (result) {
+            // There's no pipeline to return the error to. Report it
+            // now, and from the next flush.
+            char buf[1024];
+            Printer<StringStreamPrinter, sizeof(buf)> sstr(NULL, buf);
+            sstr << "Failed to write " << job->filename << " asynchronously (" << result << ")\n";
+            halide_print(NULL, sstr.str());
+        }
+
+        halide_mutex_lock(&debug_file_lock);
+        debug_file_pending_bytes -= job->bytes;
+        if (result) debug_file_failures++;
+        halide_mutex_unlock(&debug_file_lock);
+        free(job);
+    }
+}
+
+// Wait until at most the given number of bytes are waiting to be
+// written. Zero waits for the writer to finish completely.
+WEAK void wait_for_debug_file_writer(size_t max_pending_bytes) {
+    while (1) {
+        halide_mutex_lock(&debug_file_lock);
+        bool done = (max_pending_bytes == 0) ?
+            !debug_file_writer_running :
+            debug_file_pending_bytes <= max_pending_bytes;
+        halide_mutex_unlock(&debug_file_lock);
+        if (done) return;
+        halide_sleep_ms(NULL, 1);
+    }
+}
+
+}}} // namespace Halide::Runtime::Internal
+
+extern "C" {
+
+WEAK int32_t halide_debug_to_file(void *user_context, const char *filename, uint8_t *data,
+                                  int32_t s0, int32_t s1, int32_t s2, int32_t s3,
+                                  int32_t type_code, int32_t bytes_per_element) {
+    if (debug_file_async < 0) {
+        debug_file_async = env_flag_set("HL_DEBUG_TO_FILE_ASYNC");
+    }
+    if (debug_file_compress < 0) {
+        debug_file_compress = env_flag_set("HL_DEBUG_TO_FILE_COMPRESS");
+    }
+
+    if (!debug_file_async) {
+        return write_debug_image(filename, data, s0, s1, s2, s3,
+                                 type_code, bytes_per_element, debug_file_compress);
+    }
+
+    size_t bytes = s0;
+    bytes *= s1*s2*s3;
+    bytes *= bytes_per_element;
+
+    // Don't let the writer fall too far behind.
+    if (bytes < debug_file_max_pending_bytes) {
+        wait_for_debug_file_writer(debug_file_max_pending_bytes - bytes);
     } else {
-        fclose(f);
-        return -1;
+        wait_for_debug_file_writer(0);
     }
+
+    size_t name_len = strlen(filename) + 1;
+    debug_image_job *job = (debug_image_job *)malloc(sizeof(debug_image_job) + bytes + name_len);
+    if (!job) {
+        // Write it now instead.
+        return write_debug_image(filename, data, s0, s1, s2, s3,
+                                 type_code, bytes_per_element, debug_file_compress);
+    }
+    job->next = NULL;
+    job->data = (uint8_t *)(job + 1);
+    job->filename = (char *)(job->data + bytes);
+    memcpy(job->data, data, bytes);
+    memcpy(job->filename, filename, name_len);
+    job->s0 = s0;
+    job->s1 = s1;
+    job->s2 = s2;
+    job->s3 = s3;
+    job->type_code = type_code;
+    job->bytes_per_element = bytes_per_element;
+    job->compress = debug_file_compress;
+    job->bytes = bytes;
+
+    halide_mutex_lock(&debug_file_lock);
+    if (debug_file_queue_tail) {
+        debug_file_queue_tail->next = job;
+    } else {
+        debug_file_queue_head = job;
+    }
+    debug_file_queue_tail = job;
+    debug_file_pending_bytes += bytes;
+    bool start_writer = !debug_file_writer_running;
+    debug_file_writer_running = true;
+    halide_mutex_unlock(&debug_file_lock);
+
+    if (start_writer) {
+        halide_spawn_thread(user_context, debug_file_writer, NULL);
+    }
+    return 0;
+}
+
+WEAK void halide_debug_to_file_set_async(bool async) {
+    if (!async && debug_file_async > 0) {
+        wait_for_debug_file_writer(0);
+    }
+    debug_file_async = async;
+}
+
+WEAK void halide_debug_to_file_set_compression(bool compress) {
+    debug_file_compress = compress;
+}
+
+WEAK int halide_debug_to_file_flush(void *user_context) {
+    wait_for_debug_file_writer(0);
+    halide_mutex_lock(&debug_file_lock);
+    int failures = debug_file_failures;
+    debug_file_failures = 0;
+    halide_mutex_unlock(&debug_file_lock);
+    return failures ? halide_error_code_debug_to_file_failed : 0;
+}
+
+}
+
+namespace {
+__attribute__((destructor))
+WEAK void halide_debug_to_file_shutdown() {
+    // Finish writing any files still queued.
+    wait_for_debug_file_writer(0);
+}
 }
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x, y;
+
+    {
+        // An async producer sliding along the consumer's loop over y.
+        Func f, g;
+        f(x, y) = x + y * 3;
+        g(x, y) = f(x, y-1) + f(x, y+1);
+
+        f.store_root().compute_at(g, y).async();
+
+        Image<int> im = g.realize(64, 64);
+
+        for (int y = 0; y < 64; y++) {
+            for (int x = 0; x < 64; x++) {
+                int correct = 2 * x + 6 * y;
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // A chain of async producers, where the consumer of one is the
+        // producer of the next.
+        Func f, g, h;
+        f(x, y) = x * y;
+        g(x, y) = f(x, y-1) + f(x, y+1) + 1;
+        h(x, y) = g(x, y) * 2 + g(x, y+2);
+
+        f.store_root().compute_at(g, y).async();
+        g.store_root().compute_at(h, y).async();
+
+        Image<int> im = h.realize(32, 100);
+
+        for (int y = 0; y < 100; y++) {
+            for (int x = 0; x < 32; x++) {
+                int g0 = x * (y - 1) + x * (y + 1) + 1;
+                int g2 = x * (y + 1) + x * (y + 3) + 1;
+                int correct = g0 * 2 + g2;
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    const int W = 300, H = 200;
+
+    Image<uint16_t> in(W + 2, H + 2);
+    for (int y = 0; y < in.height(); y++) {
+        for (int x = 0; x < in.width(); x++) {
+            in(x, y) = (uint16_t)((x * 17 + y * 31) & 0xfff);
+        }
+    }
+
+    Var x("x"), y("y");
+    ImageParam input(UInt(16), 2);
+
+    // A blur followed by a pointwise operation and a histogram of the
+    // result, plus a scalar reduction that counts bright pixels.
+    Func blur_x("blur_x"), blur_y("blur_y"), out("out"), hist("hist"), total("total");
+    Func bright("bright");
+    blur_x(x, y) = (input(x, y) + input(x+1, y) + input(x+2, y)) / 3;
+    blur_y(x, y) = (blur_x(x, y) + blur_x(x, y+1) + blur_x(x, y+2)) / 3;
+    out(x, y) = blur_y(x, y) + 1;
+
+    RDom r(0, W, 0, H);
+    hist(x) = 0;
+    hist(clamp(cast<int>(out(r.x, r.y)) / 64, 0, 63)) += 1;
+    bright() = sum(select(out(r.x, r.y) > 2000, 1, 0));
+    total(x) = hist(x) * 2 + bright();
+
+    out.estimate(x, 0, W).estimate(y, 0, H);
+    total.estimate(x, 0, 64);
+
+    Pipeline p({out, total});
+    std::string schedule = p.auto_schedule(get_jit_target_from_environment());
+    printf("%s", schedule.c_str());
+
+    if (schedule.empty()) {
+        printf("The auto scheduler didn't schedule anything\n");
+        return -1;
+    }
+
+    input.set(in);
+    Image<uint16_t> out_result(W, H);
+    Image<int> total_result(64);
+    p.realize(Realization(out_result, total_result));
+
+    int correct_hist[64] = {0};
+    int correct_bright = 0;
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            int sum = 0;
+            for (int dy = 0; dy < 3; dy++) {
+                sum += (in(x, y + dy) + in(x + 1, y + dy) + in(x + 2, y + dy)) / 3;
+            }
+            uint16_t correct = (uint16_t)(sum / 3 + 1);
+            if (out_result(x, y) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out_result(x, y), correct);
+                return -1;
+            }
+            int bucket = std::min(std::max(correct / 64, 0), 63);
+            correct_hist[bucket]++;
+            if (correct > 2000) correct_bright++;
+        }
+    }
+
+    for (int i = 0; i < 64; i++) {
+        int correct = correct_hist[i] * 2 + correct_bright;
+        if (total_result(i) != correct) {
+            printf("total(%d) = %d instead of %d\n", i, total_result(i), correct);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include "Halide.h"
 #include <stdio.h>
+#include <stdlib.h>
 #ifndef _MSC_VER
+#include <dlfcn.h>
 #include <unistd.h>
 #endif
 
@@ -42,7 +44,97 @@ void testCompileToOutputAndAssembly(Func j) {
     #endif
 }
 
+template<typename T>
+bool check_same(const Image<T> &im, const Image<T> &ref) {
+    for (int y = 0; y < im.height(); y++) {
+        for (int x = 0; x < im.width(); x++) {
+            if (im(x, y) != ref(x, y)) {
+                printf("im(%d, %d) = %f instead of %f\n", x, y, (double)im(x, y), (double)ref(x, y));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Link an object file into a shared library, load it, and run the
+// named 2D pipeline with no inputs, comparing the result to
+// jit-compiling the Func directly.
+template<typename T>
+bool run_object_and_compare(const char *fn_object, const char *name, Func f) {
+    #ifdef _MSC_VER
+    return true;
+    #else
+    std::string fn_library = std::string(fn_object) + ".so";
+    std::string cmd = "c++ -shared -o " + fn_library + " " + fn_object + " -lpthread";
+    #ifdef __linux__
+    cmd += " -ldl";
+    #endif
+    if (system(cmd.c_str()) != 0) {
+        printf("Could not link %s into a shared library. Skipping running it.\n", fn_object);
+        return true;
+    }
+    void *lib = dlopen(("./" + fn_library).c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!lib) {
+        printf("Could not load %s: %s\n", fn_library.c_str(), dlerror());
+        return false;
+    }
+    int (*fn)(buffer_t *) = (int (*)(buffer_t *))dlsym(lib, name);
+    if (!fn) {
+        printf("%s does not define %s\n", fn_library.c_str(), name);
+        return false;
+    }
+
+    Image<T> out(32, 16);
+    if (fn(out.raw_buffer()) != 0) {
+        printf("%s returned an error\n", name);
+        return false;
+    }
+    Image<T> ref = f.realize(32, 16);
+    bool same = check_same(out, ref);
+    dlclose(lib);
+    return same;
+    #endif
+}
+
+void testCompileLinkedModules(Func a, Func b) {
+    const char *fn_object = "compile_to_linked.o";
+    const char *fn_assembly = "compile_to_linked.s";
+
+    #ifndef _MSC_VER
+    if (access(fn_object, F_OK) == 0) { unlink(fn_object); }
+    if (access(fn_assembly, F_OK) == 0) { unlink(fn_assembly); }
+    #endif
+
+    // The two pipelines are independent, so they may be compiled in
+    // parallel and then linked into one object.
+    std::vector<Argument> empty_args;
+    Module linked = link_modules("compile_to_linked",
+                                 {a.compile_to_module(empty_args, "linked_a"),
+                                  b.compile_to_module(empty_args, "linked_b")});
+    compile_module_to_native(linked, fn_object, fn_assembly);
+
+    #ifndef _MSC_VER
+    assert(access(fn_object, F_OK) == 0 && "Output file not created.");
+    assert(access(fn_assembly, F_OK) == 0 && "Assembly file not created.");
+    #endif
+
+    // The code from the split compile must compute the same thing as
+    // compiling each pipeline as a single module.
+    if (!run_object_and_compare<float>(fn_object, "linked_a", a) ||
+        !run_object_and_compare<int>(fn_object, "linked_b", b)) {
+        printf("Output of the separately compiled parts differs\n");
+        exit(-1);
+    }
+}
+
 int main(int argc, char **argv) {
+    // Make sure independent parts of a module are compiled on
+    // separate threads, even on a single core.
+    #ifndef _MSC_VER
+    setenv("HL_COMPILE_THREADS", "2", 1);
+    #endif
+
     Func f, g, h, j;
     Var x, y;
     f(x, y) = x + y;
@@ -58,6 +150,10 @@ int main(int argc, char **argv) {
 
     testCompileToOutputAndAssembly(j);
 
+    Func k;
+    k(x, y) = f(x, y) * 3;
+    testCompileLinkedModules(j, k);
+
     printf("Success!\n");
     return 0;
 }
@@ -0,0 +1,94 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+int last_row = 0;
+bool rows_in_order = true;
+
+// An extern function that checks that the rows of the outputs are
+// computed in an interleaved order.
+extern "C" DLLEXPORT int visit_row(int y) {
+    if (y < last_row) {
+        rows_in_order = false;
+    }
+    last_row = y;
+    return 0;
+}
+HalideExtern_1(int, visit_row, int);
+
+int main(int argc, char **argv) {
+    Var x, y;
+
+    {
+        // Two outputs of a pipeline that read the same producer over
+        // different ranges, fused at y.
+        Func f, g, h;
+        f(x, y) = x + y;
+        g(x, y) = f(x, y) * 2 + visit_row(y);
+        h(x, y) = f(x, y + 1) - 1 + visit_row(y);
+
+        f.compute_root();
+        h.compute_with(g, y);
+
+        Pipeline p({g, h});
+        Image<int> g_out(32, 16), h_out(32, 8);
+        p.realize(Realization(g_out, h_out));
+
+        for (int y = 0; y < g_out.height(); y++) {
+            for (int x = 0; x < g_out.width(); x++) {
+                if (g_out(x, y) != (x + y) * 2) {
+                    printf("g(%d, %d) = %d instead of %d\n", x, y, g_out(x, y), (x + y) * 2);
+                    return -1;
+                }
+            }
+        }
+        for (int y = 0; y < h_out.height(); y++) {
+            for (int x = 0; x < h_out.width(); x++) {
+                if (h_out(x, y) != x + y) {
+                    printf("h(%d, %d) = %d instead of %d\n", x, y, h_out(x, y), x + y);
+                    return -1;
+                }
+            }
+        }
+
+        // Without fusion, all of g would be computed before h.
+        if (!rows_in_order) {
+            printf("The rows of g and h were not computed in an interleaved order\n");
+            return -1;
+        }
+    }
+
+    {
+        // Two intermediates consumed by a common output, fused at x
+        // inside a parallel loop over y.
+        Func f, g, out;
+        f(x, y) = x * y;
+        g(x, y) = x + y;
+        out(x, y) = f(x - 1, y) + g(x + 1, y);
+
+        f.compute_root().parallel(y);
+        g.compute_root().parallel(y);
+        g.compute_with(f, x);
+
+        Image<int> result = out.realize(64, 64);
+        for (int y = 0; y < result.height(); y++) {
+            for (int x = 0; x < result.width(); x++) {
+                int correct = (x - 1) * y + (x + 1 + y);
+                if (result(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, result(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
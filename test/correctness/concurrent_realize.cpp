@@ -0,0 +1,71 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <thread>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x, y;
+    Param<int> offset;
+    ImageParam input(Int(32), 2);
+
+    Func f;
+    f(x, y) = input(x, y) * 2 + offset;
+    f.vectorize(x, 4).parallel(y);
+
+    Pipeline p(f);
+
+    const int threads = 8;
+    const int iters = 50;
+    std::vector<int> failures(threads, 0);
+
+    // Many threads realize the same pipeline at once, each with its
+    // own inputs, param values, and outputs.
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(std::thread([&, t]() {
+            Image<int> in(32, 16), out(32, 16);
+            for (int i = 0; i < iters; i++) {
+                for (int y = 0; y < in.height(); y++) {
+                    for (int x = 0; x < in.width(); x++) {
+                        in(x, y) = x + y + t * 1000 + i;
+                    }
+                }
+
+                ParamMap params;
+                params.set(input, in);
+                params.set(offset, t);
+                p.realize(out, params);
+
+                for (int y = 0; y < out.height(); y++) {
+                    for (int x = 0; x < out.width(); x++) {
+                        int correct = in(x, y) * 2 + t;
+                        if (out(x, y) != correct) {
+                            failures[t]++;
+                        }
+                    }
+                }
+            }
+        }));
+    }
+
+    for (std::thread &w : workers) {
+        w.join();
+    }
+
+    for (int t = 0; t < threads; t++) {
+        if (failures[t]) {
+            printf("Thread %d computed %d incorrect values\n", t, failures[t]);
+            return -1;
+        }
+    }
+
+    // The Params themselves should have been left untouched.
+    if (offset.get() != 0 || input.get().defined()) {
+        printf("Realizing with a ParamMap modified the Params\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
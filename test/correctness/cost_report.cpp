@@ -0,0 +1,94 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    ImageParam input(Float(32), 1);
+    Image<float> in(100);
+    input.set(in);
+
+    Func f("f"), g("g");
+    Var x("x"), xo("xo"), xi("xi");
+    f(x) = input(x) * 2.0f + input(x + 1);
+    g(x) = f(x) + f(x + 2);
+
+    Pipeline p(g);
+
+    // Computed at root, every point of f is computed once.
+    f.compute_root();
+    CostReport root = p.analyze({64});
+    printf("%s", root.to_string().c_str());
+
+    if (!root.unbounded_loops.empty()) {
+        printf("Could not bound loop %s\n", root.unbounded_loops[0].c_str());
+        return -1;
+    }
+
+    const FuncCost &f_root = root.func("f");
+    if (f_root.points_computed != 66 || f_root.points_required != 66 ||
+        f_root.recompute_factor() != 1.0) {
+        printf("Expected 66 points of f computed once, got %lld computed and %lld distinct\n",
+               (long long)f_root.points_computed, (long long)f_root.points_required);
+        return -1;
+    }
+    if (f_root.stores != 66 || f_root.loads.at(input.name()) != 2 * 66) {
+        printf("Wrong number of stores or loads for f\n");
+        return -1;
+    }
+    // A multiply and an add per point.
+    if (f_root.ops.at("float32") != 2 * 66) {
+        printf("Expected %d float ops in f, got %lld\n", 2 * 66,
+               (long long)f_root.ops.at("float32"));
+        return -1;
+    }
+    if (f_root.allocations.size() != 1 ||
+        f_root.allocations[0].loop_level != "root" ||
+        f_root.allocations[0].bytes != 66 * 4 ||
+        f_root.allocations[0].count != 1) {
+        printf("Expected a single allocation of f at root\n");
+        return -1;
+    }
+
+    const FuncCost &g_root = root.func("g");
+    if (g_root.stores != 64 || g_root.loads.at("f") != 2 * 64) {
+        printf("Wrong number of stores or loads for g\n");
+        return -1;
+    }
+
+    // Computed per tile of g, the tiles overlap.
+    g.split(x, xo, xi, 8);
+    f.compute_at(g, xo);
+    CostReport tiled = p.analyze({64});
+    printf("%s", tiled.to_string().c_str());
+    double tiled_factor = tiled.func("f").recompute_factor();
+    if (tiled_factor < 1.1 || tiled_factor > 1.3) {
+        printf("Expected some recompute for f computed per tile, got %f\n", tiled_factor);
+        return -1;
+    }
+    if (tiled.func("f").allocations[0].count != 8) {
+        printf("Expected f to be allocated once per tile\n");
+        return -1;
+    }
+
+    // Computed per point of g, each point of f is computed about
+    // three times.
+    f.compute_at(g, xi);
+    CostReport inner = p.analyze({64});
+    double inner_factor = inner.func("f").recompute_factor();
+    if (inner_factor < 2.5) {
+        printf("Expected f to be recomputed per point of g, got %f\n", inner_factor);
+        return -1;
+    }
+
+    // Inlined, f doesn't appear at all.
+    f.compute_inline();
+    CostReport inlined = p.analyze({64});
+    if (inlined.funcs.size() != 1) {
+        printf("Expected only g in the report for an inlined f\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
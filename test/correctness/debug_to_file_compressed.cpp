@@ -0,0 +1,147 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace Halide;
+
+// Read a little-endian TIFF tag value.
+int32_t tag_value(const std::vector<uint8_t> &file, int code) {
+    int32_t ifd = 0;
+    memcpy(&ifd, &file[4], 4);
+    uint16_t entries = 0;
+    memcpy(&entries, &file[ifd], 2);
+    for (int i = 0; i < entries; i++) {
+        const uint8_t *entry = &file[ifd + 2 + 12 * i];
+        uint16_t tag = 0, type = 0;
+        memcpy(&tag, entry, 2);
+        memcpy(&type, entry + 2, 2);
+        if (tag == code) {
+            if (type == 3) {
+                uint16_t v = 0;
+                memcpy(&v, entry + 8, 2);
+                return v;
+            }
+            int32_t v = 0;
+            memcpy(&v, entry + 8, 4);
+            return v;
+        }
+    }
+    return -1;
+}
+
+// Decode a strip compressed with TIFF LZW.
+std::vector<uint8_t> lzw_decode(const uint8_t *src, int32_t size) {
+    std::vector<uint8_t> out;
+    std::vector<std::vector<uint8_t>> table;
+    int64_t bit = 0;
+    int width = 9;
+    int old = -1;
+    while (bit + width <= size * 8) {
+        int code = 0;
+        for (int i = 0; i < width; i++, bit++) {
+            code = (code << 1) | ((src[bit / 8] >> (7 - bit % 8)) & 1);
+        }
+        if (code == 257) break;
+        if (code == 256) {
+            table.clear();
+            for (int i = 0; i < 258; i++) {
+                table.push_back(std::vector<uint8_t>(1, (uint8_t)i));
+            }
+            width = 9;
+            old = -1;
+            continue;
+        }
+        std::vector<uint8_t> entry;
+        if (code < (int)table.size()) {
+            entry = table[code];
+            if (old >= 0) {
+                std::vector<uint8_t> next = table[old];
+                next.push_back(entry[0]);
+                table.push_back(next);
+            }
+        } else {
+            entry = table[old];
+            entry.push_back(entry[0]);
+            table.push_back(entry);
+        }
+        out.insert(out.end(), entry.begin(), entry.end());
+        old = code;
+        // The encoder switches to wider codes one code early.
+        if (table.size() == 511 || table.size() == 1023 || table.size() == 2047) {
+            width++;
+        }
+    }
+    return out;
+}
+
+int main(int argc, char **argv) {
+    // Must be set before the runtime first writes a file.
+    static char env[] = "HL_DEBUG_TO_FILE_COMPRESS=1";
+    putenv(env);
+
+    const int W = 200, H = 100;
+    Func f;
+    Var x, y;
+    f(x, y) = x * 3 + y;
+    Func g;
+    g(x, y) = f(x, y);
+    f.compute_root().debug_to_file("f_compressed.tiff");
+
+    g.realize(W, H);
+
+    FILE *file = fopen("f_compressed.tiff", "rb");
+    if (!file) {
+        printf("Couldn't open f_compressed.tiff\n");
+        return -1;
+    }
+    std::vector<uint8_t> data(W * H * 4 * 2);
+    size_t size = fread(&data[0], 1, data.size(), file);
+    fclose(file);
+    data.resize(size);
+
+    if (tag_value(data, 259) != 5 || tag_value(data, 317) != 2) {
+        printf("Expected LZW compression with horizontal differencing\n");
+        return -1;
+    }
+
+    // The data is very smooth, so should compress well.
+    if (size > W * H * 4 / 4) {
+        printf("Compressed file is %d bytes, which is too large\n", (int)size);
+        return -1;
+    }
+
+    // Decompress the single strip.
+    int32_t offset = tag_value(data, 273);
+    int32_t count = tag_value(data, 279);
+    std::vector<uint8_t> bytes = lzw_decode(&data[offset], count);
+
+    // Undo the differencing.
+    std::vector<int32_t> pixels;
+    for (size_t j = 0; j + 4 <= bytes.size(); j += 4) {
+        int32_t delta;
+        memcpy(&delta, &bytes[j], 4);
+        if (pixels.size() % W == 0) {
+            pixels.push_back(delta);
+        } else {
+            pixels.push_back((int32_t)((uint32_t)pixels.back() + (uint32_t)delta));
+        }
+    }
+
+    if (pixels.size() != W * H) {
+        printf("Decoded %d pixels instead of %d\n", (int)pixels.size(), W * H);
+        return -1;
+    }
+    for (int j = 0; j < H; j++) {
+        for (int i = 0; i < W; i++) {
+            if (pixels[j * W + i] != i * 3 + j) {
+                printf("f(%d, %d) = %d instead of %d\n", i, j, pixels[j * W + i], i * 3 + j);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
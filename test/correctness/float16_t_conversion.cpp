@@ -0,0 +1,115 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+
+using namespace Halide;
+
+uint32_t float_bits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+float bits_to_float(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+bool test(const Target &target) {
+    Var x;
+
+    // Widening every possible half.
+    Image<uint16_t> half_bits(1 << 16);
+    for (int i = 0; i < half_bits.width(); i++) {
+        half_bits(i) = (uint16_t)i;
+    }
+
+    Func widen;
+    widen(x) = cast<float>(reinterpret<float16_t>(half_bits(x)));
+    widen.vectorize(x, 8);
+    Image<float> widened = widen.realize(half_bits.width(), target);
+
+    for (int i = 0; i < half_bits.width(); i++) {
+        float correct = (float)float16_t::make_from_bits((uint16_t)i);
+        float result = widened(i);
+        if (std::isnan(correct) ? !std::isnan(result) : float_bits(correct) != float_bits(result)) {
+            printf("Widening half 0x%04x gave %f instead of %f\n", i, result, correct);
+            return false;
+        }
+    }
+
+    // Narrowing floats across the whole range, including the specials.
+    const int n = 1 << 16;
+    Image<float> floats(n);
+    uint32_t seed = 0;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1664525 + 1013904223;
+        floats(i) = bits_to_float(seed);
+    }
+    floats(0) = 0.0f;
+    floats(1) = -0.0f;
+    floats(2) = INFINITY;
+    floats(3) = -INFINITY;
+    floats(4) = NAN;
+    floats(5) = 65504.0f;
+    floats(6) = 65520.0f;
+    floats(7) = 1.0f / (1 << 24);
+    floats(8) = 3.0f / (1 << 25);
+    floats(9) = 1.0f + 1.0f / (1 << 11);
+
+    Func narrow;
+    narrow(x) = cast<float16_t>(floats(x));
+    narrow.vectorize(x, 8);
+    Image<float16_t> narrowed = narrow.realize(n, target);
+
+    for (int i = 0; i < n; i++) {
+        float16_t correct(floats(i), RoundingMode::ToNearestTiesToEven);
+        float16_t result = narrowed(i);
+        bool both_nan = correct.is_nan() && result.is_nan();
+        if (!both_nan && correct.to_bits() != result.to_bits()) {
+            printf("Narrowing %.10g gave 0x%04x instead of 0x%04x\n",
+                   floats(i), result.to_bits(), correct.to_bits());
+            return false;
+        }
+    }
+
+    // Float(16) used as the storage type of an intermediate. The
+    // arithmetic happens in single precision.
+    Func stored, consumer;
+    stored(x) = cast<float16_t>(cast<float>(x % 100) * 0.25f);
+    consumer(x) = stored(x) + stored(x + 1);
+    stored.compute_root().vectorize(x, 8);
+    consumer.vectorize(x, 8);
+    Image<float16_t> out = consumer.realize(1000, target);
+    for (int i = 0; i < out.width(); i++) {
+        float correct = (i % 100) * 0.25f + ((i + 1) % 100) * 0.25f;
+        if ((float)out(i) != correct) {
+            printf("out(%d) = %f instead of %f\n", i, (float)out(i), correct);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+
+    if (target.arch == Target::X86 && target.has_feature(Target::F16C)) {
+        if (!test(target)) {
+            printf("Failed with f16c\n");
+            return -1;
+        }
+    }
+
+    target.set_feature(Target::F16C, false);
+    if (!test(target)) {
+        printf("Failed without f16c\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "Halide.h"
+#include "halide_image_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+// Round trip images through save_image and load_strips, with a strip
+// height that doesn't divide the height of the image, so that the last
+// strip is a short one.
+
+const int width = 37, height = 23;
+
+template<typename T>
+Image<T> make_image(int channels) {
+    Image<T> im = channels == 1 ? Image<T>(width, height) : Image<T>(width, height, channels);
+    for (int c = 0; c < channels; c++) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (channels == 1) {
+                    im(x, y) = (T)rand();
+                } else {
+                    im(x, y, c) = (T)rand();
+                }
+            }
+        }
+    }
+    return im;
+}
+
+// Load a file in strips, checking each strip against the image that
+// was saved, after converting to the strip type.
+template<typename T, typename StripT>
+bool check_strips(const Image<T> &im, const std::string &filename, int strip_height) {
+    int channels = im.dimensions() > 2 ? im.channels() : 1;
+    int rows_seen = 0, strips_seen = 0;
+    bool ok = true;
+    bool finished = load_strips<Image<StripT>>(filename, strip_height, [&](Image<StripT> &strip) {
+        int expected_height = std::min(strip_height, height - rows_seen);
+        if (strip.min(1) != rows_seen || strip.height() != expected_height ||
+            strip.width() != width) {
+            printf("%s: strip %d is %dx%d at row %d instead of %dx%d at row %d\n",
+                   filename.c_str(), strips_seen,
+                   strip.width(), strip.height(), strip.min(1),
+                   width, expected_height, rows_seen);
+            ok = false;
+            return false;
+        }
+        for (int c = 0; c < channels; c++) {
+            for (int y = strip.min(1); y < strip.min(1) + strip.height(); y++) {
+                for (int x = 0; x < width; x++) {
+                    StripT correct;
+                    Tools::Internal::convert(channels == 1 ? im(x, y) : im(x, y, c), correct);
+                    StripT actual = channels == 1 ? strip(x, y) : strip(x, y, c);
+                    if (actual != correct) {
+                        printf("%s: strip(%d, %d, %d) = %f instead of %f\n",
+                               filename.c_str(), x, y, c, (double)actual, (double)correct);
+                        ok = false;
+                        return false;
+                    }
+                }
+            }
+        }
+        rows_seen += strip.height();
+        strips_seen++;
+        return true;
+    });
+    if (!ok) return false;
+    if (!finished || rows_seen != height) {
+        printf("%s: load_strips read %d rows instead of %d\n", filename.c_str(), rows_seen, height);
+        return false;
+    }
+    return true;
+}
+
+template<typename T>
+bool check_round_trip(int channels, const std::string &filename) {
+    Image<T> im = make_image<T>(channels);
+    save_image(im, filename);
+
+    Image<T> loaded = load_image(filename);
+    for (int c = 0; c < channels; c++) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                T correct = channels == 1 ? im(x, y) : im(x, y, c);
+                T actual = channels == 1 ? loaded(x, y) : loaded(x, y, c);
+                if (actual != correct) {
+                    printf("%s: loaded(%d, %d, %d) = %d instead of %d\n",
+                           filename.c_str(), x, y, c, (int)actual, (int)correct);
+                    return false;
+                }
+            }
+        }
+    }
+
+    // The same type as the file. Single channel images are decoded
+    // straight into the strip, multi-channel ones are deinterleaved.
+    if (!check_strips<T, T>(im, filename, 5)) return false;
+    // A single strip, and a strip taller than the image.
+    if (!check_strips<T, T>(im, filename, height)) return false;
+    if (!check_strips<T, T>(im, filename, height + 7)) return false;
+    // A different type, which goes through the conversion row buffer.
+    if (!check_strips<T, float>(im, filename, 5)) return false;
+
+    // Stopping early decodes no more strips.
+    int calls = 0;
+    bool finished = load_strips<Image<T>>(filename, 5, [&](Image<T> &) {
+        calls++;
+        return calls < 2;
+    });
+    if (finished || calls != 2) {
+        printf("%s: load_strips made %d calls and returned %d after being told to stop\n",
+               filename.c_str(), calls, (int)finished);
+        return false;
+    }
+
+    remove(filename.c_str());
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (!check_round_trip<uint8_t>(1, "image_io_gray8.png")) return -1;
+    if (!check_round_trip<uint8_t>(3, "image_io_rgb8.png")) return -1;
+    if (!check_round_trip<uint16_t>(1, "image_io_gray16.png")) return -1;
+    if (!check_round_trip<uint16_t>(3, "image_io_rgb16.png")) return -1;
+    if (!check_round_trip<uint8_t>(3, "image_io_rgb8.ppm")) return -1;
+    if (!check_round_trip<uint16_t>(3, "image_io_rgb16.ppm")) return -1;
+
+    printf("Success!\n");
+    return 0;
+}
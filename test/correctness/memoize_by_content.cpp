@@ -0,0 +1,88 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+int call_count = 0;
+
+// Copies the lookup table into the output, counting how many times
+// it really runs.
+extern "C" DLLEXPORT int apply_lut(buffer_t *lut, buffer_t *out) {
+    if (out->host) {
+        call_count++;
+        for (int32_t i = 0; i < out->extent[0]; i++) {
+            int32_t src = (out->min[0] + i - lut->min[0]) * lut->stride[0];
+            out->host[i * out->stride[0]] = lut->host[src] + 1;
+        }
+    }
+    return 0;
+}
+
+int check(const Image<uint8_t> &out, const Image<uint8_t> &lut) {
+    for (int x = 0; x < out.width(); x++) {
+        uint8_t correct = lut(x) + 1;
+        if (out(x) != correct) {
+            printf("out(%d) = %d instead of %d\n", x, out(x), correct);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    ImageParam lut_param(UInt(8), 1);
+
+    Func f;
+    f.define_extern("apply_lut", {lut_param}, UInt(8), 1);
+    f.compute_root().memoize_by_content();
+
+    Func g;
+    Var x;
+    g(x) = f(x);
+
+    Image<uint8_t> lut(256);
+    for (int i = 0; i < 256; i++) {
+        lut(i) = (uint8_t)(i * 3);
+    }
+    lut_param.set(lut);
+
+    Image<uint8_t> out = g.realize(256);
+    if (check(out, lut)) return -1;
+    out = g.realize(256);
+    if (check(out, lut)) return -1;
+    if (call_count != 1) {
+        printf("Expected one call with unchanged contents, got %d\n", call_count);
+        return -1;
+    }
+
+    // The same contents in a different buffer still hit the cache.
+    Image<uint8_t> lut_copy(256);
+    for (int i = 0; i < 256; i++) {
+        lut_copy(i) = lut(i);
+    }
+    lut_param.set(lut_copy);
+    out = g.realize(256);
+    if (check(out, lut_copy)) return -1;
+    if (call_count != 1) {
+        printf("Expected a cache hit for a copy of the table, got %d calls\n", call_count);
+        return -1;
+    }
+
+    // Changing the contents in place misses.
+    lut_copy(17) = 0;
+    out = g.realize(256);
+    if (check(out, lut_copy)) return -1;
+    if (call_count != 2) {
+        printf("Expected a cache miss after changing the table, got %d calls\n", call_count);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
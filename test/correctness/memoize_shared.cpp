@@ -0,0 +1,114 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+int call_count = 0;
+
+extern "C" DLLEXPORT int count_calls(int32_t val, buffer_t *out) {
+    if (out->host) {
+        call_count++;
+        int32_t *dst = (int32_t *)out->host;
+        for (int32_t y = 0; y < out->extent[1]; y++) {
+            for (int32_t x = 0; x < out->extent[0]; x++) {
+                dst[x * out->stride[0] + y * out->stride[1]] = val;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+    printf("The shared memoization cache needs mmap and flock. Skipping test.\n");
+    return 0;
+#else
+    const char *path = "memoize_shared_test.cache";
+    const char *other_path = "memoize_shared_test_2.cache";
+    unlink(path);
+    unlink(other_path);
+
+    Target t = get_jit_target_from_environment().with_feature(Target::MemoizeStableKeys);
+
+    Param<int32_t> val;
+    Func count;
+    count.define_extern("count_calls", {val}, Int(32), 2);
+    count.compute_root().memoize();
+
+    Func f;
+    Var x, y;
+    f(x, y) = count(x, y) + 1;
+
+    // Compute the result in another process.
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (!Internal::JITSharedRuntime::memoization_cache_use_shared_file(path, 1 << 24)) {
+            exit(1);
+        }
+        val.set(7);
+        Image<int32_t> out = f.realize(64, 64, t);
+        exit(call_count == 1 && out(3, 3) == 8 ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        printf("Child process failed\n");
+        return -1;
+    }
+
+    // This process should find it in the cache.
+    if (!Internal::JITSharedRuntime::memoization_cache_use_shared_file(path, 1 << 24)) {
+        printf("Couldn't open %s\n", path);
+        return -1;
+    }
+    val.set(7);
+    Image<int32_t> out = f.realize(64, 64, t);
+    if (out(3, 3) != 8) {
+        printf("out(3, 3) = %d instead of 8\n", out(3, 3));
+        return -1;
+    }
+    if (call_count != 0) {
+        printf("Expected the result from the other process, but computed it %d times\n", call_count);
+        return -1;
+    }
+
+    // A different parameter value is a miss.
+    val.set(9);
+    out = f.realize(64, 64, t);
+    if (out(3, 3) != 10 || call_count != 1) {
+        printf("Expected a cache miss: out(3, 3) = %d, %d calls\n", out(3, 3), call_count);
+        return -1;
+    }
+
+    // Switching to another file closes the first one, so it can be
+    // opened. It starts out empty, so this is a miss too.
+    if (!Internal::JITSharedRuntime::memoization_cache_use_shared_file(other_path, 1 << 24)) {
+        printf("Couldn't switch to %s\n", other_path);
+        return -1;
+    }
+    out = f.realize(64, 64, t);
+    if (out(3, 3) != 10 || call_count != 2) {
+        printf("Expected a miss in the new file: out(3, 3) = %d, %d calls\n", out(3, 3), call_count);
+        return -1;
+    }
+
+    Internal::JITSharedRuntime::memoization_cache_use_shared_file("", 0);
+    unlink(path);
+    unlink(other_path);
+
+    printf("Success!\n");
+    return 0;
+#endif
+}
@@ -0,0 +1,84 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+int call_count = 0;
+extern "C" DLLEXPORT int count_calls(int x) {
+    call_count++;
+    return x;
+}
+HalideExtern_1(int, count_calls, int);
+
+const int size = 64, tile_size = 16;
+
+int check(const Image<int> &out, const Image<int> &in) {
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            int correct = in(x, y) * 2;
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int run(Func g, const Image<int> &in, int expected_calls) {
+    call_count = 0;
+    Image<int> out = g.realize(size, size);
+    if (check(out, in)) return -1;
+    if (call_count != expected_calls) {
+        printf("Expected %d calls, got %d\n", expected_calls, call_count);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    ImageParam input(Int(32), 2);
+
+    // A memoized Func computed per tile of its consumer.
+    Func f, g;
+    Var x, y, xo, yo, xi, yi;
+    f(x, y) = count_calls(input(x, y)) * 2;
+    g(x, y) = f(x, y);
+    g.tile(x, y, xo, yo, xi, yi, tile_size, tile_size);
+    f.compute_at(g, xo).memoize_by_content();
+
+    Image<int> frame(size, size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            frame(x, y) = x + y * size;
+        }
+    }
+    input.set(frame);
+
+    // The first frame computes every tile.
+    if (run(g, frame, size * size)) return -1;
+
+    // The same frame again computes nothing.
+    if (run(g, frame, 0)) return -1;
+
+    // A new frame that differs in one pixel only recomputes the tile
+    // containing it.
+    Image<int> next_frame(size, size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            next_frame(x, y) = frame(x, y);
+        }
+    }
+    next_frame(20, 40) = -1;
+    input.set(next_frame);
+    if (run(g, next_frame, tile_size * tile_size)) return -1;
+
+    printf("Success!\n");
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <atomic>
 #include "Halide.h"
 
 using namespace Halide;
@@ -16,6 +17,13 @@ extern "C" DLLEXPORT int call_counter(int x, int y) {
 }
 HalideExtern_2(int, call_counter, int, int);
 
+std::atomic<int> atomic_count;
+extern "C" DLLEXPORT int atomic_call_counter(int x, int y) {
+    atomic_count++;
+    return 0;
+}
+HalideExtern_2(int, atomic_call_counter, int, int);
+
 extern "C" void *my_malloc(void *, size_t x) {
     printf("Malloc wasn't supposed to be called!\n");
     exit(-1);
@@ -146,6 +154,54 @@ int main(int argc, char **argv) {
         }
     }
 
+    {
+        // Slide within parallel strips of the consumer's loop over y
+        Func f, g;
+
+        atomic_count = 0;
+        f(x, y) = atomic_call_counter(x, y);
+        g(x, y) = f(x, y) + f(x, y+1);
+        g.parallel(y);
+        f.store_root().compute_at(g, y).slide_in_strips(10);
+
+        Image<int> im = g.realize(10, 100);
+
+        // Each of the 10 strips computes its 10 rows plus one extra
+        // row to warm up the window.
+        if (atomic_count != 10*11*10) {
+            printf("f was called %d times instead of %d times\n", (int)atomic_count, 10*11*10);
+            return -1;
+        }
+    }
+
+    for (int strip_size : {10, 7}) {
+        // Check the values against the same pipeline without the
+        // schedule, including a strip size that doesn't divide the
+        // output, so the last strip is a partial one.
+        Func f, g, f_ref, g_ref;
+
+        f(x, y) = atomic_call_counter(x, y) + x * y + y * y;
+        g(x, y) = f(x, y) + 2 * f(x, y+1) + 3 * f(x, y+2);
+        g.parallel(y);
+        f.store_root().compute_at(g, y).slide_in_strips(strip_size);
+
+        f_ref(x, y) = x * y + y * y;
+        g_ref(x, y) = f_ref(x, y) + 2 * f_ref(x, y+1) + 3 * f_ref(x, y+2);
+
+        Image<int> im = g.realize(10, 100);
+        Image<int> ref = g_ref.realize(10, 100);
+
+        for (int yy = 0; yy < 100; yy++) {
+            for (int xx = 0; xx < 10; xx++) {
+                if (im(xx, yy) != ref(xx, yy)) {
+                    printf("With strips of %d rows, im(%d, %d) = %d instead of %d\n",
+                           strip_size, xx, yy, im(xx, yy), ref(xx, yy));
+                    return -1;
+                }
+            }
+        }
+    }
+
     {
         // Now make sure Halide folds the example in Func.h down to a stack allocation
         Func f, g;
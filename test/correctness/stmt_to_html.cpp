@@ -1,5 +1,7 @@
 #include "Halide.h"
 #include <stdio.h>
+#include <fstream>
+#include <sstream>
 #ifndef _MSC_VER
 #include <unistd.h>
 #endif
@@ -52,6 +54,42 @@ int main() {
     assert(access(result_file_2, F_OK) == 0 && "Output file not created.");
     #endif
 
+    // Annotate the loops with a static cost report.
+    const char *result_file_4 = "stmt_to_html_dump_4.html";
+    Func producer("producer"), consumer("consumer");
+    producer(x, y) = x * y;
+    consumer(x, y) = producer(x, y) + producer(x + 1, y);
+    producer.compute_at(consumer, y).vectorize(x, 8);
+    Pipeline p(consumer);
+    CostReport costs = p.analyze({256, 256});
+    consumer.compile_to_lowered_stmt(result_file_4, {}, costs);
+
+    std::ifstream file(result_file_4);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string html = contents.str();
+    if (html.find("class='Annotation'") == std::string::npos ||
+        html.find("% of work") == std::string::npos ||
+        html.find("256 iterations") == std::string::npos) {
+        printf("Expected the loops in %s to be annotated with costs\n", result_file_4);
+        return -1;
+    }
+
+    // Or with times from the profiler.
+    const char *result_file_5 = "stmt_to_html_dump_5.html";
+    StmtProfile profile;
+    profile.func_time["producer"] = 3;
+    profile.func_time["consumer"] = 1;
+    consumer.compile_to_lowered_stmt(result_file_5, {}, profile);
+
+    std::ifstream file_5(result_file_5);
+    contents.str("");
+    contents << file_5.rdbuf();
+    if (contents.str().find("75.0% of time") == std::string::npos) {
+        printf("Expected the production of producer in %s to be annotated with its time\n", result_file_5);
+        return -1;
+    }
+
     printf("Success!\n");
     return 0;
 }
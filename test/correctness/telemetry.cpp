@@ -0,0 +1,98 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+
+bool error_occurred = false;
+void my_error_handler(void *user_context, const char *msg) {
+    error_occurred = true;
+}
+
+int main(int argc, char **argv) {
+    ImageParam input(Float(32), 1);
+    Func f, g;
+    Var x;
+    f(x) = input(x) * 2.0f;
+    g(x) = f(x) + f(x + 1);
+    f.compute_root();
+    g.set_error_handler(&my_error_handler);
+
+    Target t = get_jit_target_from_environment().with_feature(Target::Telemetry);
+
+    // Bounds queries aren't recorded. infer_input_bounds compiles for
+    // the target in the environment.
+#ifdef _WIN32
+    _putenv_s("HL_JIT_TARGET", t.to_string().c_str());
+#else
+    setenv("HL_JIT_TARGET", t.to_string().c_str(), 1);
+#endif
+    g.infer_input_bounds(100);
+    Buffer inferred = input.get();
+    if (!inferred.defined() || inferred.extent(0) != 101) {
+        printf("Bounds inference didn't set the input\n");
+        return -1;
+    }
+    halide_telemetry_pipeline_stats *stats = Internal::JITSharedRuntime::telemetry_pipelines();
+    if (stats && stats->invocations != 0) {
+        printf("Bounds queries were recorded as %llu calls\n",
+               (unsigned long long)stats->invocations);
+        return -1;
+    }
+
+    Image<float> in(101);
+    input.set(in);
+    const int calls = 10;
+    for (int i = 0; i < calls; i++) {
+        g.realize(100, t);
+    }
+
+    // An input that's too small is an error.
+    Image<float> small(50);
+    input.set(small);
+    g.realize(100, t);
+    if (!error_occurred) {
+        printf("There was supposed to be an error\n");
+        return -1;
+    }
+
+    stats = Internal::JITSharedRuntime::telemetry_pipelines();
+    if (!stats || stats->next) {
+        printf("Expected statistics for exactly one pipeline\n");
+        return -1;
+    }
+
+    if (stats->invocations != calls + 1 || stats->errors != 1) {
+        printf("Expected %d calls and 1 error, got %llu calls and %llu errors\n",
+               calls + 1, (unsigned long long)stats->invocations,
+               (unsigned long long)stats->errors);
+        return -1;
+    }
+
+    // f is allocated once per successful call.
+    if (stats->bytes_allocated != calls * 101 * sizeof(float)) {
+        printf("Expected %d bytes allocated, got %llu\n",
+               (int)(calls * 101 * sizeof(float)),
+               (unsigned long long)stats->bytes_allocated);
+        return -1;
+    }
+
+    uint64_t counted = 0;
+    for (int i = 0; i < halide_telemetry_num_buckets; i++) {
+        counted += stats->latency[i];
+    }
+    if (counted != stats->invocations) {
+        printf("The latency histogram has %llu entries instead of %llu\n",
+               (unsigned long long)counted, (unsigned long long)stats->invocations);
+        return -1;
+    }
+    if (stats->total_time == 0 || stats->max_time * stats->invocations < stats->total_time) {
+        printf("Implausible total and max times: %llu %llu\n",
+               (unsigned long long)stats->total_time,
+               (unsigned long long)stats->max_time);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+using namespace Halide;
+
+int check(const Image<int> &im) {
+    for (int y = 0; y < im.height(); y++) {
+        for (int x = 0; x < im.width(); x++) {
+            int correct = x * x + 3 * y;
+            if (im(x, y) != correct) {
+                printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Target t = get_jit_target_from_environment().with_feature(Target::TieredJIT);
+
+    Func f;
+    Var x, y;
+    f(x, y) = x * x + 3 * y;
+    f.vectorize(x, 4);
+
+    Pipeline p(f);
+
+    // The first compile returns the unoptimized code.
+    void *fast = p.compile_jit(t);
+    Image<int> im = p.realize(64, 64, t);
+    if (check(im)) return -1;
+
+    // Once the optimized code is in use, compile_jit returns it.
+    p.wait_for_tiered_jit();
+    void *optimized = p.compile_jit(t);
+    if (optimized == fast) {
+        printf("Pipeline didn't switch to the optimized code\n");
+        return -1;
+    }
+    im = p.realize(64, 64, t);
+    if (check(im)) return -1;
+
+    // Recompiling for a different target discards the background
+    // compile.
+    p.compile_jit(t.with_feature(Target::OptLevel1));
+    p.compile_jit(t);
+    im = p.realize(64, 64, t);
+    if (check(im)) return -1;
+
+    // Threads realizing with their own ParamMaps keep using the module
+    // they started with while the pipeline switches to the optimized
+    // one.
+    p.invalidate_cache();
+    p.compile_jit(t);
+    std::vector<Image<int>> outputs(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < outputs.size(); i++) {
+        outputs[i] = Image<int>(64, 64);
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < 20; j++) {
+                p.realize(outputs[i], ParamMap(), t);
+            }
+        });
+    }
+    p.wait_for_tiered_jit();
+    for (std::thread &th : threads) {
+        th.join();
+    }
+    for (Image<int> &out : outputs) {
+        if (check(out)) return -1;
+    }
+
+    // Rescheduling abandons a background compile rather than
+    // waiting for it.
+    p.invalidate_cache();
+    p.compile_jit(t);
+    f.vectorize(x, 8);
+    p.invalidate_cache();
+    im = p.realize(64, 64, t);
+    if (check(im)) return -1;
+
+    // The abandoned compiles may still be running here. They're
+    // joined when p is destroyed, before the program exits.
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "Halide.h"
+
+#include <cmath>
+#include <sstream>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+namespace {
+
+// A Generator with some schedule knobs to tune.
+class Blur : public Generator<Blur> {
+public:
+    GeneratorParam<int> split{ "split", 8, 1, 64 };
+    GeneratorParam<bool> vectorize{ "vectorize", true };
+
+    ImageParam input{ Float(32), 2, "input" };
+
+    Func build() {
+        Var x("x"), y("y"), xi("xi");
+        Func blur("blur");
+        blur(x, y) = (input(x, y) + input(x + 1, y) + input(x + 2, y)) / 3;
+
+        blur.split(x, x, xi, split);
+        if (vectorize) {
+            blur.vectorize(xi);
+        }
+        return blur;
+    }
+};
+
+RegisterGenerator<Blur> register_blur{"blur"};
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    std::vector<std::string> range = parse_generator_param_range("2..16");
+    if (range != std::vector<std::string>{"2", "4", "8", "16"}) {
+        printf("Incorrect parse of 2..16\n");
+        return -1;
+    }
+    range = parse_generator_param_range("true,false");
+    if (range != std::vector<std::string>{"true", "false"}) {
+        printf("Incorrect parse of true,false\n");
+        return -1;
+    }
+
+    GeneratorParamValues fixed = { { "target", get_jit_target_from_environment().to_string() } };
+    GeneratorParamSpace space = { { "split", parse_generator_param_range("4..16") },
+                                  { "vectorize", { "true", "false" } } };
+
+    AutotuneOptions options;
+    options.samples = 3;
+    options.threads = 4;
+    options.default_extents = {1024, 256};
+    options.extents["input"] = {1026, 256};
+
+    std::ostringstream log;
+    AutotuneResult result = autotune_generator("blur", fixed, space, options, log);
+    printf("%s", log.str().c_str());
+
+    if (result.candidates != 6) {
+        printf("Tried %d candidates instead of 6\n", (int)result.candidates);
+        return -1;
+    }
+    if (!std::isfinite(result.time) || result.time <= 0) {
+        printf("No candidate ran successfully\n");
+        return -1;
+    }
+    const std::string &split = result.params["split"];
+    if (split != "4" && split != "8" && split != "16") {
+        printf("Best split factor %s is not one of the candidates\n", split.c_str());
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
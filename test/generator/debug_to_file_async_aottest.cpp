@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "HalideRuntime.h"
+#include "halide_image.h"
+#include "debug_to_file_async.h"
+
+using namespace Halide::Tools;
+
+const int W = 64, H = 64;
+
+// Check a file written by debug_to_file holds a W x H int32 image
+// with the given values.
+bool check_file(const char *filename, int scale, int offset) {
+    FILE *f = fopen(filename, "rb");
+    if (!f) {
+        printf("Couldn't open %s\n", filename);
+        return false;
+    }
+    int32_t header[5];
+    static int32_t data[W * H];
+    bool ok = (fread(header, 4, 5, f) == 5 &&
+               fread(data, 4, W * H, f) == W * H);
+    fclose(f);
+    if (!ok) {
+        printf("%s is truncated\n", filename);
+        return false;
+    }
+    if (header[0] != W || header[1] != H || header[2] != 1 ||
+        header[3] != 1 || header[4] != 7) {
+        printf("%s has the wrong header\n", filename);
+        return false;
+    }
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            int32_t correct = (x + y + offset) * scale;
+            if (data[y * W + x] != correct) {
+                printf("%s(%d, %d) = %d instead of %d\n",
+                       filename, x, y, data[y * W + x], correct);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    halide_debug_to_file_set_async(true);
+
+    // Run several times, so that dumps from one run are queued while
+    // the writer may still be finishing the previous one.
+    for (int run = 0; run < 10; run++) {
+        remove("debug_to_file_async_f.tmp");
+        remove("debug_to_file_async_g.tmp");
+        remove("debug_to_file_async_h.tmp");
+
+        int offset = run * 100;
+        Image<int32_t> out(W, H);
+        int result = debug_to_file_async(offset, out);
+        if (result != 0) {
+            printf("Pipeline failed: %d\n", result);
+            return -1;
+        }
+        result = halide_debug_to_file_flush(NULL);
+        if (result != 0) {
+            printf("halide_debug_to_file_flush failed: %d\n", result);
+            return -1;
+        }
+
+        if (!check_file("debug_to_file_async_f.tmp", 1, offset) ||
+            !check_file("debug_to_file_async_g.tmp", 2, offset) ||
+            !check_file("debug_to_file_async_h.tmp", 3, offset)) {
+            return -1;
+        }
+
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                int32_t correct = (x + y + offset) * 3 + 1;
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include "Halide.h"
+
+namespace {
+
+class DebugToFileAsync : public Halide::Generator<DebugToFileAsync> {
+public:
+    Param<int> offset{ "offset", 0 };
+
+    Func build() {
+        Var x, y;
+
+        Func f("f"), g("g"), h("h"), out("out");
+        f(x, y) = x + y + offset;
+        g(x, y) = f(x, y) * 2;
+        h(x, y) = f(x, y) + g(x, y);
+        out(x, y) = h(x, y) + 1;
+
+        // Several dumps in one pipeline, so that later ones are queued
+        // while the background writer is busy with earlier ones.
+        f.compute_root().debug_to_file("debug_to_file_async_f.tmp");
+        g.compute_root().debug_to_file("debug_to_file_async_g.tmp");
+        h.compute_root().debug_to_file("debug_to_file_async_h.tmp");
+
+        return out;
+    }
+};
+
+Halide::RegisterGenerator<DebugToFileAsync> register_my_gen{"debug_to_file_async"};
+
+}  // namespace
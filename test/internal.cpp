@@ -11,7 +11,10 @@
 #include "OneToOne.h"
 #include "CSE.h"
 #include "IREquality.h"
+#include "IRHash.h"
 #include "Solve.h"
+#include "LICM.h"
+#include "StrengthReduction.h"
 
 using namespace Halide;
 using namespace Halide::Internal;
@@ -20,12 +23,15 @@ int main(int argc, const char **argv) {
     IRPrinter::test();
     CodeGen_C::test();
     ir_equality_test();
+    ir_hash_test();
     bounds_test();
     expr_match_test();
     deinterleave_vector_test();
     modulus_remainder_test();
     is_one_to_one_test();
     cse_test();
+    licm_test();
+    strength_reduction_test();
     simplify_test();
     solve_test();
     target_test();
@@ -0,0 +1,90 @@
+#include "Halide.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "benchmark.h"
+
+using namespace Halide;
+
+// Reports the compile time and run time of the same pipeline at each
+// LLVM optimization level.
+
+const int W = 1536, H = 1024;
+
+Func make_pipeline(ImageParam input) {
+    Func clamped, blur_x, blur_y, grad, out;
+    Var x, y, xi, yi;
+
+    clamped = BoundaryConditions::repeat_edge(input);
+    blur_x(x, y) = (clamped(x - 1, y) + 2 * clamped(x, y) + clamped(x + 1, y)) / 4;
+    blur_y(x, y) = (blur_x(x, y - 1) + 2 * blur_x(x, y) + blur_x(x, y + 1)) / 4;
+    grad(x, y) = abs(blur_y(x + 1, y) - blur_y(x - 1, y)) + abs(blur_y(x, y + 1) - blur_y(x, y - 1));
+    out(x, y) = select(grad(x, y) > 0.25f, blur_y(x, y), clamped(x, y)) * 0.5f + 0.25f;
+
+    out.tile(x, y, xi, yi, 64, 32).vectorize(xi, 8).parallel(y);
+    blur_y.compute_at(out, x).vectorize(x, 8);
+    blur_x.compute_at(out, x).vectorize(x, 8);
+
+    return out;
+}
+
+int main(int argc, char **argv) {
+    Target base = get_jit_target_from_environment();
+    if (base.has_gpu_feature()) {
+        printf("Not running on a gpu target\n");
+        return 0;
+    }
+
+    Image<float> in(W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            in(x, y) = (float)((x * 7 + y * 13) % 256) / 255.0f;
+        }
+    }
+    ImageParam input(Float(32), 2);
+    input.set(in);
+
+    struct Level {
+        const char *name;
+        Target::Feature feature;
+    } levels[] = {{"O0", Target::OptLevel0},
+                  {"O1", Target::OptLevel1},
+                  {"O2", Target::OptLevel2},
+                  {"O3", Target::FeatureEnd}};
+
+    Image<float> reference;
+    for (const Level &level : levels) {
+        Target t = base.with_feature(level.feature);
+        Func f = make_pipeline(input);
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        f.compile_jit(t);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        double compile_time = std::chrono::duration<double>(t2 - t1).count();
+
+        Image<float> out(W, H);
+        double run_time = benchmark(5, 5, [&]() { f.realize(out, t); });
+
+        printf("%s: compile time %f ms, run time %f ms\n",
+               level.name, compile_time * 1e3, run_time * 1e3);
+
+        // The optimization level must not change the results.
+        if (!reference.defined()) {
+            reference = out;
+            continue;
+        }
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                if (std::abs(out(x, y) - reference(x, y)) > 1e-5f) {
+                    printf("Mismatch at %s: out(%d, %d) = %f instead of %f\n",
+                           level.name, x, y, out(x, y), reference(x, y));
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
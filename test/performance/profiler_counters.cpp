@@ -0,0 +1,80 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Target t = get_jit_target_from_environment().with_feature(Target::Profile);
+    if (t.os != Target::Linux || t.arch != Target::X86) {
+        printf("Hardware event counters are only supported on x86 Linux. Skipping test.\n");
+        return 0;
+    }
+
+    // One Func that does a lot of arithmetic, and one that mostly
+    // moves memory around.
+    Var x, y;
+    Func heavy("heavy"), light("light");
+    Expr e = cast<float>(x + y);
+    for (int i = 0; i < 100; i++) {
+        e = sin(e);
+    }
+    heavy(x, y) = e;
+    light(x, y) = heavy(x, y) + heavy(x, y + 1);
+    heavy.compute_root();
+
+    // Compile first so that the shared runtime exists, then ask for
+    // hardware events to be counted when the profiler starts.
+    light.compile_jit(t);
+    halide_profiler_state *state = Internal::JITSharedRuntime::profiler_state();
+    if (!state) {
+        printf("Couldn't find the profiler state\n");
+        return -1;
+    }
+    state->use_counters = true;
+
+    for (int i = 0; i < 10; i++) {
+        light.realize(1000, 1000, t);
+    }
+
+    // The profiler thread doesn't touch the results while no
+    // pipeline is running.
+    const halide_profiler_func_stats *heavy_stats = NULL;
+    for (halide_profiler_pipeline_stats *p = state->pipelines; p;
+         p = (halide_profiler_pipeline_stats *)(p->next)) {
+        for (int i = 0; i < p->num_funcs; i++) {
+            if (strcmp(p->funcs[i].name, "heavy") == 0) {
+                heavy_stats = p->funcs + i;
+            }
+        }
+    }
+    uint64_t cycles = heavy_stats ? heavy_stats->counters[halide_profiler_cycles] : 0;
+    uint64_t instructions = heavy_stats ? heavy_stats->counters[halide_profiler_instructions] : 0;
+
+    if (!heavy_stats) {
+        printf("No profile recorded for heavy\n");
+        return -1;
+    }
+    if (cycles == 0 && instructions == 0) {
+        // perf_event_open may be forbidden, or there may be no
+        // hardware counters (e.g. in a virtual machine).
+        printf("No hardware events were counted. Skipping test.\n");
+        return 0;
+    }
+
+    double ipc = (double)instructions / cycles;
+    printf("heavy: %llu cycles, %llu instructions, ipc %f\n",
+           (unsigned long long)cycles, (unsigned long long)instructions, ipc);
+    // Each point of heavy takes hundreds of instructions.
+    if (instructions < 1000ULL * 1000 * 10) {
+        printf("Too few instructions counted for heavy\n");
+        return -1;
+    }
+    if (ipc < 0.05 || ipc > 10) {
+        printf("Implausible instructions per cycle\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "Halide.h"
+#include <cstdio>
+#include <stdlib.h>
+#include "benchmark.h"
+
+using namespace Halide;
+
+// Walking down the columns of an image computes the address of each
+// load with a multiply by the stride, unless the strength reduction
+// pass turns it into an add. Compare the two.
+
+Image<uint16_t> input;
+Image<uint16_t> output;
+
+void set_strength_reduction(bool enabled) {
+#ifdef _WIN32
+    _putenv_s("HL_DISABLE_STRENGTH_REDUCTION", enabled ? "0" : "1");
+#else
+    setenv("HL_DISABLE_STRENGTH_REDUCTION", enabled ? "0" : "1", 1);
+#endif
+}
+
+double test(bool strength_reduce) {
+    Func f;
+    Var x, y;
+    // Transposing, so the loop over x reads down a column of input.
+    f(x, y) = input(y, x) * 3 + input(y, x + 1);
+
+    set_strength_reduction(strength_reduce);
+    f.compile_jit();
+    f.realize(output);
+
+    for (int y = 0; y < output.height(); y++) {
+        for (int x = 0; x < output.width(); x++) {
+            uint16_t correct = input(y, x) * 3 + input(y, x + 1);
+            if (output(x, y) != correct) {
+                printf("output(%d, %d) = %d instead of %d\n",
+                       x, y, output(x, y), correct);
+                exit(-1);
+            }
+        }
+    }
+
+    return benchmark(5, 10, [&]() { f.realize(output); });
+}
+
+int main(int argc, char **argv) {
+    input = Image<uint16_t>(1024, 1024 + 1);
+    for (int y = 0; y < input.height(); y++) {
+        for (int x = 0; x < input.width(); x++) {
+            input(x, y) = rand() & 0xfff;
+        }
+    }
+    output = Image<uint16_t>(1024, 1024);
+
+    double t_without = test(false);
+    double t_with = test(true);
+
+    printf("Without strength reduction: %f ms\n"
+           "With strength reduction:    %f ms\n",
+           t_without * 1e3, t_with * 1e3);
+
+    printf("Success!\n");
+    return 0;
+}
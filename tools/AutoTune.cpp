@@ -0,0 +1,5 @@
+#include "Halide.h"
+
+int main(int argc, char **argv) {
+  return Halide::Internal::autotune_main(argc, argv, std::cerr);
+}
@@ -1,14 +1,22 @@
 // This simple PNG IO library works with *both* the Halide::Image<T> type *and*
-// the simple halide_image.h version. Also now includes PPM support for faster load/save.
+// the simple halide_image.h version. Also now includes PPM support for faster load/save,
+// and an ImageReader / load_strips() API for decoding images a few rows at a time.
 
 #ifndef HALIDE_IMAGE_IO_H
 #define HALIDE_IMAGE_IO_H
 
 #include <algorithm>
+#include <condition_variable>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 #include "png.h"
@@ -105,115 +113,338 @@ struct FileOpener {
     FILE * const f;
 };
 
-struct PngRowPointers {
-    PngRowPointers(int height, int rowbytes) : p(new png_bytep[height]), height(height) {
-        if (p != nullptr) {
-            for (int y = 0; y < height; y++) {
-                p[y] = new png_byte[rowbytes];
-            }
+// Convert a row of interleaved samples, as stored in a PNG or PPM
+// file, into a row of an image with the given strides. Each channel
+// is done in a separate loop with a unit-stride destination in the
+// common case, which the compiler can vectorize.
+template<typename SrcT, typename DstT>
+void convert_row(const SrcT *src, int width, int channels,
+                 DstT *dst, int x_stride, int c_stride) {
+    if (channels == 1 && x_stride == 1) {
+        for (int x = 0; x < width; x++) {
+            convert(src[x], dst[x]);
         }
+        return;
     }
-    ~PngRowPointers() {
-        if (p) {
-            for (int y = 0; y < height; y++) {
-                delete[] p[y];
+    for (int c = 0; c < channels; c++) {
+        const SrcT *s = src + c;
+        DstT *d = dst + c * c_stride;
+        if (x_stride == 1) {
+            for (int x = 0; x < width; x++) {
+                convert(s[x * channels], d[x]);
+            }
+        } else {
+            for (int x = 0; x < width; x++) {
+                convert(s[x * channels], d[x * x_stride]);
             }
-            delete[] p;
         }
     }
-    png_bytep* const p;
-    int const height;
+}
+
+// The inverse of convert_row: gather a row of an image into
+// interleaved samples for writing to a file.
+template<typename SrcT, typename DstT>
+void convert_row_interleaved(const SrcT *src, int x_stride, int c_stride,
+                             int width, int channels, DstT *dst, int dst_channels) {
+    for (int c = 0; c < channels; c++) {
+        const SrcT *s = src + c * c_stride;
+        DstT *d = dst + c;
+        for (int x = 0; x < width; x++) {
+            convert(s[x * x_stride], d[x * dst_channels]);
+        }
+    }
+}
+
+// Rows of a file can be decoded straight into an image's memory if it
+// has the same element type and the channels are interleaved like
+// they are in the file.
+template<typename SampleT, typename ImageType>
+bool can_decode_in_place(const ImageType &im, int channels) {
+    return std::is_same<typename ImageType::ElemType, SampleT>::value &&
+        im.stride(0) == channels &&
+        (channels == 1 || im.stride(2) == 1);
+}
+
+// A thread that runs one task at a time for its owner, so that the
+// owner can overlap the task with its own work. load_strips uses one
+// to decode the next strip while the callback runs on the current one.
+class BackgroundWorker {
+public:
+    BackgroundWorker() : pending(false), stopping(false), thread([this]() { run(); }) {}
+
+    // Finishes any task that was started, then stops the thread.
+    ~BackgroundWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        thread.join();
+    }
+
+    BackgroundWorker(const BackgroundWorker &) = delete;
+    BackgroundWorker &operator=(const BackgroundWorker &) = delete;
+
+    // Start running a task. The previous one must have finished.
+    void start(std::function<void()> f) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = std::move(f);
+            pending = true;
+        }
+        wake.notify_all();
+    }
+
+    // Wait for the task most recently started to finish.
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this]() { return !pending; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::function<void()> task;
+    bool pending, stopping;
+    // Declared last, so that it starts after everything it uses.
+    std::thread thread;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this]() { return pending || stopping; });
+            if (!pending) return;
+            lock.unlock();
+            task();
+            lock.lock();
+            pending = false;
+            wake.notify_all();
+        }
+    }
 };
 
 }  // namespace Internal
 
 
+/** Decodes a PNG or PPM file a few rows at a time. Rows are decoded
+ * straight into the destination image when it has the file's sample
+ * type and interleaving, and through a single reused row buffer
+ * otherwise, so only the image being filled needs to be resident
+ * (except for interlaced PNGs, which have to be decoded in full
+ * before the first row is available). See also load_strips. */
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
-bool load_png(const std::string &filename, ImageType *im) {
-    png_byte header[8];
-    png_structp png_ptr;
-    png_infop info_ptr;
+class ImageReader {
+public:
+    ImageReader() : png_ptr(nullptr), info_ptr(nullptr), f(nullptr),
+                    is_png(false), interlaced(false),
+                    width_(0), height_(0), channels_(0), bit_depth_(0), next_row(0) {}
+
+    ~ImageReader() {
+        if (png_ptr != nullptr) {
+            png_destroy_read_struct(&png_ptr, info_ptr != nullptr ? &info_ptr : NULL, NULL);
+        }
+        if (f != nullptr) {
+            fclose(f);
+        }
+    }
 
-    /* open file and test for it being a png */
-    Internal::FileOpener f(filename.c_str(), "rb");
-    if (!check(f.f != nullptr, "File %s could not be opened for reading\n", filename.c_str())) return false;
-    if (!check(fread(header, 1, 8, f.f) == 8, "File ended before end of header\n")) return false;
-    if (!check(!png_sig_cmp(header, 0, 8), "File %s is not recognized as a PNG file\n", filename.c_str())) return false;
+    ImageReader(const ImageReader &) = delete;
+    ImageReader &operator=(const ImageReader &) = delete;
 
-    /* initialize stuff */
-    png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    /** Open a file and read its header, choosing the format by the
+     * file's extension. Returns false upon failure. */
+    bool open(const std::string &filename) {
+        if (Internal::ends_with_ignore_case(filename, ".png")) {
+            return open_png(filename);
+        } else if (Internal::ends_with_ignore_case(filename, ".ppm")) {
+            return open_ppm(filename);
+        } else {
+            return check(false, "[ImageReader] unsupported file extension (png|ppm supported)");
+        }
+    }
 
-    if (!check(png_ptr != nullptr, "png_create_read_struct failed\n")) return false;
+    /** Open a PNG file and read its header. Returns false upon failure. */
+    bool open_png(const std::string &filename) {
+        png_byte header[8];
 
-    info_ptr = png_create_info_struct(png_ptr);
-    if (!check(info_ptr != nullptr, "png_create_info_struct failed\n")) return false;
+        /* open file and test for it being a png */
+        f = fopen(filename.c_str(), "rb");
+        if (!check(f != nullptr, "File %s could not be opened for reading\n", filename.c_str())) return false;
+        if (!check(fread(header, 1, 8, f) == 8, "File ended before end of header\n")) return false;
+        if (!check(!png_sig_cmp(header, 0, 8), "File %s is not recognized as a PNG file\n", filename.c_str())) return false;
+        is_png = true;
 
-    if (!check(!setjmp(png_jmpbuf(png_ptr)), "Error during init_io\n")) return false;
+        /* initialize stuff */
+        png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        if (!check(png_ptr != nullptr, "png_create_read_struct failed\n")) return false;
 
-    png_init_io(png_ptr, f.f);
-    png_set_sig_bytes(png_ptr, 8);
+        info_ptr = png_create_info_struct(png_ptr);
+        if (!check(info_ptr != nullptr, "png_create_info_struct failed\n")) return false;
+
+        if (!check(!setjmp(png_jmpbuf(png_ptr)), "Error during init_io\n")) return false;
 
-    png_read_info(png_ptr, info_ptr);
+        png_init_io(png_ptr, f);
+        png_set_sig_bytes(png_ptr, 8);
 
-    int width = png_get_image_width(png_ptr, info_ptr);
-    int height = png_get_image_height(png_ptr, info_ptr);
-    int channels = png_get_channels(png_ptr, info_ptr);
-    int bit_depth = png_get_bit_depth(png_ptr, info_ptr);
+        png_read_info(png_ptr, info_ptr);
 
-    // Expand low-bpp images to have only 1 pixel per byte (As opposed to tight packing)
-    if (bit_depth < 8) {
-        png_set_packing(png_ptr);
+        width_ = png_get_image_width(png_ptr, info_ptr);
+        height_ = png_get_image_height(png_ptr, info_ptr);
+        channels_ = png_get_channels(png_ptr, info_ptr);
+        bit_depth_ = png_get_bit_depth(png_ptr, info_ptr);
+
+        // Expand low-bpp images to have only 1 pixel per byte (As opposed to tight packing)
+        if (bit_depth_ < 8) {
+            png_set_packing(png_ptr);
+        }
+
+        // 16-bit samples are big-endian in the file. Have libpng swap
+        // them so that rows can be used as native uint16_t.
+        if (bit_depth_ == 16 && Internal::is_little_endian()) {
+            png_set_swap(png_ptr);
+        }
+
+        interlaced = png_set_interlace_handling(png_ptr) > 1;
+        png_read_update_info(png_ptr, info_ptr);
+
+        row.resize(png_get_rowbytes(png_ptr, info_ptr));
+
+        return check((bit_depth_ == 8) || (bit_depth_ == 16), "Can only handle 8-bit or 16-bit pngs\n");
     }
 
-    if (channels != 1) {
-        *im = ImageType(width, height, channels);
-    } else {
-        *im = ImageType(width, height);
+    /** Open a binary PPM file and read its header. Returns false upon failure. */
+    bool open_ppm(const std::string &filename) {
+        /* open file and test for it being a ppm */
+        f = fopen(filename.c_str(), "rb");
+        if (!check(f != nullptr, "File %s could not be opened for reading\n", filename.c_str())) return false;
+
+        int maxval;
+        char header[256];
+        if (!check(fscanf(f, "%255s", header) == 1, "Could not read PPM header\n")) return false;
+        if (!check(fscanf(f, "%d %d\n", &width_, &height_) == 2, "Could not read PPM width and height\n")) return false;
+        if (!check(fscanf(f, "%d", &maxval) == 1, "Could not read PPM max value\n")) return false;
+        if (!check(fgetc(f) != EOF, "Could not read char from PPM\n")) return false;
+
+        if (maxval == 255) { bit_depth_ = 8; }
+        else if (maxval == 65535) { bit_depth_ = 16; }
+        else { if (!check(false, "Invalid bit depth in PPM\n")) return false; }
+
+        if (!check(header == std::string("P6") || header == std::string("p6"), "Input is not binary PPM\n")) return false;
+        if (!check(width_ > 0 && height_ > 0, "Invalid PPM size %dx%d\n", width_, height_)) return false;
+
+        channels_ = 3;
+        row.resize((size_t)width_ * channels_ * (bit_depth_ / 8));
+        return true;
     }
 
-    png_set_interlace_handling(png_ptr);
-    png_read_update_info(png_ptr, info_ptr);
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int channels() const { return channels_; }
+    int bit_depth() const { return bit_depth_; }
+
+    /** The number of rows of the file decoded so far. */
+    int rows_read() const { return next_row; }
 
-    // read the file
-    if (!check(!setjmp(png_jmpbuf(png_ptr)), "Error during read_image\n")) return false;
+    /** Allocate an image with the width and channels of the file, and
+     * the given number of rows. */
+    ImageType allocate(int rows) const {
+        if (channels_ != 1) {
+            return ImageType(width_, rows, channels_);
+        } else {
+            return ImageType(width_, rows);
+        }
+    }
 
-    Internal::PngRowPointers row_pointers(im->height(), png_get_rowbytes(png_ptr, info_ptr));
-    png_read_image(png_ptr, row_pointers.p);
+    /** Decode the next im.height() rows of the file into im, which
+     * must have the width and number of channels of the file. Returns
+     * false upon failure. */
+    bool read_rows(ImageType &im) {
+        if (!check(im.width() == width_ && im.channels() == channels_,
+                   "[ImageReader] Can't read rows of a %dx%d image with %d channels into one %d wide with %d channels\n",
+                   width_, height_, channels_, im.width(), im.channels())) return false;
+        if (!check(next_row + im.height() <= height_,
+                   "[ImageReader] Can't read rows %d to %d of an image with %d rows\n",
+                   next_row, next_row + im.height() - 1, height_)) return false;
+
+        bool result = (bit_depth_ == 8) ? read_rows_of<uint8_t>(im) : read_rows_of<uint16_t>(im);
+        im.set_host_dirty();
+        return result;
+    }
 
-    if (!check((bit_depth == 8) || (bit_depth == 16), "Can only handle 8-bit or 16-bit pngs\n")) return false;
+private:
+    png_structp png_ptr;
+    png_infop info_ptr;
+    FILE *f;
+    bool is_png, interlaced;
+    int width_, height_, channels_, bit_depth_;
+    int next_row;
+    // One row of the file, as interleaved samples.
+    std::vector<uint8_t> row;
+    // The whole image, for interlaced PNGs.
+    std::vector<uint8_t> decoded;
+    std::vector<png_bytep> row_pointers;
+
+    template<typename SampleT>
+    bool read_rows_of(ImageType &im) {
+        typedef typename ImageType::ElemType ElemType;
+
+        // libpng reports errors by longjmp-ing to the most recent setjmp.
+        if (is_png) {
+            if (!check(!setjmp(png_jmpbuf(png_ptr)), "Error during read_image\n")) return false;
+        }
 
-    // convert the data to ImageType::ElemType
+        bool in_place = Internal::can_decode_in_place<SampleT>(im, channels_);
+        int x_stride = im.stride(0);
+        int c_stride = (channels_ == 1) ? 0 : im.stride(2);
+        ElemType *ptr = (ElemType *)im.data();
+        for (int y = 0; y < im.height(); y++) {
+            ElemType *dst = ptr + y * im.stride(1);
+            uint8_t *src = in_place ? (uint8_t *)dst : row.data();
+            if (!read_row(src)) return false;
+            if (!in_place) {
+                Internal::convert_row((const SampleT *)src, width_, channels_, dst, x_stride, c_stride);
+            }
+        }
+        return true;
+    }
 
-    int c_stride = (im->channels() == 1) ? 0 : im->stride(2);
-    typename ImageType::ElemType *ptr = (typename ImageType::ElemType*)im->data();
-    if (bit_depth == 8) {
-        for (int y = 0; y < im->height(); y++) {
-            uint8_t *srcPtr = (uint8_t *)(row_pointers.p[y]);
-            for (int x = 0; x < im->width(); x++) {
-                for (int c = 0; c < im->channels(); c++) {
-                    Internal::convert(*srcPtr++, ptr[c*c_stride]);
+    // Decode the next row of the file into dst.
+    bool read_row(uint8_t *dst) {
+        if (!is_png) {
+            if (!check(fread(dst, 1, row.size(), f) == row.size(), "Could not read PPM %d-bit data\n", bit_depth_)) return false;
+            if (bit_depth_ == 16) {
+                bool little_endian = Internal::is_little_endian();
+                uint16_t *samples = (uint16_t *)dst;
+                for (size_t i = 0; i < row.size() / 2; i++) {
+                    Internal::swap_endian_16(little_endian, samples[i]);
                 }
-                ptr++;
             }
-        }
-    } else if (bit_depth == 16) {
-        for (int y = 0; y < im->height(); y++) {
-            uint8_t *srcPtr = (uint8_t *)(row_pointers.p[y]);
-            for (int x = 0; x < im->width(); x++) {
-                for (int c = 0; c < im->channels(); c++) {
-                    uint16_t hi = (*srcPtr++) << 8;
-                    uint16_t lo = hi | (*srcPtr++);
-                    Internal::convert(lo, ptr[c*c_stride]);
+        } else if (!interlaced) {
+            png_read_row(png_ptr, dst, NULL);
+        } else {
+            // Adam7 spreads every row over seven passes, so decode the
+            // whole image the first time a row is needed.
+            if (decoded.empty()) {
+                decoded.resize(row.size() * (size_t)height_);
+                row_pointers.resize(height_);
+                for (int y = 0; y < height_; y++) {
+                    row_pointers[y] = &decoded[y * row.size()];
                 }
-                ptr++;
+                png_read_image(png_ptr, row_pointers.data());
             }
+            memcpy(dst, row_pointers[next_row], row.size());
         }
+        next_row++;
+        return true;
     }
+};
 
-    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-
-    im->set_host_dirty();
-    return true;
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+bool load_png(const std::string &filename, ImageType *im) {
+    ImageReader<ImageType, check> reader;
+    if (!reader.open_png(filename)) return false;
+    *im = reader.allocate(reader.height());
+    return reader.read_rows(*im);
 }
 
 // "im" is not const-ref because copy_to_host() is not const.
@@ -262,46 +493,32 @@ bool save_png(ImageType &im, const std::string &filename) {
 
     png_write_info(png_ptr, info_ptr);
 
-    Internal::PngRowPointers row_pointers(im.height(), png_get_rowbytes(png_ptr, info_ptr));
+    // Rows are built as native uint16_t; libpng swaps them to big-endian.
+    if (bit_depth == 16 && Internal::is_little_endian()) {
+        png_set_swap(png_ptr);
+    }
 
-    // im.copyToHost(); // in case the image is on the gpu
+    // write data, a row at a time
+    if (!check(!setjmp(png_jmpbuf(png_ptr)), "[write_png_file] Error during writing bytes")) return false;
 
-    int c_stride = (im.channels() == 1) ? 0 : im.stride(2);
+    std::vector<uint8_t> row(png_get_rowbytes(png_ptr, info_ptr));
+    int channels = im.channels();
+    int x_stride = im.stride(0);
+    int c_stride = (channels == 1) ? 0 : im.stride(2);
     typename ImageType::ElemType *srcPtr = (typename ImageType::ElemType*)im.data();
 
     for (int y = 0; y < im.height(); y++) {
-        uint8_t *dstPtr = (uint8_t *)(row_pointers.p[y]);
+        const typename ImageType::ElemType *src = srcPtr + y * im.stride(1);
         if (bit_depth == 16) {
-            // convert to uint16_t
-            for (int x = 0; x < im.width(); x++) {
-                for (int c = 0; c < im.channels(); c++) {
-                    uint16_t out;
-                    Internal::convert(srcPtr[c*c_stride], out);
-                    *dstPtr++ = out >> 8;
-                    *dstPtr++ = out & 0xff;
-                }
-                srcPtr++;
-            }
-        } else if (bit_depth == 8) {
-            // convert to uint8_t
-            for (int x = 0; x < im.width(); x++) {
-                for (int c = 0; c < im.channels(); c++) {
-                    uint8_t out;
-                    Internal::convert(srcPtr[c*c_stride], out);
-                    *dstPtr++ = out;
-                }
-                srcPtr++;
-            }
+            Internal::convert_row_interleaved(src, x_stride, c_stride, im.width(), channels,
+                                              (uint16_t *)row.data(), channels);
         } else {
-            if (!check(bit_depth == 8 || bit_depth == 16, "We only support saving 8- and 16-bit images.")) return false;
+            Internal::convert_row_interleaved(src, x_stride, c_stride, im.width(), channels,
+                                              row.data(), channels);
         }
+        png_write_row(png_ptr, row.data());
     }
 
-    // write data
-    if (!check(!setjmp(png_jmpbuf(png_ptr)), "[write_png_file] Error during writing bytes")) return false;
-
-    png_write_image(png_ptr, row_pointers.p);
-
     // finish write
     if (!check(!setjmp(png_jmpbuf(png_ptr)), "[write_png_file] Error during end of write")) return false;
 
@@ -314,59 +531,10 @@ bool save_png(ImageType &im, const std::string &filename) {
 
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
 bool load_ppm(const std::string &filename, ImageType *im) {
-
-    /* open file and test for it being a ppm */
-    Internal::FileOpener f(filename.c_str(), "rb");
-    if (!check(f.f != nullptr, "File %s could not be opened for reading\n", filename.c_str())) return false;
-
-    int width, height, maxval;
-    char header[256];
-    if (!check(fscanf(f.f, "%255s", header) == 1, "Could not read PPM header\n")) return false;
-    if (!check(fscanf(f.f, "%d %d\n", &width, &height) == 2, "Could not read PPM width and height\n")) return false;
-    if (!check(fscanf(f.f, "%d", &maxval) == 1, "Could not read PPM max value\n")) return false;
-    if (!check(fgetc(f.f) != EOF, "Could not read char from PPM\n")) return false;
-
-    int bit_depth = 0;
-    if (maxval == 255) { bit_depth = 8; }
-    else if (maxval == 65535) { bit_depth = 16; }
-    else { if (!check(false, "Invalid bit depth in PPM\n")) return false; }
-
-    if (!check(header == std::string("P6") || header == std::string("p6"), "Input is not binary PPM\n")) return false;
-
-    int channels = 3;
-    *im = ImageType(width, height, channels);
-
-    // convert the data to ImageType::ElemType
-    if (bit_depth == 8) {
-        std::vector<uint8_t> data(width*height*3);
-        if (!check(fread((void *) data.data(), sizeof(uint8_t), width*height*3, f.f) == (size_t) (width*height*3), "Could not read PPM 8-bit data\n")) return false;
-        typename ImageType::ElemType *im_data = (typename ImageType::ElemType*) im->data();
-        for (int y = 0; y < im->height(); y++) {
-            uint8_t *row = &data[(y*width)*3];
-            for (int x = 0; x < im->width(); x++) {
-                Internal::convert(*row++, im_data[(0*height+y)*width+x]);
-                Internal::convert(*row++, im_data[(1*height+y)*width+x]);
-                Internal::convert(*row++, im_data[(2*height+y)*width+x]);
-            }
-        }
-    } else if (bit_depth == 16) {
-        int little_endian = Internal::is_little_endian();
-        std::vector<uint16_t> data(width*height*3);
-        if (!check(fread((void *) data.data(), sizeof(uint16_t), width*height*3, f.f) == (size_t) (width*height*3), "Could not read PPM 16-bit data\n")) return false;
-        typename ImageType::ElemType *im_data = (typename ImageType::ElemType*) im->data();
-        for (int y = 0; y < im->height(); y++) {
-            uint16_t *row = &data[(y*width)*3];
-            for (int x = 0; x < im->width(); x++) {
-                uint16_t value;
-                value = *row++; Internal::swap_endian_16(little_endian, value); Internal::convert(value, im_data[(0*height+y)*width+x]);
-                value = *row++; Internal::swap_endian_16(little_endian, value); Internal::convert(value, im_data[(1*height+y)*width+x]);
-                value = *row++; Internal::swap_endian_16(little_endian, value); Internal::convert(value, im_data[(2*height+y)*width+x]);
-            }
-        }
-    }
-    (*im)(0,0,0) = (*im)(0,0,0);      /* Mark dirty inside read/write functions. */
-
-    return true;
+    ImageReader<ImageType, check> reader;
+    if (!reader.open_ppm(filename)) return false;
+    *im = reader.allocate(reader.height());
+    return reader.read_rows(*im);
 }
 
 // "im" is not const-ref because copy_to_host() is not const.
@@ -374,39 +542,37 @@ template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
 bool save_ppm(ImageType &im, const std::string &filename) {
     im.copy_to_host();
 
-	unsigned int bit_depth = sizeof(typename ImageType::ElemType) == 1 ? 8: 16;
+    unsigned int bit_depth = sizeof(typename ImageType::ElemType) == 1 ? 8: 16;
 
     Internal::FileOpener f(filename.c_str(), "wb");
     if (!check(f.f != nullptr, "File %s could not be opened for writing\n", filename.c_str())) return false;
     fprintf(f.f, "P6\n%d %d\n%d\n", im.width(), im.height(), (1<<bit_depth)-1);
-    int width = im.width(), height = im.height();
+    int width = im.width();
+
+    // Channels past the third are dropped, and missing ones are zero.
+    int channels = std::min(im.channels(), 3);
+    int x_stride = im.stride(0);
+    int c_stride = (channels == 1) ? 0 : im.stride(2);
+    const typename ImageType::ElemType *srcPtr = (typename ImageType::ElemType*)im.data();
 
     if (bit_depth == 8) {
-        std::vector<uint8_t> data(width*height*3);
+        std::vector<uint8_t> row(width*3);
         for (int y = 0; y < im.height(); y++) {
-            for (int x = 0; x < im.width(); x++) {
-                uint8_t *p = &data[(y*width+x)*3];
-                for (int c = 0; c < im.channels(); c++) {
-                    Internal::convert(im(x, y, c), p[c]);
-                }
-            }
+            Internal::convert_row_interleaved(srcPtr + y * im.stride(1), x_stride, c_stride,
+                                              width, channels, row.data(), 3);
+            if (!check(fwrite((void *) row.data(), sizeof(uint8_t), width*3, f.f) == (size_t) (width*3), "Could not write PPM 8-bit data\n")) return false;
         }
-        if (!check(fwrite((void *) data.data(), sizeof(uint8_t), width*height*3, f.f) == (size_t) (width*height*3), "Could not write PPM 8-bit data\n")) return false;
     } else if (bit_depth == 16) {
         int little_endian = Internal::is_little_endian();
-        std::vector<uint16_t> data(width*height*3);
+        std::vector<uint16_t> row(width*3);
         for (int y = 0; y < im.height(); y++) {
-            for (int x = 0; x < im.width(); x++) {
-                uint16_t *p = &data[(y*width+x)*3];
-                for (int c = 0; c < im.channels(); c++) {
-                    uint16_t value;
-                    Internal::convert(im(x, y, c), value);
-                    Internal::swap_endian_16(little_endian, value);
-                    p[c] = value;
-                }
+            Internal::convert_row_interleaved(srcPtr + y * im.stride(1), x_stride, c_stride,
+                                              width, channels, row.data(), 3);
+            for (int i = 0; i < width*3; i++) {
+                Internal::swap_endian_16(little_endian, row[i]);
             }
+            if (!check(fwrite((void *) row.data(), sizeof(uint16_t), width*3, f.f) == (size_t) (width*3), "Could not write PPM 16-bit data\n")) return false;
         }
-        if (!check(fwrite((void *) data.data(), sizeof(uint16_t), width*height*3, f.f) == (size_t) (width*height*3), "Could not write PPM 16-bit data\n")) return false;
     } else {
         return check(false, "We only support saving 8- and 16-bit images.");
     }
@@ -437,6 +603,61 @@ bool save(ImageType &im, const std::string &filename) {
     }
 }
 
+// Decode a PNG or PPM file in strips of strip_height rows (the last one
+// may be shorter), calling callback(strip) on each strip from the top
+// of the image down. Each strip's min y coordinate is set to the row of
+// the file it starts at, so it can be passed to a pipeline written in
+// terms of whole-image coordinates. The next strip is decoded on a
+// single background thread, reused for every strip, while the callback
+// runs on the current one. The strip images are reused, so the callback
+// should copy out anything it needs to keep. If the callback returns
+// false, no more strips are decoded.
+//
+// Returns false upon failure, or if the callback stopped early.
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn, typename Callback>
+bool load_strips(const std::string &filename, int strip_height, Callback callback) {
+    ImageReader<ImageType, check> reader;
+    if (!reader.open(filename)) return false;
+    if (!check(strip_height > 0, "[load_strips] strip_height must be positive\n")) return false;
+
+    ImageType strips[2];
+    int strip_rows[2] = {0, 0};
+    bool decoded[2] = {false, false};
+    auto decode = [&](int i) {
+        int y = reader.rows_read();
+        int rows = std::min(strip_height, reader.height() - y);
+        if (rows != strip_rows[i]) {
+            strips[i] = reader.allocate(rows);
+            strip_rows[i] = rows;
+        }
+        strips[i].set_min(0, y);
+        decoded[i] = reader.read_rows(strips[i]);
+    };
+
+    int current = 0;
+    decode(current);
+    // Only start a thread if there is more than one strip.
+    std::unique_ptr<Internal::BackgroundWorker> decoder;
+    if (decoded[current] && reader.rows_read() < reader.height()) {
+        decoder.reset(new Internal::BackgroundWorker);
+    }
+    while (decoded[current]) {
+        bool last = reader.rows_read() == reader.height();
+        int next = 1 - current;
+        if (!last) {
+            decoder->start([&decode, next]() { decode(next); });
+        }
+        bool keep_going = callback(strips[current]);
+        if (!last) {
+            decoder->wait();
+        }
+        if (!keep_going) return false;
+        if (last) return true;
+        current = 1 - current;
+    }
+    return false;
+}
+
 // Fancy wrapper to call load() with CheckFail, inferring the return type;
 // this allows you to simply use
 //
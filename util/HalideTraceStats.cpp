@@ -0,0 +1,726 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <io.h>
+typedef int64_t ssize_t;
+#endif
+#include <fcntl.h>
+#ifndef _MSC_VER
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using std::map;
+using std::vector;
+using std::string;
+using std::unordered_map;
+using std::unordered_set;
+
+// The first 48 bytes of a tracing packet are metadata
+const int packet_header_size = 48;
+
+// The metadata at the start of a single Halide tracing packet. The
+// payload follows it directly in the trace.
+struct PacketHeader {
+    uint32_t id, parent;
+    uint8_t event, type, bits, width, value_idx, num_int_args;
+    char name[packet_header_size - 14];
+};
+
+// A view of a packet inside the trace. Nothing is copied.
+struct Packet {
+    const PacketHeader *header;
+    const uint8_t *payload;
+
+    size_t bytes_per_elem() const {
+        size_t bytes = 1;
+        while (bytes*8 < header->bits) bytes <<= 1;
+        return bytes;
+    }
+
+    size_t value_bytes() const {
+        return bytes_per_elem() * header->width;
+    }
+
+    size_t payload_bytes() const {
+        return value_bytes() + sizeof(int) * header->num_int_args;
+    }
+
+    int get_int_arg(int idx) const {
+        // The int args aren't necessarily aligned.
+        int result;
+        memcpy(&result, payload + value_bytes() + idx * sizeof(int), sizeof(int));
+        return result;
+    }
+
+    // The number of coordinates per lane of a load or store.
+    int dimensions() const {
+        return header->num_int_args / header->width;
+    }
+};
+
+// The whole trace, memory-mapped so that it can be read twice
+// without holding it in memory. A trace from stdin or a pipe is
+// first copied to a temporary file. (On Windows it is read into
+// memory instead, so it must fit.)
+class Trace {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+#ifdef _MSC_VER
+    vector<uint8_t> storage;
+#endif
+    bool mapped = false;
+
+public:
+    bool load(const char *path) {
+        if (path == nullptr || strcmp(path, "-") == 0) {
+#ifdef _MSC_VER
+            return read_all(0);
+#else
+            return spool_and_map(0);
+#endif
+        }
+#ifdef _MSC_VER
+        int fd = _open(path, _O_RDONLY | _O_BINARY);
+        if (fd < 0) {
+            perror(path);
+            return false;
+        }
+        bool ok = read_all(fd);
+        _close(fd);
+        return ok;
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            perror(path);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && map(fd, st.st_size)) {
+            close(fd);
+            return true;
+        }
+        // Not a regular file (e.g. a pipe), so copy it somewhere that
+        // can be mapped.
+        bool ok = spool_and_map(fd);
+        close(fd);
+        return ok;
+#endif
+    }
+
+    ~Trace() {
+#ifndef _MSC_VER
+        if (mapped) {
+            munmap((void *)data, size);
+        }
+#endif
+    }
+
+    // Calls f on each packet in order. Returns false if the trace
+    // ends mid-packet.
+    template<typename F>
+    bool for_each_packet(F f) const {
+        size_t pos = 0;
+        while (pos + packet_header_size <= size) {
+            Packet p;
+            p.header = (const PacketHeader *)(data + pos);
+            p.payload = data + pos + packet_header_size;
+            size_t end = pos + packet_header_size + p.payload_bytes();
+            if (end > size) {
+                fprintf(stderr, "Unexpected end of trace mid-packet\n");
+                return false;
+            }
+            f(p);
+            pos = end;
+        }
+        if (pos != size) {
+            fprintf(stderr, "Unexpected end of trace mid-packet\n");
+            return false;
+        }
+        return true;
+    }
+
+private:
+#ifndef _MSC_VER
+    bool map(int fd, size_t bytes) {
+        void *m = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) {
+            return false;
+        }
+        madvise(m, bytes, MADV_SEQUENTIAL);
+        data = (const uint8_t *)m;
+        size = bytes;
+        mapped = true;
+        return true;
+    }
+
+    // Copy everything readable from fd to an anonymous temporary file,
+    // and map that.
+    bool spool_and_map(int fd) {
+        FILE *tmp = tmpfile();
+        if (tmp == nullptr) {
+            perror("Failed to create a temporary file");
+            return false;
+        }
+        vector<uint8_t> chunk(1 << 20);
+        size_t total = 0;
+        for (;;) {
+            ssize_t s = read(fd, chunk.data(), chunk.size());
+            if (s < 0) {
+                perror("Failed during read");
+                fclose(tmp);
+                return false;
+            } else if (s == 0) {
+                break;
+            }
+            if (fwrite(chunk.data(), 1, s, tmp) != (size_t)s) {
+                perror("Failed to write a temporary file");
+                fclose(tmp);
+                return false;
+            }
+            total += s;
+        }
+        // The mapping outlives the file, which is deleted on close.
+        bool ok = fflush(tmp) == 0 && (total == 0 || map(fileno(tmp), total));
+        if (!ok) {
+            perror("Failed to map a temporary file");
+        }
+        fclose(tmp);
+        return ok;
+    }
+#else
+    bool read_all(int fd) {
+        const size_t chunk = 1 << 20;
+        size_t used = 0;
+        for (;;) {
+            storage.resize(used + chunk);
+            ssize_t s = read(fd, storage.data() + used, chunk);
+            if (s < 0) {
+                perror("Failed during read");
+                return false;
+            } else if (s == 0) {
+                break;
+            }
+            used += s;
+        }
+        storage.resize(used);
+        data = storage.data();
+        size = used;
+        return true;
+    }
+#endif
+};
+
+// A set-associative cache with LRU replacement.
+class CacheModel {
+    int line_bits = 0, set_bits = 0;
+    int assoc = 0;
+    vector<uint64_t> tags, last_used;
+    uint64_t clock = 0;
+
+public:
+    int size = 0, line_size = 0, associativity = 0;
+
+    CacheModel(int s, int l, int a) : size(s), line_size(l), associativity(a) {}
+
+    bool valid() const {
+        // The line size and number of sets must be powers of two.
+        if (size <= 0 || line_size <= 0 || associativity <= 0) return false;
+        if (line_size & (line_size - 1)) return false;
+        if (size % (line_size * associativity)) return false;
+        int sets = size / (line_size * associativity);
+        return (sets & (sets - 1)) == 0;
+    }
+
+    void init() {
+        while ((1 << line_bits) < line_size) line_bits++;
+        int sets = size / (line_size * associativity);
+        while ((1 << set_bits) < sets) set_bits++;
+        assoc = associativity;
+        // Zero marks an empty way, so tags are stored off by one.
+        tags.assign(sets * assoc, 0);
+        last_used.assign(sets * assoc, 0);
+    }
+
+    // Touch the line containing addr. Returns true on a hit.
+    bool access(uint64_t addr) {
+        clock++;
+        uint64_t line = addr >> line_bits;
+        uint64_t set = line & ((1 << set_bits) - 1);
+        uint64_t tag = line + 1;
+        uint64_t *t = &tags[set * assoc];
+        uint64_t *u = &last_used[set * assoc];
+        int victim = 0;
+        for (int i = 0; i < assoc; i++) {
+            if (t[i] == tag) {
+                u[i] = clock;
+                return true;
+            }
+            if (u[i] < u[victim]) victim = i;
+        }
+        t[victim] = tag;
+        u[victim] = clock;
+        return false;
+    }
+};
+
+// Counts the distinct lines touched between two accesses to the same
+// line, using a Fenwick tree over time in which only the most recent
+// access to each line is set.
+class ReuseDistance {
+    vector<int> tree;
+    unordered_map<uint64_t, uint64_t> last_access;
+    uint64_t clock = 0;
+
+    void add(uint64_t i, int v) {
+        for (i++; i < tree.size(); i += i & (~i + 1)) tree[i] += v;
+    }
+
+    int64_t prefix(uint64_t i) const {
+        int64_t sum = 0;
+        for (; i > 0; i -= i & (~i + 1)) sum += tree[i];
+        return sum;
+    }
+
+public:
+    void init(uint64_t num_accesses) {
+        tree.assign(num_accesses + 1, 0);
+    }
+
+    // Returns -1 for the first access to a line.
+    int64_t access(uint64_t line) {
+        int64_t distance = -1;
+        auto it = last_access.find(line);
+        if (it != last_access.end()) {
+            distance = prefix(clock) - prefix(it->second + 1);
+            add(it->second, -1);
+            it->second = clock;
+        } else {
+            last_access[line] = clock;
+        }
+        add(clock, 1);
+        clock++;
+        return distance;
+    }
+};
+
+const int reuse_bins = 24;
+
+// Everything we learn about a single Func or input image.
+struct FuncStats {
+    string qualified_name;
+    uint64_t first_packet_idx = 0;
+
+    // Counts of values (lanes), not packets.
+    uint64_t loads = 0, stores = 0;
+    int num_realizations = 0, num_productions = 0;
+
+    // Every site stored to, to detect recomputation.
+    unordered_set<uint64_t> sites;
+
+    // Allocated bytes of each realization.
+    uint64_t total_footprint = 0, max_footprint = 0;
+
+    // The bounding box of all accesses. Used to lay out buffers we
+    // never see realized (inputs and outputs).
+    int dims = 0;
+    int min_coord[16], max_coord[16];
+    size_t bytes_per_elem = 0;
+    int tuple_size = 1;
+
+    // Reuse distance in cache lines, binned by powers of two. Cold
+    // accesses are counted separately.
+    uint64_t reuse[reuse_bins];
+    uint64_t cold = 0;
+
+    uint64_t l1_misses = 0, l2_misses = 0;
+
+    FuncStats() {
+        memset(min_coord, 0, sizeof(min_coord));
+        memset(max_coord, 0, sizeof(max_coord));
+        memset(reuse, 0, sizeof(reuse));
+    }
+
+    void observe_bounds(const Packet &p) {
+        int d = std::min(16, p.dimensions());
+        for (int i = 0; i < d; i++) {
+            if (dims <= i) {
+                // The first access with this many dimensions.
+                min_coord[i] = p.get_int_arg(i*p.header->width);
+                max_coord[i] = min_coord[i] + 1;
+                dims = i + 1;
+            }
+            for (int lane = 0; lane < p.header->width; lane++) {
+                int coord = p.get_int_arg(i*p.header->width + lane);
+                min_coord[i] = std::min(min_coord[i], coord);
+                max_coord[i] = std::max(max_coord[i], coord + 1);
+            }
+        }
+        bytes_per_elem = std::max(bytes_per_elem, p.bytes_per_elem());
+        tuple_size = std::max(tuple_size, p.header->value_idx + 1);
+    }
+};
+
+// Where the values of one realization of a Func live in our
+// synthetic address space.
+struct Layout {
+    uint64_t base = 0;
+    size_t bytes_per_elem = 0;
+    int dims = 0;
+    int min[16];
+    int64_t stride[16];
+    uint64_t elems = 0;
+
+    uint64_t address(const Packet &p, int lane) const {
+        int64_t offset = 0;
+        int d = std::min(dims, p.dimensions());
+        for (int i = 0; i < d; i++) {
+            offset += (int64_t)(p.get_int_arg(i*p.header->width + lane) - min[i]) * stride[i];
+        }
+        // Tuple elements are stored as separate buffers.
+        offset += (int64_t)p.header->value_idx * elems;
+        return base + offset * bytes_per_elem;
+    }
+};
+
+uint64_t hash_site(const Packet &p, int lane) {
+    // FNV-1a over the value index and coordinates.
+    uint64_t h = 14695981039346656037ULL;
+    h = (h ^ p.header->value_idx) * 1099511628211ULL;
+    for (int i = 0; i < p.dimensions(); i++) {
+        uint32_t c = p.get_int_arg(i*p.header->width + lane);
+        for (int b = 0; b < 4; b++) {
+            h = (h ^ ((c >> (b*8)) & 0xff)) * 1099511628211ULL;
+        }
+    }
+    return h;
+}
+
+void usage() {
+    fprintf(stderr,
+            "\n"
+            "HalideTraceStats reads Halide-generated binary tracing packets and\n"
+            "prints statistics about how each Func is accessed, along with the\n"
+            "misses predicted by a simple model of the cache hierarchy.\n"
+            "\n"
+            "E.g.:\n"
+            " HL_TRACE=3 <command to make pipeline> && \\\n"
+            " HL_TRACE_FILE=trace.bin <command to run pipeline> && \\\n"
+            " HalideTraceStats trace.bin\n"
+            "\n"
+            "If no file is given, or the file is -, the trace is read from stdin.\n"
+            "The trace is read twice, so a trace from stdin or a pipe is first\n"
+            "copied to a temporary file, which needs room for it.\n"
+            "Use HL_TRACE=3 so that loads are traced as well as stores.\n"
+            "\n"
+            "The arguments to HalideTraceStats are: \n"
+            " -l1 size line_size associativity: The L1 data cache to model, in\n"
+            "    bytes. Defaults to 32768 64 8.\n"
+            " -l2 size line_size associativity: The L2 cache to model, in\n"
+            "    bytes. Defaults to 262144 64 8.\n"
+            "\n"
+            "For each Func the output reports:\n"
+            "  loads, stores: The number of values loaded from and stored to it.\n"
+            "\n"
+            "  recompute: Stores per distinct site stored to. 1.0 means every\n"
+            "    value was computed once. Higher values come from recomputation\n"
+            "    across realizations or from update definitions.\n"
+            "\n"
+            "  footprint: The mean and largest allocation of a realization.\n"
+            "\n"
+            "  L1/L2 misses: Misses on accesses to the Func in the modelled\n"
+            "    caches. Each realization is laid out densely in its own address\n"
+            "    range, so these reflect the schedule and not the allocator.\n"
+            "\n"
+            "  reuse distance: How many distinct cache lines were touched\n"
+            "    between consecutive accesses to the same line.\n"
+        );
+}
+
+int run(int argc, char **argv) {
+    static_assert(sizeof(PacketHeader) == packet_header_size, "");
+
+    CacheModel l1(32 * 1024, 64, 8), l2(256 * 1024, 64, 8);
+    const char *path = nullptr;
+
+    // Parse command line args
+    int i = 1;
+    while (i < argc) {
+        string next = argv[i];
+        if (next == "-l1" || next == "-l2") {
+            if (i + 3 >= argc) {
+                usage();
+                return -1;
+            }
+            CacheModel &c = (next == "-l1") ? l1 : l2;
+            c.size = atoi(argv[++i]);
+            c.line_size = atoi(argv[++i]);
+            c.associativity = atoi(argv[++i]);
+        } else if (next[0] == '-' && next != "-") {
+            usage();
+            return -1;
+        } else if (path) {
+            usage();
+            return -1;
+        } else {
+            path = argv[i];
+        }
+        i++;
+    }
+
+    if (!l1.valid() || !l2.valid()) {
+        fprintf(stderr, "Cache sizes must be a power-of-two number of sets of power-of-two lines\n");
+        return -1;
+    }
+    l1.init();
+    l2.init();
+
+    Trace trace;
+    if (!trace.load(path)) {
+        return -1;
+    }
+
+    map<string, FuncStats> funcs;
+
+    // Maps the ids of begin pipeline, begin realization and produce
+    // events to the name of the enclosing pipeline, so that Funcs with
+    // the same name in different pipelines stay separate.
+    unordered_map<uint32_t, string> pipeline_of;
+
+    auto qualified_name = [&](const Packet &p) {
+        string pipeline;
+        if (p.header->event == 8) {
+            pipeline = p.header->name;
+        } else {
+            auto it = pipeline_of.find(p.header->parent);
+            if (it != pipeline_of.end()) pipeline = it->second;
+        }
+        return pipeline + ":" + p.header->name;
+    };
+
+    auto track_pipeline = [&](const Packet &p) {
+        switch (p.header->event) {
+        case 0: case 1:
+            break;
+        case 8: // begin pipeline
+            pipeline_of[p.header->id] = p.header->name;
+            break;
+        default:
+            if (p.header->id) {
+                pipeline_of[p.header->id] = pipeline_of[p.header->parent];
+            }
+        }
+    };
+
+    // The first pass finds the bounds of every buffer accessed, and
+    // how many accesses there are in total.
+    uint64_t num_accesses = 0, packet_idx = 0;
+    bool ok = trace.for_each_packet([&](const Packet &p) {
+            track_pipeline(p);
+            if (p.header->event > 1) return;
+            FuncStats &fs = funcs[qualified_name(p)];
+            if (fs.qualified_name.empty()) {
+                fs.qualified_name = qualified_name(p);
+                fs.first_packet_idx = packet_idx;
+            }
+            fs.observe_bounds(p);
+            num_accesses += p.header->width;
+            packet_idx++;
+        });
+    if (!ok) return -1;
+
+    // Lay out the buffers that are never realized inside the
+    // pipeline. Everything is page-aligned in one address space.
+    uint64_t next_base = 4096;
+    auto make_layout = [&](int dims, const int *min, const int *extent,
+                           size_t bytes_per_elem, int tuple_size) {
+        Layout l;
+        l.dims = std::min(dims, 16);
+        l.bytes_per_elem = std::max<size_t>(bytes_per_elem, 1);
+        l.elems = 1;
+        for (int d = 0; d < l.dims; d++) {
+            l.min[d] = min[d];
+            l.stride[d] = l.elems;
+            l.elems *= std::max(extent[d], 1);
+        }
+        l.base = next_base;
+        uint64_t bytes = l.elems * l.bytes_per_elem * std::max(tuple_size, 1);
+        next_base += (bytes + 4095) & ~(uint64_t)4095;
+        return l;
+    };
+
+    map<string, Layout> external;
+    for (auto &f : funcs) {
+        FuncStats &fs = f.second;
+        int extent[16];
+        for (int d = 0; d < fs.dims; d++) {
+            extent[d] = fs.max_coord[d] - fs.min_coord[d];
+        }
+        external[f.first] = make_layout(fs.dims, fs.min_coord, extent, fs.bytes_per_elem, fs.tuple_size);
+    }
+
+    // Realizations currently live, by qualified name. A stack handles
+    // recursive realizations of the same name.
+    map<string, vector<Layout> > live;
+
+    ReuseDistance reuse;
+    reuse.init(num_accesses);
+    int line_bits = 0;
+    while ((1 << line_bits) < l1.line_size) line_bits++;
+
+    // The second pass runs the cache model and gathers everything else.
+    pipeline_of.clear();
+    ok = trace.for_each_packet([&](const Packet &p) {
+            track_pipeline(p);
+            const PacketHeader &h = *p.header;
+            if (h.event == 8 || h.event == 9) return;
+            string name = qualified_name(p);
+            FuncStats &fs = funcs[name];
+            if (fs.qualified_name.empty()) {
+                fs.qualified_name = name;
+                fs.first_packet_idx = packet_idx++;
+            }
+
+            switch (h.event) {
+            case 0: // load
+            case 1: { // store
+                auto it = live.find(name);
+                const Layout &layout = (it != live.end() && !it->second.empty()) ?
+                    it->second.back() : external[name];
+                for (int lane = 0; lane < h.width; lane++) {
+                    uint64_t addr = layout.address(p, lane);
+                    int64_t distance = reuse.access(addr >> line_bits);
+                    if (distance < 0) {
+                        fs.cold++;
+                    } else {
+                        int bin = 0;
+                        while (bin < reuse_bins - 1 && ((uint64_t)1 << bin) <= (uint64_t)distance) bin++;
+                        fs.reuse[bin]++;
+                    }
+                    if (!l1.access(addr)) {
+                        fs.l1_misses++;
+                        if (!l2.access(addr)) {
+                            fs.l2_misses++;
+                        }
+                    }
+                    if (h.event == 1) {
+                        fs.sites.insert(hash_site(p, lane));
+                    }
+                }
+                if (h.event == 0) {
+                    fs.loads += h.width;
+                } else {
+                    fs.stores += h.width;
+                }
+                break;
+            }
+            case 2: { // begin realization
+                fs.num_realizations++;
+                int dims = h.num_int_args / 2;
+                int min[16], extent[16];
+                for (int d = 0; d < std::min(dims, 16); d++) {
+                    min[d] = p.get_int_arg(d * 2 + 0);
+                    extent[d] = p.get_int_arg(d * 2 + 1);
+                }
+                size_t bytes_per_elem = fs.bytes_per_elem ? fs.bytes_per_elem : 4;
+                Layout l = make_layout(dims, min, extent, bytes_per_elem, fs.tuple_size);
+                uint64_t bytes = l.elems * l.bytes_per_elem * fs.tuple_size;
+                fs.total_footprint += bytes;
+                fs.max_footprint = std::max(fs.max_footprint, bytes);
+                live[name].push_back(l);
+                break;
+            }
+            case 3: // end realization
+                if (!live[name].empty()) {
+                    live[name].pop_back();
+                }
+                break;
+            case 4: // produce
+                fs.num_productions++;
+                break;
+            case 5: // update
+            case 6: // consume
+            case 7: // end consume
+                break;
+            default:
+                fprintf(stderr, "Unknown tracing event code: %d\n", h.event);
+                exit(-1);
+            }
+        });
+    if (!ok) return -1;
+
+    vector<const FuncStats *> sorted;
+    for (const auto &f : funcs) {
+        sorted.push_back(&f.second);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const FuncStats *a, const FuncStats *b) {
+            return a->first_packet_idx < b->first_packet_idx;
+        });
+
+    printf("L1: %d bytes, %d byte lines, %d-way\n", l1.size, l1.line_size, l1.associativity);
+    printf("L2: %d bytes, %d byte lines, %d-way\n\n", l2.size, l2.line_size, l2.associativity);
+
+    printf("%-32s %12s %12s %9s %6s %12s %12s %12s %12s\n",
+           "Func", "loads", "stores", "recompute", "reals",
+           "mean bytes", "max bytes", "L1 misses", "L2 misses");
+    uint64_t total_accesses = 0, total_l1 = 0, total_l2 = 0;
+    for (const FuncStats *fs : sorted) {
+        double recompute = fs->sites.empty() ? 0.0 : (double)fs->stores / fs->sites.size();
+        double mean_footprint = fs->num_realizations ?
+            (double)fs->total_footprint / fs->num_realizations : 0.0;
+        printf("%-32s %12llu %12llu %9.2f %6d %12.0f %12llu %12llu %12llu\n",
+               fs->qualified_name.c_str(),
+               (unsigned long long)fs->loads,
+               (unsigned long long)fs->stores,
+               recompute,
+               fs->num_realizations,
+               mean_footprint,
+               (unsigned long long)fs->max_footprint,
+               (unsigned long long)fs->l1_misses,
+               (unsigned long long)fs->l2_misses);
+        total_accesses += fs->loads + fs->stores;
+        total_l1 += fs->l1_misses;
+        total_l2 += fs->l2_misses;
+    }
+    printf("\nTotal accesses: %llu, L1 miss rate: %.2f%%, L2 miss rate: %.2f%%\n",
+           (unsigned long long)total_accesses,
+           total_accesses ? 100.0 * total_l1 / total_accesses : 0.0,
+           total_accesses ? 100.0 * total_l2 / total_accesses : 0.0);
+
+    printf("\nReuse distance in %d byte lines:\n", l1.line_size);
+    for (const FuncStats *fs : sorted) {
+        if (fs->loads + fs->stores == 0) continue;
+        printf("%s:\n  cold: %llu\n", fs->qualified_name.c_str(), (unsigned long long)fs->cold);
+        for (int b = 0; b < reuse_bins; b++) {
+            if (fs->reuse[b] == 0) continue;
+            uint64_t lo = b ? ((uint64_t)1 << (b - 1)) : 0;
+            if (b == reuse_bins - 1) {
+                printf("  >= %llu: %llu\n", (unsigned long long)lo, (unsigned long long)fs->reuse[b]);
+            } else {
+                uint64_t hi = ((uint64_t)1 << b) - 1;
+                printf("  [%llu, %llu]: %llu\n", (unsigned long long)lo,
+                       (unsigned long long)hi, (unsigned long long)fs->reuse[b]);
+            }
+        }
+    }
+
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    return run(argc, argv);
+}